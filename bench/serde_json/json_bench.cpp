@@ -0,0 +1,354 @@
+#include <serde_json/json.hpp>
+#include <serde_json/parallel.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <benchmark/benchmark.h>
+
+// Count every allocation, so each benchmark can report how many it does per operation.
+// GCC sees free() on what operator new returns after inlining, which is fine as both sides are replaced here.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+  std::atomic<std::size_t> allocations{0};
+}
+
+void *operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size == 0 ? 1 : size))
+  {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+  using kie::serde::Field;
+
+  // A flat struct like a telemetry record, with a bit of everything.
+  struct Flat
+  {
+    Field<std::int64_t, "id"> id;
+    Field<std::string, "name"> name;
+    Field<std::string, "description"> description;
+    Field<double, "latitude"> latitude;
+    Field<double, "longitude"> longitude;
+    Field<double, "temperature"> temperature;
+    Field<float, "ratio"> ratio;
+    Field<int, "count"> count;
+    Field<bool, "active"> active;
+    Field<std::vector<int>, "samples"> samples;
+  };
+
+  // A tree of fixed depth, the fan-out decides whether it's a chain or a bushy tree.
+  template <int Depth>
+  struct Node
+  {
+    Field<int, "id"> id;
+    Field<std::string, "label"> label;
+    Field<std::vector<Node<Depth - 1>>, "children"> children;
+  };
+
+  template <>
+  struct Node<0>
+  {
+    Field<int, "id"> id;
+    Field<std::string, "label"> label;
+  };
+
+  using Tree = Node<6>;
+
+  // A struct holding one large array, like a batch response.
+  struct Batch
+  {
+    Field<std::string, "cursor"> cursor;
+    Field<std::vector<Flat>, "records"> records;
+  };
+
+  Flat make_flat(std::int64_t i)
+  {
+    Flat flat;
+    flat.id = i;
+    flat.name = "record-" + std::to_string(i);
+    flat.description = std::string{"a plain description with \"quotes\" and some length "} + std::to_string(i * 7919);
+    flat.latitude = 31.2304 + static_cast<double>(i) * 1e-4;
+    flat.longitude = 121.4737 - static_cast<double>(i) * 1e-4;
+    flat.temperature = 20.5 + static_cast<double>(i % 100) / 7.0;
+    flat.ratio = static_cast<float>(i % 13) / 13.0f;
+    flat.count = static_cast<int>(i % 1000);
+    flat.active = i % 2 == 0;
+    flat.samples = std::vector<int>{1, 2, 3, static_cast<int>(i)};
+    return flat;
+  }
+
+  template <int Depth>
+  Node<Depth> make_node(int fan_out, int &next_id)
+  {
+    Node<Depth> node;
+    node.id = next_id++;
+    node.label = "node-" + std::to_string(node.id.value);
+    if constexpr (Depth > 0)
+    {
+      std::vector<Node<Depth - 1>> children;
+      for (int i = 0; i < fan_out; i++)
+      {
+        children.push_back(make_node<Depth - 1>(fan_out, next_id));
+      }
+      node.children = std::move(children);
+    }
+    return node;
+  }
+
+  // Every case makes a value from the benchmark argument, and lists the arguments to run with.
+  struct FlatCase
+  {
+    using type = Flat;
+    static type make(std::int64_t) { return make_flat(42); }
+    static void args(benchmark::internal::Benchmark *b) { b->Arg(1); }
+  };
+
+  struct NestedCase
+  {
+    using type = Tree;
+    static type make(std::int64_t fan_out)
+    {
+      int next_id = 0;
+      return make_node<6>(static_cast<int>(fan_out), next_id);
+    }
+    static void args(benchmark::internal::Benchmark *b) { b->ArgName("fan_out")->Arg(1)->Arg(3); }
+  };
+
+  struct ArrayCase
+  {
+    using type = Batch;
+    static type make(std::int64_t size)
+    {
+      Batch batch;
+      batch.cursor = std::string{"next"};
+      std::vector<Flat> records;
+      for (std::int64_t i = 0; i < size; i++)
+      {
+        records.push_back(make_flat(i));
+      }
+      batch.records = std::move(records);
+      return batch;
+    }
+    static void args(benchmark::internal::Benchmark *b) { b->ArgName("records")->Arg(16)->Arg(1024)->Arg(65536); }
+  };
+
+  struct VectorCase
+  {
+    using type = std::vector<Flat>;
+    static type make(std::int64_t size) { return ArrayCase::make(size).records.value; }
+    static void args(benchmark::internal::Benchmark *b) { b->ArgName("records")->Arg(16)->Arg(1024)->Arg(65536); }
+  };
+
+  /** Run op in the loop, and report the throughput over the json text and the allocations per operation.
+   */
+  template <typename Op>
+  void measure(benchmark::State &state, std::size_t json_size, Op &&op)
+  {
+    const std::size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state)
+    {
+      op();
+    }
+    const std::size_t after = allocations.load(std::memory_order_relaxed);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * json_size));
+    state.counters["allocs_per_op"] = benchmark::Counter(static_cast<double>(after - before), benchmark::Counter::kAvgIterations);
+  }
+
+  template <typename Case>
+  void to_json(benchmark::State &state)
+  {
+    const auto value = Case::make(state.range(0));
+    const std::size_t size = kie::serde_json::to_json(value).dump().size();
+    measure(state, size, [&]
+            {
+      auto j = kie::serde_json::to_json(value);
+      benchmark::DoNotOptimize(j); });
+  }
+
+  template <typename Case>
+  void to_json_dump(benchmark::State &state)
+  {
+    const auto value = Case::make(state.range(0));
+    const std::size_t size = kie::serde_json::to_json(value).dump().size();
+    measure(state, size, [&]
+            {
+      auto str = kie::serde_json::to_json(value).dump();
+      benchmark::DoNotOptimize(str); });
+  }
+
+  template <typename Case>
+  void to_json_string(benchmark::State &state)
+  {
+    const auto value = Case::make(state.range(0));
+    const std::size_t size = kie::serde_json::to_json_string(value).size();
+    measure(state, size, [&]
+            {
+      auto str = kie::serde_json::to_json_string(value);
+      benchmark::DoNotOptimize(str); });
+  }
+
+  // The same as to_json_string, on a pool of all the CPUs.
+  template <typename Case>
+  void to_json_string_parallel(benchmark::State &state)
+  {
+    static boost::asio::thread_pool pool{std::thread::hardware_concurrency()};
+    const auto value = Case::make(state.range(0));
+    const std::size_t size = kie::serde_json::to_json_string(value).size();
+    measure(state, size, [&]
+            {
+      auto str = kie::serde_json::to_json_string(value, pool);
+      benchmark::DoNotOptimize(str); });
+  }
+
+  // The same rows as to_json_string, written column by column.
+  template <typename Case>
+  void to_json_columnar(benchmark::State &state)
+  {
+    const auto value = Case::make(state.range(0));
+    const std::size_t size = kie::serde_json::to_json_columnar(value).size();
+    measure(state, size, [&]
+            {
+      auto str = kie::serde_json::to_json_columnar(value);
+      benchmark::DoNotOptimize(str); });
+  }
+
+  template <typename Case>
+  void from_json(benchmark::State &state)
+  {
+    const std::string json_str = kie::serde_json::to_json_string(Case::make(state.range(0)));
+    measure(state, json_str.size(), [&]
+            {
+      auto value = kie::serde_json::from_json<typename Case::type>(json_str);
+      benchmark::DoNotOptimize(value); });
+  }
+
+  // A document of 200 members like an upstream sends, of which Flat models 10.
+  std::string make_wide()
+  {
+    std::string json_str = kie::serde_json::to_json_string(make_flat(42));
+    json_str.pop_back();
+    for (int i = 0; i < 190; i++)
+    {
+      json_str += ",\"extra_" + std::to_string(i) + "\":";
+      json_str += i % 2 == 0 ? R"({"name":"some \"quoted\" text","values":[1.5,2.5,3.5],"nested":{"flag":true,"note":null}})" : R"("a plain string value of some length")";
+    }
+    json_str += "}";
+    return json_str;
+  }
+
+  // Read the 10 members out of 200, with or without the projection.
+  void from_json_wide(benchmark::State &state)
+  {
+    const std::string json_str = make_wide();
+    const kie::serde_json::read_options options{.projection = state.range(0) != 0};
+    measure(state, json_str.size(), [&]
+            {
+      auto value = kie::serde_json::from_json<Flat>(json_str, options);
+      benchmark::DoNotOptimize(value); });
+  }
+
+  // The same as from_json, but into one value again and again.
+  template <typename Case>
+  void from_json_into(benchmark::State &state)
+  {
+    const std::string json_str = kie::serde_json::to_json_string(Case::make(state.range(0)));
+    typename Case::type value{};
+    measure(state, json_str.size(), [&]
+            {
+      kie::serde_json::from_json_into(value, json_str);
+      benchmark::DoNotOptimize(value); });
+  }
+
+  // The same as from_json, on a pool of all the CPUs.
+  template <typename Case>
+  void from_json_parallel(benchmark::State &state)
+  {
+    static boost::asio::thread_pool pool{std::thread::hardware_concurrency()};
+    const std::string json_str = kie::serde_json::to_json_string(Case::make(state.range(0)));
+    measure(state, json_str.size(), [&]
+            {
+      auto value = kie::serde_json::from_json_parallel<typename Case::type>(json_str, pool);
+      benchmark::DoNotOptimize(value); });
+  }
+
+  // The same rows as from_json, read column by column.
+  template <typename Case>
+  void from_json_columnar(benchmark::State &state)
+  {
+    const std::string json_str = kie::serde_json::to_json_columnar(Case::make(state.range(0)));
+    measure(state, json_str.size(), [&]
+            {
+      auto value = kie::serde_json::from_json_columnar<typename Case::type>(json_str);
+      benchmark::DoNotOptimize(value); });
+  }
+
+  // The way from_json worked before the direct reader, kept as the baseline.
+  template <typename Case>
+  void from_json_dom(benchmark::State &state)
+  {
+    const std::string json_str = kie::serde_json::to_json_string(Case::make(state.range(0)));
+    measure(state, json_str.size(), [&]
+            {
+      auto value = kie::serde_json::impl::from_json<typename Case::type>(nlohmann::json::parse(json_str));
+      benchmark::DoNotOptimize(value); });
+  }
+}
+
+BENCHMARK_TEMPLATE(to_json, FlatCase)->Apply(FlatCase::args);
+BENCHMARK_TEMPLATE(to_json, NestedCase)->Apply(NestedCase::args);
+BENCHMARK_TEMPLATE(to_json, ArrayCase)->Apply(ArrayCase::args);
+
+BENCHMARK_TEMPLATE(to_json_dump, FlatCase)->Apply(FlatCase::args);
+BENCHMARK_TEMPLATE(to_json_dump, NestedCase)->Apply(NestedCase::args);
+BENCHMARK_TEMPLATE(to_json_dump, ArrayCase)->Apply(ArrayCase::args);
+
+BENCHMARK_TEMPLATE(to_json_string, FlatCase)->Apply(FlatCase::args);
+BENCHMARK_TEMPLATE(to_json_string, NestedCase)->Apply(NestedCase::args);
+BENCHMARK_TEMPLATE(to_json_string, ArrayCase)->Apply(ArrayCase::args);
+BENCHMARK_TEMPLATE(to_json_string, VectorCase)->Apply(VectorCase::args);
+
+BENCHMARK_TEMPLATE(to_json_string_parallel, VectorCase)->Apply(VectorCase::args)->UseRealTime();
+
+BENCHMARK_TEMPLATE(to_json_columnar, VectorCase)->Apply(VectorCase::args);
+
+BENCHMARK_TEMPLATE(from_json, FlatCase)->Apply(FlatCase::args);
+BENCHMARK_TEMPLATE(from_json, NestedCase)->Apply(NestedCase::args);
+BENCHMARK_TEMPLATE(from_json, ArrayCase)->Apply(ArrayCase::args);
+BENCHMARK_TEMPLATE(from_json, VectorCase)->Apply(VectorCase::args);
+
+BENCHMARK(from_json_wide)->ArgName("projection")->Arg(0)->Arg(1);
+
+BENCHMARK_TEMPLATE(from_json_into, FlatCase)->Apply(FlatCase::args);
+BENCHMARK_TEMPLATE(from_json_into, NestedCase)->Apply(NestedCase::args);
+BENCHMARK_TEMPLATE(from_json_into, ArrayCase)->Apply(ArrayCase::args);
+
+BENCHMARK_TEMPLATE(from_json_parallel, VectorCase)->Apply(VectorCase::args)->UseRealTime();
+
+BENCHMARK_TEMPLATE(from_json_columnar, VectorCase)->Apply(VectorCase::args);
+
+BENCHMARK_TEMPLATE(from_json_dom, FlatCase)->Apply(FlatCase::args);
+BENCHMARK_TEMPLATE(from_json_dom, NestedCase)->Apply(NestedCase::args);
+BENCHMARK_TEMPLATE(from_json_dom, ArrayCase)->Apply(ArrayCase::args);
+BENCHMARK_TEMPLATE(from_json_dom, VectorCase)->Apply(VectorCase::args);
+
+BENCHMARK_MAIN();
@@ -19,8 +19,10 @@ class KieToolboxConan(ConanFile):
         "shared": [True, False],
         "fPIC": [True, False],
         "enable_test": [True, False],
+        "enable_bench": [True, False],
         "with_serde": [True, False],
         "with_serde_json": [True, False],
+        "with_serde_msgpack": [True, False],
         "with_context": [True, False],
         "with_container": [True, False],
         "with_utility": [True, False],
@@ -29,15 +31,17 @@ class KieToolboxConan(ConanFile):
         "shared": False,
         "fPIC": True,
         "enable_test": True,
+        "enable_bench": False,
         "with_serde": False,
         "with_serde_json": False,
+        "with_serde_msgpack": False,
         "with_context": False,
         "with_container": False,
         "with_utility": False,
     }
 
     # Sources are located in the same place as this recipe, copy them to the recipe
-    exports_sources = "CMakeLists.txt", "src/*", "test/*", "include/*", "LICENSE"
+    exports_sources = "CMakeLists.txt", "src/*", "test/*", "bench/*", "include/*", "LICENSE"
 
     def config_options(self):
         if self.settings.os == "Windows":
@@ -54,9 +58,12 @@ class KieToolboxConan(ConanFile):
     def build_requirements(self):
         if self.options.enable_test:
             self.test_requires("gtest/cci.20210126")
+        if self.options.enable_bench:
+            self.test_requires("benchmark/1.8.3")
 
     def _configure(self, tc):
         tc.variables["ENABLE_TEST"] = self.options.enable_test
+        tc.variables["ENABLE_BENCH"] = self.options.enable_bench
         tc.variables["WITH_CONTEXT"] = self.options.with_context
         tc.variables["WITH_SERDE"] = self.options.with_serde
         tc.variables["WITH_CONTAINER"] = self.options.with_container
@@ -64,6 +71,9 @@ class KieToolboxConan(ConanFile):
         if self.options.with_serde_json:
             tc.variables["WITH_SERDE"] = True
             tc.variables["WITH_SERDE_JSON"] = True
+        if self.options.with_serde_msgpack:
+            tc.variables["WITH_SERDE"] = True
+            tc.variables["WITH_SERDE_MSGPACK"] = True
 
     def generate(self):
         tc = CMakeToolchain(self)
@@ -77,7 +87,7 @@ class KieToolboxConan(ConanFile):
         cmake = CMake(self)
         cmake.configure()
         cmake.build()
-        if self.options.enable_test:
+        if self.options.enable_test or self.options.enable_bench:
             cmake.test()
 
     def package(self):
@@ -0,0 +1,264 @@
+/**
+ * @file allocator.hpp
+ * @author Kie
+ *
+ * Define the kie::recycling_allocator, which keeps the memory of handlers and coroutine frames
+ * in free lists of current thread, so it's reused instead of going to the global operator new.
+ */
+
+#ifndef KIE_TOOLBOX_CONTEXT_ALLOCATOR_HPP
+#define KIE_TOOLBOX_CONTEXT_ALLOCATOR_HPP
+
+#include <boost/asio/bind_allocator.hpp>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief context is in kie namespace
+ *
+ *
+ */
+namespace kie
+{
+
+  /**
+   * @brief This namespace contains some class used internally.
+   *
+   */
+  namespace impl
+  {
+    /**
+     * @brief The free lists of blocks of current thread, one for each size class.
+     *
+     * The size classes are the powers of two from 16 to 4096 bytes, and the larger blocks are not
+     * kept. A block may be freed on another thread than it's allocated on, and it goes to the free
+     * list of that thread then. Each list keeps a bounded count of blocks, and the rest goes back
+     * to the global operator delete.
+     */
+    class recycling_pool
+    {
+    public:
+      static constexpr std::size_t min_block = 16;
+      static constexpr std::size_t max_block = 4096;
+      static constexpr std::size_t classes = 9;
+      /// How many free blocks a list keeps at most.
+      static constexpr std::size_t max_cached = 256;
+
+    private:
+      struct free_block
+      {
+        free_block *next;
+      };
+
+      std::array<free_block *, classes> lists{};
+      std::array<std::size_t, classes> counts{};
+
+      /// True once the pool of current thread is destroyed, so the memory freed later is not kept.
+      inline static thread_local bool destroyed = false;
+
+      recycling_pool() = default;
+
+    public:
+      recycling_pool(const recycling_pool &) = delete;
+      recycling_pool &operator=(const recycling_pool &) = delete;
+
+      ~recycling_pool()
+      {
+        for (free_block *&head : lists)
+        {
+          while (head != nullptr)
+          {
+            ::operator delete(std::exchange(head, head->next));
+          }
+        }
+        destroyed = true;
+      }
+
+      /**
+       * @brief Get the pool of current thread, or nullptr if the thread is exiting and it's destroyed.
+       */
+      static recycling_pool *local()
+      {
+        if (destroyed)
+        {
+          return nullptr;
+        }
+        thread_local recycling_pool pool;
+        return &pool;
+      }
+
+      static std::size_t size_class(std::size_t bytes)
+      {
+        return bytes <= min_block ? 0 : static_cast<std::size_t>(std::bit_width(bytes - 1)) - 4;
+      }
+
+      /**
+       * @brief Get how many free blocks of the size class are kept.
+       */
+      std::size_t cached(std::size_t size_class) const
+      {
+        return counts[size_class];
+      }
+
+      static void *allocate(std::size_t bytes)
+      {
+        if (bytes > max_block)
+        {
+          return ::operator new(bytes);
+        }
+        const std::size_t k = size_class(bytes);
+        recycling_pool *pool = local();
+        if (pool != nullptr && pool->lists[k] != nullptr)
+        {
+          free_block *block = pool->lists[k];
+          pool->lists[k] = block->next;
+          pool->counts[k]--;
+          return block;
+        }
+        // always the whole size of the class, since it may be kept by the pool of another thread.
+        return ::operator new(min_block << k);
+      }
+
+      static void deallocate(void *p, std::size_t bytes) noexcept
+      {
+        recycling_pool *pool = local();
+        if (bytes > max_block || pool == nullptr)
+        {
+          ::operator delete(p);
+          return;
+        }
+        const std::size_t k = size_class(bytes);
+        if (pool->counts[k] == max_cached)
+        {
+          ::operator delete(p);
+          return;
+        }
+        pool->lists[k] = ::new (p) free_block{pool->lists[k]};
+        pool->counts[k]++;
+      }
+    };
+  }
+
+  /** @brief An allocator that reuses the memory freed on current thread.
+   *
+   * It's stateless, so any two of them are equal, and the memory allocated by one may be freed
+   * by another one on any thread. Attach it to a handler with `bind_recycling_allocator`, so Asio
+   * allocates the operation of the handler with it, or use it for the frames of coroutines with
+   * `recycling_new`. Once the free lists are warmed up, the handlers of the steady state are
+   * allocated without going to the global operator new.
+   *
+   * The types aligned more strictly than operator new does are not pooled.
+   */
+  template <typename T>
+  class recycling_allocator
+  {
+  public:
+    using value_type = T;
+
+    recycling_allocator() noexcept = default;
+
+    template <typename U>
+    recycling_allocator(const recycling_allocator<U> &) noexcept {}
+
+    /**
+     * @brief Rebind to another type, as Asio does for its operations.
+     */
+    template <typename U>
+    struct rebind
+    {
+      using other = recycling_allocator<U>;
+    };
+
+    T *allocate(std::size_t n)
+    {
+      if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+      }
+      else
+      {
+        return static_cast<T *>(impl::recycling_pool::allocate(n * sizeof(T)));
+      }
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+      if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      {
+        ::operator delete(p, std::align_val_t{alignof(T)});
+      }
+      else
+      {
+        impl::recycling_pool::deallocate(p, n * sizeof(T));
+      }
+    }
+
+    template <typename U>
+    bool operator==(const recycling_allocator<U> &) const noexcept
+    {
+      return true;
+    }
+  };
+
+  /** @brief A base whose operator new and delete go through the free lists of recycling_allocator.
+   *
+   * Make it the base of the promise type of a coroutine, so its frames are reused. It works for
+   * the other classes that are allocated one by one as well.
+   *
+   * @code
+   * struct task
+   * {
+   *   struct promise_type : kie::recycling_new
+   *   {
+   *     ...
+   *   };
+   * };
+   * @endcode
+   *
+   * The frames of `boost::asio::awaitable` are allocated by Asio, which keeps one of them per
+   * thread on its own.
+   */
+  struct recycling_new
+  {
+    static void *operator new(std::size_t size)
+    {
+      return impl::recycling_pool::allocate(size);
+    }
+
+    static void operator delete(void *p, std::size_t size) noexcept
+    {
+      impl::recycling_pool::deallocate(p, size);
+    }
+  };
+
+  /** @brief Attach the recycling_allocator to a handler.
+   *
+   * Asio allocates the operations for the handler with it, e.g. when it's posted or when an
+   * asynchronous operation is started with it, and so do the intermediate steps of composed
+   * operations like `boost::asio::async_read`. It's `boost::asio::bind_allocator`, so the other
+   * associated characteristics of the handler, like its executor and cancellation slot, are kept.
+   *
+   * Asio may still allocate some memory on its own for the I/O objects whose executor type is
+   * erased, like the default `boost::asio::any_io_executor`. Declare them with
+   * `boost::asio::io_context::executor_type` to avoid it.
+   *
+   * @code
+   * boost::asio::post(ctx.get_one(), kie::bind_recycling_allocator([]{ ... }));
+   * socket.async_read_some(buffer, kie::bind_recycling_allocator([](boost::system::error_code ec, std::size_t n){ ... }));
+   * @endcode
+   *
+   * @param handler The handler to wrap.
+   */
+  template <typename Handler>
+  auto bind_recycling_allocator(Handler &&handler)
+  {
+    return boost::asio::bind_allocator(recycling_allocator<void>{}, std::forward<Handler>(handler));
+  }
+
+} // namespace kie
+
+#endif
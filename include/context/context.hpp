@@ -10,11 +10,22 @@
 #define KIE_TOOLBOX_CONTEXT_CONTEXT_HPP
 
 #include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 #include <tuple>
+#include <utility>
+
+#include "allocator.hpp"
+#include "metrics.hpp"
+#include "placement.hpp"
 
 /**
  * @brief context is in kie namespace
@@ -43,13 +54,289 @@ namespace kie
    */
   class context
   {
+  public:
+    /**
+     * @brief How a context is chosen from the pool.
+     */
+    enum class pick
+    {
+      /// Take them in turn. Each thread has its own turn, so the threads do not contend.
+      round_robin,
+      /// Take the one with the least load. It reads the counters of all the contexts.
+      least_loaded,
+      /// Take the one with less load of two chosen at random. It's nearly as even as least_loaded, and reads only two counters.
+      two_choices,
+    };
+
+    class lease;
+    class counting_executor;
+
+  private:
     using context_ptr = std::unique_ptr<boost::asio::io_context, void(*)(boost::asio::io_context*)>;
+
+    /**
+     * @brief The load of one io_context, in a cache line of its own.
+     */
+    struct alignas(64) load_counter
+    {
+      std::atomic<std::size_t> value{0};
+    };
+
+    /// Declared before the io_contexts, so the handlers destroyed with them can still drop their load.
+    std::vector<std::unique_ptr<load_counter>> loads;
     std::vector<context_ptr> all_ctx;
     std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> guards;
-    mutable std::size_t current_idx;
+#if defined(KIE_CONTEXT_METRICS)
+    static_assert(context_metrics::buckets == impl::histogram_buckets);
+
+    /**
+     * @brief Remove the io_context from the registry before its recorder is freed.
+     */
+    struct unregister
+    {
+      const void *key;
+
+      void operator()(impl::metrics_recorder *recorder) const noexcept
+      {
+        impl::metrics_registry::set(key, nullptr);
+        delete recorder;
+      }
+    };
+
+    /// Declared after the io_contexts, so they are removed from the registry before the io_contexts are destroyed,
+    /// even when a constructor throws. The handlers destroyed with the io_contexts are not counted then.
+    std::vector<std::unique_ptr<impl::metrics_recorder, unregister>> recorders;
+#endif
+    /// Where the io_contexts are constructed, and where the threads run by default.
+    placement home;
+
+    /// How many threads have picked a context, so that each thread starts its round-robin from a different one.
+    inline static std::atomic<std::size_t> thread_count{0};
 
   private:
 
+    /**
+     * @brief The round-robin cursor of current thread. It's shared by all the contexts.
+     */
+    static std::size_t& thread_cursor(){
+      thread_local std::size_t cursor = thread_count.fetch_add(1, std::memory_order_relaxed);
+      return cursor;
+    }
+
+    /**
+     * @brief A random number for current thread, generated by splitmix64.
+     */
+    static std::uint64_t thread_random(){
+      thread_local std::uint64_t state = (thread_cursor() + 1) * 0x9E3779B97F4A7C15ull;
+      std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    /**
+     * @brief Run the io_context of thread i.
+     */
+    void run_one(std::size_t i)
+    {
+#if defined(KIE_CONTEXT_METRICS)
+      struct run_scope
+      {
+        impl::metrics_recorder &recorder;
+        std::int64_t start = impl::now_ns();
+
+        explicit run_scope(impl::metrics_recorder &recorder) : recorder(recorder)
+        {
+          recorder.thread_started(start);
+        }
+
+        ~run_scope()
+        {
+          recorder.thread_stopped(start, impl::now_ns());
+        }
+      } scope{*recorders[i % all_ctx.size()]};
+#endif
+      all_ctx[i % all_ctx.size()]->run();
+    }
+
+    /**
+     * @brief Reserve the room for the io_contexts, so `add` does not throw after taking one.
+     */
+    void reserve(std::size_t size)
+    {
+#if defined(KIE_CONTEXT_METRICS)
+      recorders.reserve(size);
+#endif
+      loads.reserve(size);
+      all_ctx.reserve(size);
+      guards.reserve(size);
+    }
+
+    /**
+     * @brief Add an io_context to the pool. Its load counter and its recorder are allocated by current thread.
+     */
+    void add(context_ptr ctx)
+    {
+      loads.push_back(std::make_unique<load_counter>());
+#if defined(KIE_CONTEXT_METRICS)
+      const void *key = static_cast<boost::asio::execution_context *>(ctx.get());
+      std::unique_ptr<impl::metrics_recorder, unregister> recorder{new impl::metrics_recorder{}, unregister{key}};
+      recorder->tracked = impl::metrics_registry::set(key, recorder.get());
+      recorders.push_back(std::move(recorder));
+#endif
+      guards.emplace_back(ctx->get_executor());
+      all_ctx.push_back(std::move(ctx));
+    }
+
+    /**
+     * @brief Start the threads that run the io_contexts.
+     *
+     * They are pinned by `where`, or by the placement of the constructor if `where` pins nothing.
+     * Then the threads wait until all of them are pinned, and none of them runs if one can't be.
+     *
+     * @throw std::system_error If a thread can't be pinned or started. All the threads have exited by then.
+     * If they are not pinned, they may have run some handlers, and the io_contexts are stopped.
+     */
+    std::vector<std::thread> start(std::size_t concurrency_hint, const placement &where)
+    {
+      concurrency_hint = std::max(all_ctx.size(), concurrency_hint);
+      const std::vector<int> cpus = (where.get_policy() == placement::policy::none ? home : where).assign(concurrency_hint);
+      std::vector<std::thread> threads;
+      if (cpus.empty())
+      {
+        try
+        {
+          for (std::size_t i = 0; i < concurrency_hint; i++)
+          {
+            threads.emplace_back([=, this]
+                                 { run_one(i); });
+          }
+        }
+        catch (...)
+        {
+          // the threads that are started are already running, so they are stopped with the io_contexts.
+          stop();
+          for (auto &t : threads)
+          {
+            t.join();
+          }
+          throw;
+        }
+        return threads;
+      }
+
+      struct pinning
+      {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t pinned = 0;
+        bool decided = false;
+        int error = 0;
+        int cpu = -1;
+      };
+      // shared with the threads, since they may still look at it after this returns.
+      auto state = std::make_shared<pinning>();
+      try
+      {
+        for (std::size_t i = 0; i < concurrency_hint; i++)
+        {
+          threads.emplace_back([=, this]
+                               {
+                                 const int error = impl::pin_current_thread(cpus[i]);
+                                 {
+                                   std::unique_lock lock{state->mutex};
+                                   if (error != 0 && state->error == 0)
+                                   {
+                                     state->error = error;
+                                     state->cpu = cpus[i];
+                                   }
+                                   state->pinned++;
+                                   state->changed.notify_all();
+                                   state->changed.wait(lock, [&]
+                                                       { return state->decided; });
+                                   if (state->error != 0)
+                                   {
+                                     return;
+                                   }
+                                 }
+                                 run_one(i); });
+        }
+      }
+      catch (...)
+      {
+        // the threads that are started would wait forever, so they are let go without running.
+        {
+          std::lock_guard lock{state->mutex};
+          state->error = state->error == 0 ? ECANCELED : state->error;
+          state->decided = true;
+        }
+        state->changed.notify_all();
+        for (auto &t : threads)
+        {
+          t.join();
+        }
+        throw;
+      }
+
+      std::unique_lock lock{state->mutex};
+      state->changed.wait(lock, [&]
+                          { return state->pinned == threads.size(); });
+      state->decided = true;
+      state->changed.notify_all();
+      if (state->error != 0)
+      {
+        lock.unlock();
+        for (auto &t : threads)
+        {
+          t.join();
+        }
+        throw impl::pin_error(state->error, state->cpu);
+      }
+      return threads;
+    }
+
+    /**
+     * @brief Get the index of the context chosen by the policy.
+     */
+    std::size_t pick_index(pick policy){
+      const std::size_t size = all_ctx.size();
+      switch (policy)
+      {
+      case pick::least_loaded:
+      {
+        // start from the cursor, so the threads do not all pile onto the first one of the ties.
+        const std::size_t start = thread_cursor()++;
+        std::size_t best = start % size;
+        std::size_t best_load = load(best);
+        for (std::size_t i = 1; i < size && best_load != 0; i++)
+        {
+          const std::size_t idx = (start + i) % size;
+          const std::size_t current = load(idx);
+          if (current < best_load)
+          {
+            best = idx;
+            best_load = current;
+          }
+        }
+        return best;
+      }
+      case pick::two_choices:
+      {
+        if (size == 1)
+        {
+          return 0;
+        }
+        // the second one is taken from the others, so two contexts are always compared.
+        const std::uint64_t random = thread_random();
+        const std::size_t first = random % size;
+        const std::size_t second = (first + 1 + (random >> 32) % (size - 1)) % size;
+        return load(second) < load(first) ? second : first;
+      }
+      default:
+        return thread_cursor()++ % size;
+      }
+    }
+
     static void default_deleter(boost::asio::io_context* ptr){
       delete ptr;
     }
@@ -67,15 +354,47 @@ namespace kie
     /**
      * @brief The explicit constructor for context. It may throw exception when memory allocation fails.
      *
+     * If the placement pins the threads, each io_context is constructed on a thread pinned to its
+     * CPU, so its memory is on the NUMA node of that CPU. `run` pins the threads the same way by
+     * default then. See `placement`.
      *
      * @param size How many context should be used.
+     * @param where The CPU of each io_context. Default to no pinning.
+     *
+     * @throw std::system_error If a thread can't be pinned to the CPU of an io_context.
      */
-    explicit context(std::size_t size) : current_idx(0)
+    explicit context(std::size_t size, const placement &where = {}) : home(where)
     {
+      reserve(size);
+      const std::vector<int> cpus = where.assign(size);
       for (std::size_t i = 0; i < size; i++)
       {
-        all_ctx.emplace_back(context_ptr(new boost::asio::io_context(1), default_deleter));
-        guards.emplace_back(all_ctx[i]->get_executor());
+        if (cpus.empty())
+        {
+          add(context_ptr(new boost::asio::io_context(1), default_deleter));
+          continue;
+        }
+        // constructed on its CPU, so the pages are first touched on the node of that CPU.
+        std::exception_ptr failure;
+        std::thread([&]
+                    {
+                      try
+                      {
+                        if (const int error = impl::pin_current_thread(cpus[i]); error != 0)
+                        {
+                          throw impl::pin_error(error, cpus[i]);
+                        }
+                        add(context_ptr(new boost::asio::io_context(1), default_deleter));
+                      }
+                      catch (...)
+                      {
+                        failure = std::current_exception();
+                      } })
+            .join();
+        if (failure)
+        {
+          std::rethrow_exception(failure);
+        }
       }
     }
 
@@ -86,10 +405,10 @@ namespace kie
      *
      * @param ctx The `io_context` that will be wrapped.
      */
-    explicit context(boost::asio::io_context& ctx) : current_idx(0)
+    explicit context(boost::asio::io_context& ctx)
     {
-      all_ctx.emplace_back(context_ptr(&ctx, noop_deleter));
-      guards.emplace_back(ctx.get_executor());
+      reserve(1);
+      add(context_ptr(&ctx, noop_deleter));
     }
 
     /**
@@ -109,13 +428,122 @@ namespace kie
     /**
      * @brief Get one context from pool.
      *
-     * It use round-robin algorithm to fetch one context.
+     * It use round-robin algorithm to fetch one context. It's safe to be called from many threads,
+     * and each thread takes its own turn, so they share no counter. The handlers posted to the
+     * io_context are allocated by their own allocator, so bind them with `kie::bind_recycling_allocator`
+     * or post them through `get_executor` to reuse the memory.
      */
     boost::asio::io_context &get_one()
     {
-      const auto &ctx = all_ctx[current_idx++];
-      current_idx %= all_ctx.size();
-      return *ctx;
+      return *all_ctx[pick_index(pick::round_robin)];
+    }
+
+    /**
+     * @brief Get one context from pool by the policy.
+     *
+     * The load of a context is the leases held on it and the work queued on it, see `load`. Build
+     * the program with the handler tracking of `context/handler_tracking.hpp` to count all the
+     * handlers that are queued, like the ones of sockets. Without it, only the work that goes
+     * through `acquire` or `get_executor` is seen. This does not add to the load itself.
+     *
+     * @param policy How the context is chosen.
+     */
+    boost::asio::io_context &get_one(pick policy)
+    {
+      return *all_ctx[pick_index(policy)];
+    }
+
+    /**
+     * @brief Get an executor of one context from pool, which counts the functions submitted to it as the load of the context.
+     *
+     * Post the work with it rather than with the io_context, so the policies see it even without
+     * the handler tracking. The functions are allocated by the recycling_allocator.
+     *
+     * @code
+     * auto ex = ctx.get_executor();
+     * boost::asio::post(ex, [request]{ handle(request); });
+     * @endcode
+     *
+     * @param policy How the context is chosen. Default to two_choices.
+     */
+    counting_executor get_executor(pick policy = pick::two_choices);
+
+    /**
+     * @brief Take a lease on one context from pool, which counts as its load until the lease is dropped.
+     *
+     * Keep the lease as long as the work on the context lasts, e.g. in the connection that is
+     * accepted on it. So the next connection goes to a context with fewer connections.
+     *
+     * @code
+     * auto lease = ctx.acquire();
+     * auto conn = std::make_shared<connection>(lease.get(), std::move(lease));
+     * @endcode
+     *
+     * @param policy How the context is chosen. Default to two_choices.
+     */
+    lease acquire(pick policy = pick::two_choices);
+
+    /**
+     * @brief Get the load of a context, which is how many leases are held on it, and how much work is queued on it.
+     *
+     * The work queued is the functions submitted through a `counting_executor` that have not started.
+     * When the handler tracking of `context/handler_tracking.hpp` is built in, it's all the handlers
+     * that are ready to run instead, like the ones posted to the io_context directly or the ones of
+     * its sockets, see `context_metrics::queued`.
+     *
+     * @param idx The index of context. It should be less than the size of the pool.
+     */
+    std::size_t load(std::size_t idx) const
+    {
+      const std::size_t leases = loads[idx]->value.load(std::memory_order_relaxed);
+#if defined(KIE_CONTEXT_METRICS)
+      const std::int64_t queued = recorders[idx]->queued.load(std::memory_order_relaxed);
+      return leases + static_cast<std::size_t>(std::max<std::int64_t>(queued, 0));
+#else
+      return leases;
+#endif
+    }
+
+    /**
+     * @brief Get a snapshot of the metrics of a context. It may be called from any thread.
+     *
+     * It's all zero unless the handler tracking of `context/handler_tracking.hpp` is built in,
+     * see `context_metrics`.
+     *
+     * @param idx The index of context. It should be less than the size of the pool.
+     */
+    context_metrics metrics([[maybe_unused]] std::size_t idx) const
+    {
+      context_metrics result;
+#if defined(KIE_CONTEXT_METRICS)
+      const impl::metrics_recorder &recorder = *recorders[idx];
+      result.tracked = recorder.tracked;
+      const auto load = [](const auto &value)
+      { return value.load(std::memory_order_relaxed); };
+      result.handlers = load(recorder.handlers);
+      result.queued = static_cast<std::uint64_t>(std::max<std::int64_t>(load(recorder.queued), 0));
+      result.wait = std::chrono::nanoseconds{load(recorder.wait_ns)};
+      result.busy = std::chrono::nanoseconds{load(recorder.busy_ns)};
+      for (std::size_t k = 0; k < context_metrics::buckets; k++)
+      {
+        result.wait_histogram[k] = load(recorder.wait_histogram[k]);
+        result.run_histogram[k] = load(recorder.run_histogram[k]);
+      }
+      const std::int64_t running_ns = load(recorder.run_ns) + load(recorder.running) * impl::now_ns() - load(recorder.start_sum_ns);
+      result.idle = std::max(std::chrono::nanoseconds{running_ns} - result.busy, std::chrono::nanoseconds{0});
+#endif
+      return result;
+    }
+
+    /**
+     * @brief Get the allocator that reuses the memory of handlers on each thread.
+     *
+     * The executors of `get_executor` and `kie::work_stealing_executor` allocate with it already.
+     * Attach it to the other handlers with `kie::bind_recycling_allocator`, see `recycling_allocator`.
+     */
+    recycling_allocator<void> get_allocator() const noexcept
+    {
+      return {};
     }
 
     /**
@@ -153,15 +581,15 @@ namespace kie
      * @brief Run the context as daemon. It does not block current thread.
      *
      * @param concurrency_hint. The hint to context how many threads should be used to run. Default to -1, which means per context per thread.
+     * @param where The CPUs that the threads are pinned to. Default to the placement given to the constructor.
+     *
+     * @throw std::system_error If a thread can't be pinned or started. No thread is left running then.
      */
-    void run_as_daemon(std::size_t concurrency_hint = 0)
+    void run_as_daemon(std::size_t concurrency_hint = 0, const placement &where = {})
     {
-      concurrency_hint = std::max(all_ctx.size(), concurrency_hint);
-      for (std::size_t i = 0; i < concurrency_hint; i++)
+      for (auto &t : start(concurrency_hint, where))
       {
-        std::thread([=, this]
-                    { all_ctx[i % all_ctx.size()]->run(); })
-            .detach();
+        t.detach();
       }
     }
 
@@ -172,18 +600,13 @@ namespace kie
      * This start the context runtime and serving all the async operation.
      *
      * @param concurrency_hint. The hint to context how many threads should be used to run. Default to -1, which means per context per thread. 
+     * @param where The CPUs that the threads are pinned to. Default to the placement given to the constructor.
+     *
+     * @throw std::system_error If a thread can't be pinned or started. No thread is left running then.
      */
-    void run(std::size_t concurrency_hint = 0)
+    void run(std::size_t concurrency_hint = 0, const placement &where = {})
     {
-      concurrency_hint = std::max(all_ctx.size(), concurrency_hint);
-      std::vector<std::thread> threads;
-      for (std::size_t i = 0; i < concurrency_hint; i++)
-      {
-        threads.emplace_back([=, this]
-                             { all_ctx[i % all_ctx.size()]->run(); });
-      }
-
-      for (auto &t : threads)
+      for (auto &t : start(concurrency_hint, where))
       {
         t.join();
       }
@@ -220,6 +643,168 @@ namespace kie
     }
   };
 
+  /**
+   * @brief A lease on one io_context of a context, which counts as its load while it's held.
+   *
+   * It's move-only. The context should live longer than the lease.
+   */
+  class context::lease
+  {
+    context *owner = nullptr;
+    std::size_t idx = 0;
+
+  public:
+    lease() = default;
+
+    lease(context &owner, std::size_t idx) : owner(&owner), idx(idx)
+    {
+      owner.loads[idx]->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    lease(lease &&other) noexcept : owner(std::exchange(other.owner, nullptr)), idx(other.idx) {}
+
+    lease &operator=(lease &&other) noexcept
+    {
+      if (this != &other)
+      {
+        release();
+        owner = std::exchange(other.owner, nullptr);
+        idx = other.idx;
+      }
+      return *this;
+    }
+
+    lease(const lease &) = delete;
+    lease &operator=(const lease &) = delete;
+
+    ~lease()
+    {
+      release();
+    }
+
+    /**
+     * @brief Get the io_context that is leased. The lease should be held.
+     */
+    boost::asio::io_context &get() const
+    {
+      return *owner->all_ctx[idx];
+    }
+
+    /**
+     * @brief Get the index of the io_context in the pool.
+     */
+    std::size_t index() const
+    {
+      return idx;
+    }
+
+    /**
+     * @brief Check if the lease is held.
+     */
+    explicit operator bool() const
+    {
+      return owner != nullptr;
+    }
+
+    /**
+     * @brief Drop the lease before it's destroyed.
+     */
+    void release()
+    {
+      if (owner != nullptr)
+      {
+        owner->loads[idx]->value.fetch_sub(1, std::memory_order_relaxed);
+        owner = nullptr;
+      }
+    }
+  };
+
+  /**
+   * @brief An executor of one io_context of a context, which counts each function submitted to it as load until it starts.
+   *
+   * A function that is destroyed without running, e.g. when the io_context is destroyed, drops its
+   * load as well. With the handler tracking built in, the function is counted as a queued handler
+   * like any other, and nothing more is done. It never runs the function inside `execute`, and the
+   * context should live longer than it. The functions are allocated by the recycling_allocator.
+   */
+  class context::counting_executor
+  {
+    context *owner;
+    std::size_t idx;
+
+  public:
+    counting_executor(context &owner, std::size_t idx) noexcept : owner(&owner), idx(idx) {}
+
+    /**
+     * @brief Submit a function to the io_context. The function holds a lease until it starts or is destroyed.
+     */
+    template <typename F>
+    void execute(F &&f) const
+    {
+      const auto ex = boost::asio::require(owner->all_ctx[idx]->get_executor(), boost::asio::execution::blocking.never,
+                                           boost::asio::execution::allocator(recycling_allocator<void>{}));
+#if defined(KIE_CONTEXT_METRICS)
+      boost::asio::execution::execute(ex, std::forward<F>(f));
+#else
+      boost::asio::execution::execute(ex, [queued = lease{*owner, idx}, f = std::forward<F>(f)]() mutable
+                                      {
+                                        queued.release();
+                                        std::move(f)(); });
+#endif
+    }
+
+    /**
+     * @brief The functions are never run inside `execute`.
+     */
+    counting_executor require(boost::asio::execution::blocking_t::never_t) const noexcept
+    {
+      return *this;
+    }
+
+    static constexpr boost::asio::execution::blocking_t query(boost::asio::execution::blocking_t) noexcept
+    {
+      return boost::asio::execution::blocking.never;
+    }
+
+    static recycling_allocator<void> query(boost::asio::execution::allocator_t<void>) noexcept
+    {
+      return {};
+    }
+
+    boost::asio::io_context &query(boost::asio::execution::context_t) const noexcept
+    {
+      return *owner->all_ctx[idx];
+    }
+
+    /**
+     * @brief Get the index of the io_context in the pool.
+     */
+    std::size_t index() const noexcept
+    {
+      return idx;
+    }
+
+    bool operator==(const counting_executor &other) const noexcept
+    {
+      return owner == other.owner && idx == other.idx;
+    }
+
+    bool operator!=(const counting_executor &other) const noexcept
+    {
+      return !(*this == other);
+    }
+  };
+
+  inline context::lease context::acquire(pick policy)
+  {
+    return lease{*this, pick_index(policy)};
+  }
+
+  inline context::counting_executor context::get_executor(pick policy)
+  {
+    return counting_executor{*this, pick_index(policy)};
+  }
+
 } // namespace kie
 
 #endif
\ No newline at end of file
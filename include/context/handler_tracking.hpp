@@ -0,0 +1,398 @@
+/**
+ * @file handler_tracking.hpp
+ * @author Kie
+ *
+ * The custom handler tracking of Asio that feeds the metrics of kie::context.
+ *
+ * It's turned on by defining `BOOST_ASIO_CUSTOM_HANDLER_TRACKING` for the whole program, so that
+ * every translation unit sees the same handler types:
+ * @code
+ * target_compile_definitions(server PRIVATE "BOOST_ASIO_CUSTOM_HANDLER_TRACKING=<context/handler_tracking.hpp>")
+ * @endcode
+ * Then `kie::context::metrics` returns the metrics of each io_context. Nothing is tracked and
+ * nothing is stored without it.
+ */
+
+#ifndef KIE_TOOLBOX_CONTEXT_HANDLER_TRACKING_HPP
+#define KIE_TOOLBOX_CONTEXT_HANDLER_TRACKING_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef KIE_CONTEXT_METRICS
+#define KIE_CONTEXT_METRICS 1
+#endif
+
+/**
+ * @brief context is in kie namespace
+ *
+ *
+ */
+namespace kie
+{
+
+  /**
+   * @brief This namespace contains some class used internally.
+   *
+   */
+  namespace impl
+  {
+    /**
+     * @brief The count of buckets of the histograms. Bucket k holds the durations below `1024ns << k`, and the last one holds the rest.
+     */
+    constexpr std::size_t histogram_buckets = 24;
+
+    /**
+     * @brief Get the bucket of a duration in nanoseconds.
+     */
+    inline std::size_t histogram_bucket(std::uint64_t ns)
+    {
+      const std::size_t k = static_cast<std::size_t>(std::bit_width(ns >> 10));
+      return k < histogram_buckets ? k : histogram_buckets - 1;
+    }
+
+    inline std::int64_t now_ns()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief The metrics of one io_context, updated by the threads that run its handlers.
+     *
+     * All the counters are relaxed atomics, so a snapshot may be a little out of date, but it
+     * never blocks the threads.
+     */
+    struct alignas(64) metrics_recorder
+    {
+      /// Set once the registry has taken the io_context, before any handler is counted.
+      bool tracked = false;
+      std::atomic<std::uint64_t> handlers{0};
+      /// The handlers that are ready to run and not run yet.
+      std::atomic<std::int64_t> queued{0};
+      std::atomic<std::uint64_t> wait_ns{0};
+      std::atomic<std::uint64_t> busy_ns{0};
+      std::array<std::atomic<std::uint64_t>, histogram_buckets> wait_histogram{};
+      std::array<std::atomic<std::uint64_t>, histogram_buckets> run_histogram{};
+
+      /// The time of the threads that have stopped running the io_context.
+      std::atomic<std::int64_t> run_ns{0};
+      std::atomic<std::int64_t> running{0};
+      /// The sum of the start time of the threads that are running the io_context.
+      std::atomic<std::int64_t> start_sum_ns{0};
+
+      void record_wait(std::int64_t ns)
+      {
+        const auto value = static_cast<std::uint64_t>(ns < 0 ? 0 : ns);
+        wait_ns.fetch_add(value, std::memory_order_relaxed);
+        wait_histogram[histogram_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+      }
+
+      void record_run(std::int64_t ns, bool outermost)
+      {
+        const auto value = static_cast<std::uint64_t>(ns < 0 ? 0 : ns);
+        run_histogram[histogram_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        if (outermost)
+        {
+          // the handlers run inside another one are a part of its time already.
+          busy_ns.fetch_add(value, std::memory_order_relaxed);
+        }
+      }
+
+      void thread_started(std::int64_t now)
+      {
+        start_sum_ns.fetch_add(now, std::memory_order_relaxed);
+        running.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      void thread_stopped(std::int64_t start, std::int64_t now)
+      {
+        run_ns.fetch_add(now - start, std::memory_order_relaxed);
+        running.fetch_sub(1, std::memory_order_relaxed);
+        start_sum_ns.fetch_sub(start, std::memory_order_relaxed);
+      }
+    };
+
+    /**
+     * @brief Find the metrics_recorder of an io_context from the handler tracking.
+     *
+     * It's a fixed table of linear probing, so a lookup takes no lock and no allocation. A removed
+     * io_context leaves a delete marker, which the lookups probe past and the next one set reuses.
+     * The io_contexts that do not fit are not tracked.
+     */
+    class metrics_registry
+    {
+    public:
+      /// How many io_contexts may be tracked at the same time.
+      static constexpr std::size_t capacity = 1024;
+
+    private:
+      /// The key of a slot whose io_context is removed.
+      inline static const char removed_key = 0;
+
+      // the atomics start as nullptr, since they are value-initialized.
+      struct entry
+      {
+        std::atomic<const void *> key;
+        std::atomic<metrics_recorder *> value;
+      };
+
+      inline static std::array<entry, capacity> table{};
+
+      static std::size_t hash(const void *key)
+      {
+        auto v = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key));
+        v ^= v >> 29;
+        v *= 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(v >> 54);
+      }
+
+    public:
+      /**
+       * @brief Set the recorder of an io_context, or remove it with nullptr.
+       *
+       * An io_context is set by one thread at a time, e.g. the one that constructs or destroys kie::context.
+       *
+       * @return False if the table is full.
+       */
+      static bool set(const void *key, metrics_recorder *value)
+      {
+        const std::size_t start = hash(key);
+        if (value == nullptr)
+        {
+          for (std::size_t i = 0; i < capacity; i++)
+          {
+            entry &e = table[(start + i) % capacity];
+            const void *current = e.key.load(std::memory_order_acquire);
+            if (current == key)
+            {
+              e.value.store(nullptr, std::memory_order_release);
+              e.key.store(&removed_key, std::memory_order_release);
+              return true;
+            }
+            if (current == nullptr)
+            {
+              return true;
+            }
+          }
+          return true;
+        }
+
+        // the key may sit after a delete marker, so a free slot is only taken once the probe reaches an empty one.
+        for (;;)
+        {
+          entry *free = nullptr;
+          for (std::size_t i = 0; i < capacity; i++)
+          {
+            entry &e = table[(start + i) % capacity];
+            const void *current = e.key.load(std::memory_order_acquire);
+            if (current == key)
+            {
+              e.value.store(value, std::memory_order_release);
+              return true;
+            }
+            if (current == &removed_key || current == nullptr)
+            {
+              free = free == nullptr ? &e : free;
+            }
+            if (current == nullptr)
+            {
+              break;
+            }
+          }
+          if (free == nullptr)
+          {
+            return false;
+          }
+          const void *current = free->key.load(std::memory_order_acquire);
+          // another io_context may have taken the slot since, and then the probe starts again.
+          if ((current == &removed_key || current == nullptr) && free->key.compare_exchange_strong(current, key))
+          {
+            free->value.store(value, std::memory_order_release);
+            return true;
+          }
+        }
+      }
+
+      static metrics_recorder *find(const void *key)
+      {
+        const std::size_t start = hash(key);
+        for (std::size_t i = 0; i < capacity; i++)
+        {
+          entry &e = table[(start + i) % capacity];
+          const void *current = e.key.load(std::memory_order_acquire);
+          if (current == key)
+          {
+            return e.value.load(std::memory_order_acquire);
+          }
+          if (current == nullptr)
+          {
+            return nullptr;
+          }
+        }
+        return nullptr;
+      }
+    };
+
+    /**
+     * @brief The base of the operations of Asio, which keeps when the handler got ready to run.
+     */
+    class tracked_handler
+    {
+      friend class handler_completion;
+      template <typename ErrorCode, typename... Args>
+      friend void handler_ready(const tracked_handler &h, const char *op_name, const ErrorCode &ec, const Args &...);
+      template <typename Context>
+      friend void handler_created(Context &context, tracked_handler &h, const char *object_type, void *object, std::uintmax_t native_handle, const char *op_name);
+
+      mutable const void *context = nullptr;
+      /// The time the handler got ready, or 0 if it's not ready yet.
+      mutable std::int64_t ready_ns = 0;
+
+    protected:
+      tracked_handler() = default;
+      ~tracked_handler() = default;
+    };
+
+    /**
+     * @brief Count a handler as queued from now on.
+     */
+    inline void mark_ready(const void *context, std::int64_t &ready_ns)
+    {
+      if (ready_ns == 0)
+      {
+        if (metrics_recorder *recorder = metrics_registry::find(context))
+        {
+          recorder->queued.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      ready_ns = now_ns();
+    }
+
+    /**
+     * @brief Record that a handler is created on an io_context.
+     *
+     * The handlers that are posted are ready to run at once. The ones of asynchronous operations
+     * are ready when the reactor has done the operation, see `handler_ready`.
+     */
+    template <typename Context>
+    void handler_created(Context &context, tracked_handler &h, const char *, void *, std::uintmax_t, const char *op_name)
+    {
+      h.context = &context;
+      if (op_name[0] != 'a')
+      {
+        // post, dispatch, defer and execute.
+        mark_ready(h.context, h.ready_ns);
+      }
+    }
+
+    /**
+     * @brief Record that the reactor has tried the operation of a handler.
+     *
+     * It's queued to run unless the operation would block, and it waits for the reactor then.
+     */
+    template <typename ErrorCode, typename... Args>
+    void handler_ready(const tracked_handler &h, const char *, const ErrorCode &ec, const Args &...)
+    {
+      if (ec.value() == EWOULDBLOCK || ec.value() == EAGAIN)
+      {
+        return;
+      }
+      mark_ready(h.context, h.ready_ns);
+    }
+
+    /**
+     * @brief Record that a handler runs, or is destroyed without running.
+     *
+     * It's made right before the memory of the handler is freed, so it keeps what it needs.
+     */
+    class handler_completion
+    {
+      inline static thread_local std::size_t depth = 0;
+
+      metrics_recorder *recorder;
+      std::int64_t ready_ns;
+      std::int64_t begin_ns = 0;
+      bool begun = false;
+      bool ended = false;
+
+    public:
+      explicit handler_completion(const tracked_handler &h)
+          : recorder(h.context != nullptr ? metrics_registry::find(h.context) : nullptr), ready_ns(h.ready_ns) {}
+
+      handler_completion(const handler_completion &) = delete;
+      handler_completion &operator=(const handler_completion &) = delete;
+
+      ~handler_completion()
+      {
+        if (begun && !ended)
+        {
+          // the handler has thrown.
+          invocation_end();
+        }
+        else if (!begun && recorder != nullptr && ready_ns != 0)
+        {
+          recorder->queued.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+
+      template <typename... Args>
+      void invocation_begin(const Args &...)
+      {
+        begun = true;
+        depth++;
+        begin_ns = now_ns();
+        if (recorder == nullptr)
+        {
+          return;
+        }
+        recorder->handlers.fetch_add(1, std::memory_order_relaxed);
+        if (ready_ns != 0)
+        {
+          recorder->queued.fetch_sub(1, std::memory_order_relaxed);
+          recorder->record_wait(begin_ns - ready_ns);
+        }
+      }
+
+      void invocation_end()
+      {
+        ended = true;
+        depth--;
+        if (recorder != nullptr)
+        {
+          recorder->record_run(now_ns() - begin_ns, depth == 0);
+        }
+      }
+    };
+
+    /**
+     * @brief Take the arguments of the hooks that are not tracked.
+     */
+    template <typename... Args>
+    inline void ignore_tracking(const Args &...) {}
+  }
+
+} // namespace kie
+
+#define BOOST_ASIO_INHERIT_TRACKED_HANDLER : public kie::impl::tracked_handler
+#define BOOST_ASIO_ALSO_INHERIT_TRACKED_HANDLER , public kie::impl::tracked_handler
+#define BOOST_ASIO_HANDLER_TRACKING_INIT (void)0
+#define BOOST_ASIO_HANDLER_LOCATION(args) kie::impl::ignore_tracking args
+#define BOOST_ASIO_HANDLER_CREATION(args) kie::impl::handler_created args
+#define BOOST_ASIO_HANDLER_COMPLETION(args) kie::impl::handler_completion kie_tracked_completion args
+#define BOOST_ASIO_HANDLER_INVOCATION_BEGIN(args) kie_tracked_completion.invocation_begin args
+#define BOOST_ASIO_HANDLER_INVOCATION_END kie_tracked_completion.invocation_end()
+#define BOOST_ASIO_HANDLER_OPERATION(args) kie::impl::ignore_tracking args
+#define BOOST_ASIO_HANDLER_REACTOR_REGISTRATION(args) kie::impl::ignore_tracking args
+#define BOOST_ASIO_HANDLER_REACTOR_DEREGISTRATION(args) kie::impl::ignore_tracking args
+#define BOOST_ASIO_HANDLER_REACTOR_READ_EVENT 1
+#define BOOST_ASIO_HANDLER_REACTOR_WRITE_EVENT 2
+#define BOOST_ASIO_HANDLER_REACTOR_ERROR_EVENT 4
+#define BOOST_ASIO_HANDLER_REACTOR_EVENTS(args) kie::impl::ignore_tracking args
+#define BOOST_ASIO_HANDLER_REACTOR_OPERATION(args) kie::impl::handler_ready args
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file metrics.hpp
+ * @author Kie
+ *
+ * Define the kie::context_metrics, the snapshot of how loaded an io_context of kie::context is.
+ */
+
+#ifndef KIE_TOOLBOX_CONTEXT_METRICS_HPP
+#define KIE_TOOLBOX_CONTEXT_METRICS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(KIE_CONTEXT_METRICS) && !defined(BOOST_ASIO_CUSTOM_HANDLER_TRACKING)
+#error "KIE_CONTEXT_METRICS needs BOOST_ASIO_CUSTOM_HANDLER_TRACKING=<context/handler_tracking.hpp> for the whole program"
+#endif
+
+/**
+ * @brief context is in kie namespace
+ *
+ *
+ */
+namespace kie
+{
+
+  /** @brief A snapshot of the metrics of one io_context.
+   *
+   * The metrics are only gathered when the program is built with the handler tracking of
+   * `context/handler_tracking.hpp`, and `enabled` tells if it is. Otherwise the snapshot is all
+   * zero, and the context stores and does nothing for them.
+   *
+   * A handler is queued when it's posted, or when the reactor has done its operation, e.g. the
+   * data to read has come. So the wait is the time it could have run but did not. The handlers of
+   * timers and of the other operations that are not done by the reactor are not counted as queued.
+   */
+  struct context_metrics
+  {
+#if defined(KIE_CONTEXT_METRICS)
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    /// The count of buckets of the histograms.
+    static constexpr std::size_t buckets = 24;
+
+    /// False if the io_context could not be tracked, because 1024 others are tracked already.
+    bool tracked = false;
+    /// How many handlers have run.
+    std::uint64_t handlers = 0;
+    /// How many handlers are queued and not run yet.
+    std::uint64_t queued = 0;
+    /// The total time that the handlers have waited in the queue.
+    std::chrono::nanoseconds wait{0};
+    /// The time that the threads have spent in the handlers.
+    std::chrono::nanoseconds busy{0};
+    /// The time that the threads have run the io_context with no handler to run.
+    std::chrono::nanoseconds idle{0};
+    /// How many handlers have waited in the queue for the time of each bucket.
+    std::array<std::uint64_t, buckets> wait_histogram{};
+    /// How many handlers have run for the time of each bucket.
+    std::array<std::uint64_t, buckets> run_histogram{};
+
+    /**
+     * @brief Get the upper bound of the time of bucket k, which holds the times from the bound of bucket k - 1.
+     *
+     * The bound of bucket k is `1024ns << k`, and the last one has no bound.
+     */
+    static constexpr std::chrono::nanoseconds bucket_bound(std::size_t k)
+    {
+      if (k + 1 >= buckets)
+      {
+        return std::chrono::nanoseconds::max();
+      }
+      return std::chrono::nanoseconds{std::int64_t{1024} << k};
+    }
+
+    /**
+     * @brief Get the share of time the threads are in the handlers, from 0 to 1.
+     */
+    double busy_ratio() const
+    {
+      const auto total = busy + idle;
+      return total.count() == 0 ? 0.0 : static_cast<double>(busy.count()) / static_cast<double>(total.count());
+    }
+  };
+
+} // namespace kie
+
+#endif
@@ -0,0 +1,354 @@
+/**
+ * @file placement.hpp
+ * @author Kie
+ *
+ * Define the kie::placement, which decides the CPU that each thread of kie::context runs on.
+ */
+
+#ifndef KIE_TOOLBOX_CONTEXT_PLACEMENT_HPP
+#define KIE_TOOLBOX_CONTEXT_PLACEMENT_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief context is in kie namespace
+ *
+ *
+ */
+namespace kie
+{
+
+  /**
+   * @brief This namespace contains some function used internally.
+   *
+   */
+  namespace impl
+  {
+    /**
+     * @brief Parse a list of CPU like `0-3,8,10-11`, which is how Linux lists the CPUs of a NUMA node, and the nodes that are online.
+     *
+     * @return The CPUs in ascending order. The parts that are not numbers are skipped.
+     */
+    inline std::vector<int> parse_cpu_list(std::string_view text)
+    {
+      std::vector<int> cpus;
+      std::size_t pos = 0;
+      auto read_number = [&](int &n)
+      {
+        const std::size_t begin = pos;
+        n = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+        {
+          n = n * 10 + (text[pos] - '0');
+          pos++;
+        }
+        return pos != begin;
+      };
+
+      while (pos < text.size())
+      {
+        int first = 0;
+        if (!read_number(first))
+        {
+          pos++;
+          continue;
+        }
+        int last = first;
+        if (pos < text.size() && text[pos] == '-')
+        {
+          pos++;
+          if (!read_number(last))
+          {
+            last = first;
+          }
+        }
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+          cpus.push_back(cpu);
+        }
+      }
+      std::sort(cpus.begin(), cpus.end());
+      cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+      return cpus;
+    }
+
+    /**
+     * @brief Get the CPUs that this process may run on.
+     *
+     * It's empty if they can't be found, e.g. on a system other than Linux.
+     */
+    inline std::vector<int> allowed_cpus()
+    {
+      std::vector<int> cpus;
+#if defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (sched_getaffinity(0, sizeof(set), &set) == 0)
+      {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+          if (CPU_ISSET(cpu, &set))
+          {
+            cpus.push_back(cpu);
+          }
+        }
+      }
+#endif
+      return cpus;
+    }
+
+    /**
+     * @brief Get the allowed CPUs of each NUMA node, leaving out the nodes that have none.
+     *
+     * The nodes are the ones listed as online, which may not be numbered one after another.
+     * If the nodes can't be found, all the allowed CPUs are put in one node.
+     *
+     * @param root The directory of the nodes in sysfs.
+     */
+    inline std::vector<std::vector<int>> numa_nodes(const std::string &root = "/sys/devices/system/node")
+    {
+      const std::vector<int> allowed = allowed_cpus();
+      std::vector<std::vector<int>> nodes;
+      std::ifstream online{root + "/online"};
+      std::string line;
+      std::getline(online, line);
+      for (int node : parse_cpu_list(line))
+      {
+        std::ifstream file{root + "/node" + std::to_string(node) + "/cpulist"};
+        line.clear();
+        std::getline(file, line);
+        std::vector<int> cpus;
+        for (int cpu : parse_cpu_list(line))
+        {
+          if (std::binary_search(allowed.begin(), allowed.end(), cpu))
+          {
+            cpus.push_back(cpu);
+          }
+        }
+        if (!cpus.empty())
+        {
+          nodes.push_back(std::move(cpus));
+        }
+      }
+      if (nodes.empty() && !allowed.empty())
+      {
+        nodes.push_back(allowed);
+      }
+      return nodes;
+    }
+
+    /**
+     * @brief Pin current thread to a CPU.
+     *
+     * @return 0, or the error number if it fails. It's ENOTSUP on a system other than Linux.
+     */
+    inline int pin_current_thread(int cpu)
+    {
+#if defined(__linux__)
+      if (cpu < 0 || cpu >= CPU_SETSIZE)
+      {
+        return EINVAL;
+      }
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+      (void)cpu;
+      return ENOTSUP;
+#endif
+    }
+
+    /**
+     * @brief The error thrown when a thread can't be pinned to a CPU.
+     */
+    inline std::system_error pin_error(int error, int cpu)
+    {
+      return std::system_error{error, std::generic_category(), "kie::context can't pin a thread to CPU " + std::to_string(cpu)};
+    }
+  }
+
+  /** @brief Where the threads of kie::context run.
+   *
+   * By default the threads are not pinned, and the scheduler may move them between CPUs and NUMA
+   * nodes. Pin them to keep the handlers of each io_context on one CPU, so the caches stay warm.
+   *
+   * Linux allocates the pages on the node of the CPU that first touches them. Give the placement to
+   * the constructor of kie::context, so each io_context, with its scheduler, load counter and
+   * metrics, is constructed on a thread pinned to the CPU of the io_context, and `run` pins the
+   * threads the same way by default. What the handlers allocate, like the free lists of
+   * `recycling_allocator`, is then node-local too. The reactor of an io_context is made with its
+   * first I/O object, so it's on the node of the thread that makes that object.
+   *
+   * @code
+   * kie::context ctx{16, kie::placement::spread()};
+   * ctx.run();
+   * @endcode
+   *
+   * Placement is only done on Linux, and the threads are not pinned elsewhere. The CPUs that the
+   * process may not run on, like the ones outside of its cpuset, are never taken by the policies,
+   * and kie::context throws `std::system_error` if a thread can't be pinned to a CPU of the list.
+   */
+  class placement
+  {
+  public:
+    /**
+     * @brief How the CPUs are chosen.
+     */
+    enum class policy
+    {
+      /// Do not pin the threads.
+      none,
+      /// Pin thread i to the ith allowed CPU.
+      per_core,
+      /// Put the threads on the NUMA nodes in turn, so they spread across all the nodes.
+      spread,
+      /// Fill the CPUs of one NUMA node before the next one, so the threads share as few nodes as possible.
+      compact,
+      /// Pin thread i to the ith CPU of a given list.
+      cpu_list,
+    };
+
+  private:
+    policy kind = policy::none;
+    std::vector<int> list;
+
+    placement(policy kind, std::vector<int> list) : kind(kind), list(std::move(list)) {}
+
+  public:
+    /**
+     * @brief The placement that does not pin the threads.
+     */
+    placement() = default;
+
+    /**
+     * @brief Do not pin the threads.
+     */
+    static placement none()
+    {
+      return {};
+    }
+
+    /**
+     * @brief Pin thread i to the ith allowed CPU, starting over when there are more threads than CPUs.
+     */
+    static placement per_core()
+    {
+      return {policy::per_core, {}};
+    }
+
+    /**
+     * @brief Put thread i on NUMA node i in turn, each on its own CPU of the node.
+     */
+    static placement spread()
+    {
+      return {policy::spread, {}};
+    }
+
+    /**
+     * @brief Put the threads on the CPUs of the first NUMA node, then the next one when it's full.
+     */
+    static placement compact()
+    {
+      return {policy::compact, {}};
+    }
+
+    /**
+     * @brief Pin thread i to `cpus[i % cpus.size()]`. An empty list does not pin the threads.
+     *
+     * @param cpus The CPUs, as numbered by the system.
+     */
+    static placement cpus(std::vector<int> cpus)
+    {
+      return {cpus.empty() ? policy::none : policy::cpu_list, std::move(cpus)};
+    }
+
+    /**
+     * @brief Get the policy.
+     */
+    policy get_policy() const
+    {
+      return kind;
+    }
+
+    /**
+     * @brief Get the CPU of each thread.
+     *
+     * It reads the NUMA topology of the system, so it should be called once for all the threads.
+     *
+     * @param thread_count How many threads are placed.
+     *
+     * @return The CPU of thread i at index i. It's empty if the threads are not pinned, or the system is not Linux.
+     */
+    std::vector<int> assign(std::size_t thread_count) const
+    {
+      std::vector<int> order;
+      switch (kind)
+      {
+      case policy::per_core:
+        order = impl::allowed_cpus();
+        break;
+      case policy::compact:
+        for (const auto &node : impl::numa_nodes())
+        {
+          order.insert(order.end(), node.begin(), node.end());
+        }
+        break;
+      case policy::spread:
+      {
+        const auto nodes = impl::numa_nodes();
+        for (std::size_t i = 0;; i++)
+        {
+          const std::size_t size = order.size();
+          for (const auto &node : nodes)
+          {
+            if (i < node.size())
+            {
+              order.push_back(node[i]);
+            }
+          }
+          if (order.size() == size)
+          {
+            break;
+          }
+        }
+        break;
+      }
+      case policy::cpu_list:
+#if defined(__linux__)
+        order = list;
+#endif
+        break;
+      default:
+        break;
+      }
+      if (order.empty())
+      {
+        return {};
+      }
+
+      std::vector<int> cpus(thread_count);
+      for (std::size_t i = 0; i < thread_count; i++)
+      {
+        cpus[i] = order[i % order.size()];
+      }
+      return cpus;
+    }
+  };
+
+} // namespace kie
+
+#endif
@@ -0,0 +1,365 @@
+/**
+ * @file work_stealing.hpp
+ * @author Kie
+ *
+ * Define the kie::work_stealing_executor, which runs CPU-bound tasks on the threads
+ * of a kie::context, and lets the idle threads steal the tasks of the busy ones.
+ */
+
+#ifndef KIE_TOOLBOX_CONTEXT_WORK_STEALING_HPP
+#define KIE_TOOLBOX_CONTEXT_WORK_STEALING_HPP
+
+#include <boost/asio.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.hpp"
+#include "context.hpp"
+
+/**
+ * @brief context is in kie namespace
+ *
+ *
+ */
+namespace kie
+{
+
+  /**
+   * @brief This namespace contains some class used internally.
+   *
+   */
+  namespace impl
+  {
+    /**
+     * @brief A callable that can be moved but not copied, so the task may hold move-only state.
+     *
+     * It's allocated from the free lists of current thread.
+     */
+    class unique_task
+    {
+      struct base : recycling_new
+      {
+        virtual ~base() = default;
+        virtual void run() = 0;
+      };
+
+      template <typename F>
+      struct holder : base
+      {
+        F f;
+
+        explicit holder(F &&f) : f(std::move(f)) {}
+
+        void run() override
+        {
+          f();
+        }
+      };
+
+      std::unique_ptr<base> ptr;
+
+    public:
+      unique_task() = default;
+
+      template <typename F>
+      explicit unique_task(F &&f) : ptr(std::make_unique<holder<std::decay_t<F>>>(std::decay_t<F>(std::forward<F>(f)))) {}
+
+      void operator()()
+      {
+        ptr->run();
+      }
+    };
+  }
+
+  /**
+   * @brief The options of the work_stealing_executor.
+   *
+   */
+  struct work_stealing_options
+  {
+    /// How many tasks a thread runs in a row before it lets the handlers of its io_context run.
+    std::size_t batch = 32;
+  };
+
+  /** @brief Run CPU-bound tasks on the threads of a kie::context, and balance them between the threads.
+   *
+   * Each io_context of the context gets a queue of tasks. A task is queued on the io_context of the
+   * thread that posts it, or the next one in turn if it's not posted from a thread of the context.
+   * The tasks are run by a handler that is posted to the io_context, so they take turns with the
+   * I/O handlers there. When a thread runs out of its own tasks, it steals from the other queues,
+   * and posting a task wakes one more thread that has nothing queued to steal it. So a task does
+   * not wait behind a slow handler while the other threads are idle.
+   *
+   * The I/O objects stay on the io_context they are created with, only the tasks posted here move.
+   * This class is non-movable and non-copyable, and it must live until the context is stopped.
+   *
+   * @code
+   * kie::context ctx{8};
+   * kie::work_stealing_executor cpu{ctx};
+   *
+   * // in a handler of a socket:
+   * cpu.post([&socket, request]{
+   *   auto response = render(request);
+   *   boost::asio::post(socket.get_executor(), [&socket, response]{ ... });
+   * });
+   * @endcode
+   *
+   */
+  class work_stealing_executor
+  {
+    struct alignas(64) worker
+    {
+      boost::asio::io_context *ctx = nullptr;
+      std::mutex mutex;
+      std::deque<impl::unique_task> tasks;
+      /// True if a handler that drains the tasks is posted to ctx and not finished yet.
+      std::atomic<bool> scheduled{false};
+    };
+
+    std::unique_ptr<worker[]> workers;
+    std::size_t size;
+    work_stealing_options options;
+    /// How many tasks are queued and not taken yet.
+    std::atomic<std::size_t> pending{0};
+    std::atomic<std::size_t> next{0};
+
+    inline static thread_local const work_stealing_executor *current_executor = nullptr;
+    inline static thread_local std::size_t current_idx = 0;
+
+  private:
+    /**
+     * @brief Set the worker of current thread while it drains, and decide what to do after.
+     *
+     */
+    struct drain_scope
+    {
+      work_stealing_executor &self;
+      std::size_t idx;
+      const work_stealing_executor *last_executor;
+      std::size_t last_idx;
+      bool drained = false;
+
+      drain_scope(work_stealing_executor &self, std::size_t idx)
+          : self(self), idx(idx), last_executor(current_executor), last_idx(current_idx)
+      {
+        current_executor = &self;
+        current_idx = idx;
+      }
+
+      ~drain_scope()
+      {
+        current_executor = last_executor;
+        current_idx = last_idx;
+        if (drained)
+        {
+          self.go_idle(idx);
+        }
+        else
+        {
+          // the batch is used up or a task has thrown, so the rest is left to a new handler.
+          self.post_drain(idx);
+        }
+      }
+    };
+
+    /**
+     * @brief Find the worker whose io_context runs in current thread.
+     *
+     * @return The index of the worker, or size if there is none.
+     */
+    std::size_t local_worker() const
+    {
+      if (current_executor == this)
+      {
+        return current_idx;
+      }
+      for (std::size_t i = 0; i < size; i++)
+      {
+        if (workers[i].ctx->get_executor().running_in_this_thread())
+        {
+          return i;
+        }
+      }
+      return size;
+    }
+
+    void post_drain(std::size_t idx)
+    {
+      boost::asio::post(*workers[idx].ctx, bind_recycling_allocator([this, idx]
+                                                                    { drain(idx); }));
+    }
+
+    /**
+     * @brief Post a handler to drain the tasks if there is none yet.
+     *
+     * @return True if the handler is posted.
+     */
+    bool schedule(std::size_t idx)
+    {
+      std::atomic<bool> &scheduled = workers[idx].scheduled;
+      if (scheduled.load() || scheduled.exchange(true))
+      {
+        return false;
+      }
+      post_drain(idx);
+      return true;
+    }
+
+    /**
+     * @brief Mark the worker idle, unless some task has been queued in the meantime.
+     *
+     */
+    void go_idle(std::size_t idx)
+    {
+      workers[idx].scheduled.store(false);
+      if (pending.load() != 0)
+      {
+        schedule(idx);
+      }
+    }
+
+    /**
+     * @brief Take the oldest task of the worker's own queue.
+     *
+     */
+    bool pop(std::size_t idx, impl::unique_task &task)
+    {
+      worker &w = workers[idx];
+      std::lock_guard lock{w.mutex};
+      if (w.tasks.empty())
+      {
+        return false;
+      }
+      task = std::move(w.tasks.front());
+      w.tasks.pop_front();
+      pending.fetch_sub(1);
+      return true;
+    }
+
+    /**
+     * @brief Take the oldest task of another queue.
+     *
+     * The oldest one is taken rather than the newest, since it's the one that has waited the longest.
+     */
+    bool steal(std::size_t idx, impl::unique_task &task)
+    {
+      for (std::size_t n = 1; n < size && pending.load() != 0; n++)
+      {
+        worker &victim = workers[(idx + n) % size];
+        std::lock_guard lock{victim.mutex};
+        if (!victim.tasks.empty())
+        {
+          task = std::move(victim.tasks.front());
+          victim.tasks.pop_front();
+          pending.fetch_sub(1);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void drain(std::size_t idx)
+    {
+      drain_scope scope{*this, idx};
+      impl::unique_task task;
+      for (std::size_t n = 0; n < options.batch; n++)
+      {
+        if (!pop(idx, task) && !steal(idx, task))
+        {
+          scope.drained = true;
+          return;
+        }
+        task();
+      }
+    }
+
+  public:
+    /**
+     * @brief Create a queue for each io_context of the context. It may throw exception when memory allocation fails.
+     *
+     * @param ctx The context whose threads run the tasks. It should live longer than this.
+     * @param options The options of how the tasks are run.
+     */
+    explicit work_stealing_executor(context &ctx, const work_stealing_options &options = {})
+        : workers(std::make_unique<worker[]>(ctx.get_all().size())), size(ctx.get_all().size()), options(options)
+    {
+      if (this->options.batch == 0)
+      {
+        this->options.batch = 1;
+      }
+      for (std::size_t i = 0; i < size; i++)
+      {
+        workers[i].ctx = ctx.get_all()[i].get();
+      }
+    }
+
+    /**
+     * @brief Copy constructor is deleted.
+     *
+     * Copying is not allowed.
+     */
+    work_stealing_executor(const work_stealing_executor &) = delete;
+
+    /**
+     * @brief Move constructor is deleted.
+     *
+     * Moving is not allowed.
+     */
+    work_stealing_executor(work_stealing_executor &&) = delete;
+
+    /**
+     * @brief Queue a task to run on one of the threads of the context.
+     *
+     * It never runs the task inside the call. The task should be CPU-bound, and post its result
+     * back to the io_context of the I/O objects it touches.
+     *
+     * @param f The task. It's called with no argument, and it may be move-only.
+     */
+    template <typename F>
+    void post(F &&f)
+    {
+      std::size_t idx = local_worker();
+      const bool draining = current_executor == this;
+      if (idx == size)
+      {
+        idx = next.fetch_add(1, std::memory_order_relaxed) % size;
+      }
+
+      {
+        worker &w = workers[idx];
+        std::lock_guard lock{w.mutex};
+        w.tasks.emplace_back(std::forward<F>(f));
+        pending.fetch_add(1);
+      }
+
+      if (!draining)
+      {
+        schedule(idx);
+      }
+      // the owner may be held up by a slow handler, so wake a thread that has nothing queued to steal it.
+      for (std::size_t n = 1; n < size; n++)
+      {
+        if (schedule((idx + n) % size))
+        {
+          break;
+        }
+      }
+    }
+
+    /**
+     * @brief Get how many tasks are queued and not started yet.
+     *
+     */
+    std::size_t queued() const
+    {
+      return pending.load(std::memory_order_relaxed);
+    }
+  };
+
+} // namespace kie
+
+#endif
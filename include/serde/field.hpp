@@ -3,6 +3,7 @@
 
 #include <type_traits>
 #include <algorithm>
+#include <string_view>
 
 
 /** @brief the main namespace of this library
@@ -83,9 +84,8 @@ namespace kie::serde
          * 
          */
         template<typename U> requires std::is_same_v<T, std::decay_t<U>>
-        Field(U&& v)
+        Field(U&& v) : value(std::forward<U>(v))
         {
-            value = std::forward<U>(v);
         }
 
 
@@ -94,18 +94,17 @@ namespace kie::serde
          * Nothing special. Just a copy constructor and copy the value to this.
          * 
          */
-        Field(const Field &v)
+        Field(const Field &v) : value(v.value)
         {
-            value = v.value;
         }
 
         /** @brief The move constructor
          * 
          * Nothing special. Just a move constructor and move the value to this.
+         * The value is move constructed, so an allocator-aware value keeps its allocator.
          */
-        Field(Field &&v)
+        Field(Field &&v) noexcept(std::is_nothrow_move_constructible_v<T>) : value(std::move(v.value))
         {
-            value = std::move(v.value);
         }
 
         /** @brief The copy assignment operator.
@@ -125,7 +124,7 @@ namespace kie::serde
          * Nothing special. Just a move assignment operator and move the value to this.
          * 
          */
-        Field &operator=(Field &&v)
+        Field &operator=(Field &&v) noexcept(std::is_nothrow_move_assignable_v<T>)
         {
             value = std::move(v.value);
             return *this;
@@ -196,6 +195,25 @@ namespace kie::serde
         {
         };
 
+        /** @brief Get the tag of a field type at compile time.
+         * 
+         * Unlike `Field::tag()`, it does not need an instance, so it can be used to
+         * build some table over all the fields of a class at compile time.
+         */
+        template <typename T>
+        struct field_tag
+        {
+        };
+
+        /** @brief Get the tag of a field type at compile time.
+         * 
+         */
+        template <typename T, StringLiteral str>
+        struct field_tag<Field<T, str>>
+        {
+            static constexpr std::string_view value = str.to_string_view();
+        };
+
     } //namespace type_trait
 
 } // namespace kie::serde
@@ -0,0 +1,188 @@
+#ifndef KIE_TOOLBOX_SERDE_LAZY_HPP
+#define KIE_TOOLBOX_SERDE_LAZY_HPP
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde
+{
+    /** @brief A value that is kept as raw text when it's read, and only deserialized on first access.
+     *
+     * It's used as the type of a Field that holds a large sub-object which is seldom read. Reading
+     * the message only checks the sub-object and copies its text, and the cost of building T is paid
+     * on the first access, if there is one. When the message is written back, the text is copied
+     * verbatim unless the value has been replaced or taken by `modify`. Reading the value, through
+     * a const or non-const Lazy, keeps the text.
+     *
+     * Usage:
+     * @code
+     * struct Message
+     * {
+     *     Field<std::string, "route"> route;
+     *     Field<Lazy<Payload>, "payload"> payload;
+     * };
+     *
+     * auto message = kie::serde_json::from_json<Message>(json_str);
+     * forward(message.route.value, kie::serde_json::to_json_string(message)); // payload is never parsed
+     * const Payload &payload = *message.payload.value;                         // parsed here, once, and the text is kept
+     * message.payload.value.modify().id = 2;                                   // the value is written from now on
+     * @endcode
+     *
+     * Only serde_json reads and writes the raw text for now. Other backends, like serde_msgpack,
+     * read and write the value as if the Field held T. The first access changes the cache,
+     * even through a const reference, so it's not thread-safe. T should not hold `std::string_view`,
+     * as they would point into the raw text of this very object.
+     *
+     * @param T The type of the value.
+     */
+    template <typename T>
+    class Lazy
+    {
+    public:
+        using Type = T;
+
+        /** @brief The function that deserializes the raw text into the value.
+         *
+         * It's given by the backend that reads the raw text, and may throw as that backend does.
+         */
+        using parser = void (*)(std::string_view raw, T &value);
+
+    private:
+        std::string raw_text;
+        mutable T cached{};
+        /// Not null if the raw text is not parsed yet.
+        mutable parser parse = nullptr;
+        /// True if the raw text is the same as the value.
+        bool raw_valid = false;
+
+        void ensure_parsed() const
+        {
+            if (parse != nullptr)
+            {
+                parse(raw_text, cached);
+                parse = nullptr;
+            }
+        }
+
+    public:
+        /** @brief The default constructor. It holds a value-initialized T.
+         *
+         */
+        Lazy() = default;
+
+        /** @brief Hold a value that is already built.
+         *
+         */
+        Lazy(T value) : cached(std::move(value))
+        {
+        }
+
+        /** @brief Replace the value. The raw text is dropped.
+         *
+         */
+        Lazy &operator=(T value)
+        {
+            cached = std::move(value);
+            parse = nullptr;
+            raw_valid = false;
+            return *this;
+        }
+
+        /** @brief Keep the raw text of the value, which will be parsed by `parse` on first access.
+         *
+         * It's called by the backend when it reads the value. The memory of the raw text is reused.
+         *
+         */
+        void assign_raw(std::string_view raw, parser parse_raw)
+        {
+            raw_text.assign(raw);
+            parse = parse_raw;
+            raw_valid = true;
+        }
+
+        /** @brief Check if the value has been parsed, or never came from raw text.
+         *
+         */
+        bool parsed() const
+        {
+            return parse == nullptr;
+        }
+
+        /** @brief Check if the raw text can be written back as it is.
+         *
+         * It's true from reading until the value is accessed for modification.
+         */
+        bool has_raw() const
+        {
+            return raw_valid;
+        }
+
+        /** @brief The raw text of the value. It's only meaningful if `has_raw()` is true.
+         *
+         */
+        std::string_view raw() const
+        {
+            return raw_text;
+        }
+
+        /** @brief Get the value, and parse it if it's the first access.
+         *
+         * The raw text is still written back after this.
+         */
+        const T &get() const
+        {
+            ensure_parsed();
+            return cached;
+        }
+
+        /** @brief Get the value for modification, and parse it if it's the first access.
+         *
+         * The value is written instead of the raw text after this.
+         */
+        T &modify()
+        {
+            ensure_parsed();
+            raw_valid = false;
+            return cached;
+        }
+
+        const T &operator*() const
+        {
+            return get();
+        }
+
+        const T *operator->() const
+        {
+            return &get();
+        }
+    };
+
+    namespace type_trait
+    {
+        /** @brief Check if type T is a `Lazy`.
+         *
+         */
+        template <typename T>
+        struct is_lazy : std::false_type
+        {
+        };
+
+        /** @brief Check if type T is a `Lazy`.
+         *
+         */
+        template <typename T>
+        struct is_lazy<Lazy<T>> : std::true_type
+        {
+        };
+    }
+
+} // namespace kie::serde
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef KIE_TOOLBOX_SERDE_OPTIONAL_FIELD_HPP
+#define KIE_TOOLBOX_SERDE_OPTIONAL_FIELD_HPP
+
+#include <optional>
+#include <type_traits>
+
+#include "field.hpp"
+#include "type_trait.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde
+{
+    /** @brief A Field whose key may be missing from the input, and which keeps its default value then.
+     *
+     * The default value is the one a new object has, so it's given by the default member initializer.
+     * It's written as usual.
+     *
+     * Usage:
+     * @code
+     * struct Config
+     * {
+     *     Field<std::string, "host"> host;
+     *     OptionalField<int, "port"> port = 8080;     // 8080 if "port" is missing
+     *     Field<std::optional<int>, "timeout"> timeout; // std::nullopt if "timeout" is missing or null
+     * };
+     * @endcode
+     *
+     * A Field of `std::optional` may be missing as well, and it's `std::nullopt` then.
+     *
+     * @param T The type of field which is held by OptionalField
+     * @param _tag The tag of this field. Used to represent the name of this field.
+     */
+    template <typename T, StringLiteral _tag>
+    struct OptionalField : Field<T, _tag>
+    {
+        using Field<T, _tag>::Field;
+        using Field<T, _tag>::operator=;
+
+        /** @brief The default constructor.
+         *
+         */
+        OptionalField() = default;
+    };
+
+    namespace type_trait
+    {
+        /** @brief An `OptionalField` is a field as well.
+         *
+         */
+        template <typename T, StringLiteral str>
+        struct is_field<OptionalField<T, str>> : std::true_type
+        {
+        };
+
+        /** @brief Get the tag of an `OptionalField` type at compile time.
+         *
+         */
+        template <typename T, StringLiteral str>
+        struct field_tag<OptionalField<T, str>>
+        {
+            static constexpr std::string_view value = str.to_string_view();
+        };
+
+        /** @brief Check if the key of Field type T may be missing from the input.
+         *
+         * It's true for `OptionalField`, and for a Field that holds a `std::optional`.
+         */
+        template <typename T>
+        struct is_optional_field : std::bool_constant<is_specialization_of<typename T::Type, std::optional>::value>
+        {
+        };
+
+        /** @brief Check if the key of Field type T may be missing from the input.
+         *
+         */
+        template <typename T, StringLiteral str>
+        struct is_optional_field<OptionalField<T, str>> : std::true_type
+        {
+        };
+    }
+
+} // namespace kie::serde
+
+#endif
@@ -0,0 +1,395 @@
+#ifndef KIE_TOOLBOX_SERDE_REFLECTION_HPP
+#define KIE_TOOLBOX_SERDE_REFLECTION_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <boost/pfr.hpp>
+
+#include "field.hpp"
+#include "optional_field.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde
+{
+    /** @brief This namespace contains the compile time information about the Fields of an aggregate.
+     *
+     * Every format backend needs to know which members of a class are Fields and what their tags are.
+     * All of them are known at compile time, so they are computed here once with the help of pfr and
+     * can be shared by all the backends.
+     *
+     */
+    namespace reflection
+    {
+        /** @brief Check if the I-th member of T is a Field.
+         *
+         */
+        template <typename T, std::size_t I>
+        constexpr bool is_field_member = type_trait::is_field<boost::pfr::tuple_element_t<I, T>>::value;
+
+        /** @brief Get the tag of the I-th member of T. It's empty if the member is not a Field.
+         *
+         */
+        template <typename T, std::size_t I>
+        constexpr std::string_view member_tag()
+        {
+            if constexpr (is_field_member<T, I>)
+            {
+                return type_trait::field_tag<boost::pfr::tuple_element_t<I, T>>::value;
+            }
+            else
+            {
+                return {};
+            }
+        }
+
+        /** @brief A perfect hash table over N distinct strings known at compile time.
+         *
+         * It's built with "hash and displace": the keys are put into buckets by their hash, and
+         * for each bucket a displacement is searched at compile time so that all the keys of all the
+         * buckets land in different slots. Finding a key costs one pass over its bytes, two array
+         * reads and one string comparison, and never allocates.
+         *
+         * @param N The number of keys.
+         */
+        template <std::size_t N>
+        class perfect_hash
+        {
+            static_assert(N < 0xFFFF, "too many keys for perfect_hash");
+
+            static constexpr std::size_t bucket_count = std::bit_ceil(N / 2 + 1);
+            static constexpr std::size_t slot_count = std::bit_ceil(N) * 2;
+
+            std::array<std::string_view, N> keys{};
+            std::array<std::uint32_t, bucket_count> displacement{};
+            // position of the key plus one, zero for an empty slot.
+            std::array<std::uint16_t, slot_count> slots{};
+
+            static constexpr std::uint64_t hash(std::string_view key)
+            {
+                std::uint64_t h = 0xcbf29ce484222325ull;
+                for (char c : key)
+                {
+                    h ^= static_cast<unsigned char>(c);
+                    h *= 0x100000001b3ull;
+                }
+                return h;
+            }
+
+            static constexpr std::uint64_t mix(std::uint64_t h, std::uint64_t seed)
+            {
+                h ^= seed * 0x9e3779b97f4a7c15ull;
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdull;
+                h ^= h >> 33;
+                return h;
+            }
+
+        public:
+            /** @brief Whether the table is built successfully. It fails only if two keys are the same.
+             *
+             */
+            bool valid = true;
+
+            constexpr explicit perfect_hash(const std::array<std::string_view, N> &keys) : keys(keys)
+            {
+                std::array<std::uint64_t, N> hashes{};
+                std::array<std::size_t, N> bucket_of{};
+                std::array<std::size_t, bucket_count> bucket_size{};
+                for (std::size_t i = 0; i < N; i++)
+                {
+                    hashes[i] = hash(keys[i]);
+                    bucket_of[i] = mix(hashes[i], 0) & (bucket_count - 1);
+                    bucket_size[bucket_of[i]]++;
+                }
+
+                // the biggest bucket is the hardest one to place, so it goes first.
+                std::array<bool, bucket_count> placed{};
+                for (std::size_t round = 0; round < bucket_count; round++)
+                {
+                    std::size_t bucket = bucket_count;
+                    for (std::size_t b = 0; b < bucket_count; b++)
+                    {
+                        if (!placed[b] && (bucket == bucket_count || bucket_size[b] > bucket_size[bucket]))
+                        {
+                            bucket = b;
+                        }
+                    }
+                    placed[bucket] = true;
+                    if (bucket_size[bucket] == 0)
+                    {
+                        continue;
+                    }
+
+                    bool found = false;
+                    for (std::uint32_t seed = 1; seed < 0x10000 && !found; seed++)
+                    {
+                        auto candidate = slots;
+                        found = true;
+                        for (std::size_t i = 0; i < N && found; i++)
+                        {
+                            if (bucket_of[i] != bucket)
+                            {
+                                continue;
+                            }
+                            auto &slot = candidate[mix(hashes[i], seed) & (slot_count - 1)];
+                            found = slot == 0;
+                            slot = static_cast<std::uint16_t>(i + 1);
+                        }
+                        if (found)
+                        {
+                            slots = candidate;
+                            displacement[bucket] = seed;
+                        }
+                    }
+                    valid = valid && found;
+                }
+            }
+
+            /** @brief Find the position of key.
+             *
+             * @return The position of key in the array the table is built from, or N if key is not there.
+             */
+            constexpr std::size_t find(std::string_view key) const
+            {
+                const std::uint64_t h = hash(key);
+                const std::size_t slot = slots[mix(h, displacement[mix(h, 0) & (bucket_count - 1)]) & (slot_count - 1)];
+                return slot != 0 && keys[slot - 1] == key ? slot - 1 : N;
+            }
+        };
+
+        /** @brief The Fields of aggregate T, ordered by tag.
+         *
+         * The order is the same with the order of keys in a json object (which is a `std::map`), so
+         * a serializer walking `index` emits keys in the same order as `nlohmann::json` does. If two
+         * Fields share the same tag, only the last one is kept, because it's the one that wins when
+         * they are assigned to the same key one by one. The earlier ones are listed in `hidden`, so
+         * a reader can give them the value of the key as well, just like `from_json` does.
+         *
+         * Usage:
+         * @code
+         * for (auto i : kie::serde::reflection::fields<A>::index) { ... }
+         * @endcode
+         *
+         * @param T An aggregate type.
+         */
+        template <typename T>
+        struct fields
+        {
+        private:
+            static constexpr std::size_t member_count = boost::pfr::tuple_size_v<T>;
+
+            static constexpr std::array<std::string_view, member_count> member_tags = []<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return std::array<std::string_view, member_count>{member_tag<T, I>()...};
+            }(std::make_index_sequence<member_count>{});
+
+            static constexpr std::array<bool, member_count> member_is_field = []<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return std::array<bool, member_count>{is_field_member<T, I>...};
+            }(std::make_index_sequence<member_count>{});
+
+            /** @brief The member indices of the Fields ordered by tag, without duplicated tags, and the count of them.
+             *
+             */
+            static constexpr std::pair<std::array<std::size_t, member_count>, std::size_t> sorted = []
+            {
+                std::array<std::size_t, member_count> result{};
+                std::size_t size = 0;
+                for (std::size_t i = 0; i < member_count; i++)
+                {
+                    if (!member_is_field[i])
+                    {
+                        continue;
+                    }
+                    // insertion sort, it's stable so the declaration order is kept for the same tag.
+                    std::size_t j = size++;
+                    for (; j > 0 && member_tags[i] < member_tags[result[j - 1]]; j--)
+                    {
+                        result[j] = result[j - 1];
+                    }
+                    result[j] = i;
+                }
+
+                // only keep the last one of the same tag.
+                std::size_t unique = 0;
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    if (i + 1 < size && member_tags[result[i]] == member_tags[result[i + 1]])
+                    {
+                        continue;
+                    }
+                    result[unique++] = result[i];
+                }
+                return std::pair{result, unique};
+            }();
+
+        public:
+            /** @brief How many Fields will be (de)serialized.
+             *
+             */
+            static constexpr std::size_t size = sorted.second;
+
+            /** @brief The member index (the one used by `boost::pfr::get`) of each Field, ordered by tag.
+             *
+             */
+            static constexpr std::array<std::size_t, size> index = []
+            {
+                std::array<std::size_t, size> result{};
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    result[i] = sorted.first[i];
+                }
+                return result;
+            }();
+
+            /** @brief The tag of each Field, in the same order with `index`.
+             *
+             */
+            static constexpr std::array<std::string_view, size> tags = []
+            {
+                std::array<std::string_view, size> result{};
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    result[i] = member_tags[index[i]];
+                }
+                return result;
+            }();
+
+            /** @brief The member indices of the Fields hidden by the Kth one, which have the same tag and are declared before it.
+             *
+             */
+            template <std::size_t K>
+            static constexpr auto hidden = []
+            {
+                constexpr std::size_t count = []
+                {
+                    std::size_t n = 0;
+                    for (std::size_t i = 0; i < index[K]; i++)
+                    {
+                        n += member_is_field[i] && member_tags[i] == tags[K] ? 1 : 0;
+                    }
+                    return n;
+                }();
+                std::array<std::size_t, count> result{};
+                std::size_t n = 0;
+                for (std::size_t i = 0; i < index[K]; i++)
+                {
+                    if (member_is_field[i] && member_tags[i] == tags[K])
+                    {
+                        result[n++] = i;
+                    }
+                }
+                return result;
+            }();
+
+            /** @brief Whether each Field must be present in the input, in the same order with `index`.
+             *
+             * It's false for `OptionalField` and the Fields of `std::optional`, unless a Field it hides is not one of them.
+             */
+            static constexpr std::array<bool, size> required = []<std::size_t... K>(std::index_sequence<K...>)
+            {
+                constexpr auto tag_required = []<std::size_t P>()
+                {
+                    return []<std::size_t... J>(std::index_sequence<J...>)
+                    {
+                        return (!type_trait::is_optional_field<boost::pfr::tuple_element_t<index[P], T>>::value || ... ||
+                                !type_trait::is_optional_field<boost::pfr::tuple_element_t<hidden<P>[J], T>>::value);
+                    }(std::make_index_sequence<hidden<P>.size()>{});
+                };
+                return std::array<bool, size>{tag_required.template operator()<K>()...};
+            }(std::make_index_sequence<size>{});
+
+        private:
+            static constexpr perfect_hash<size> table{tags};
+            static_assert(table.valid, "failed to build the perfect hash of the tags");
+
+        public:
+            /** @brief Find the position of key in `tags` (and `index`) in constant time.
+             *
+             * @return The position, or `size` if key is not the tag of any Field.
+             */
+            static constexpr std::size_t find(std::string_view key)
+            {
+                return table.find(key);
+            }
+        };
+
+        /** @brief Find the first Field that must be present but is not seen, in the order of declaration.
+         *
+         * @param seen Whether each Field is found in the input, in the same order with `fields<T>::index`.
+         * @return The position in `fields<T>::index`, or `fields<T>::size` if nothing is missing.
+         */
+        template <typename T>
+        constexpr std::size_t find_missing(const std::array<bool, fields<T>::size> &seen)
+        {
+            using F = fields<T>;
+            std::size_t missing = F::size;
+            for (std::size_t k = 0; k < F::size; k++)
+            {
+                if (!seen[k] && F::required[k] && (missing == F::size || F::index[k] < F::index[missing]))
+                {
+                    missing = k;
+                }
+            }
+            return missing;
+        }
+
+        /** @brief Give the Kth Field of t, and the Fields it hides, the value that fresh has.
+         *
+         */
+        template <typename T, std::size_t K>
+        void reset_tag(T &t, T &fresh)
+        {
+            using F = fields<T>;
+            [&]<std::size_t... J>(std::index_sequence<J...>)
+            {
+                ((boost::pfr::get<F::template hidden<K>[J]>(t).value = std::move(boost::pfr::get<F::template hidden<K>[J]>(fresh).value)), ...);
+            }(std::make_index_sequence<F::template hidden<K>.size()>{});
+            boost::pfr::get<F::index[K]>(t).value = std::move(boost::pfr::get<F::index[K]>(fresh).value);
+        }
+
+        /** @brief Give the optional Fields of t that are not seen in the input the value that a new T has.
+         *
+         * A new T is only built if some of them are missing, so it costs nothing when all the keys are there.
+         *
+         * @param seen Whether each Field is found in the input, in the same order with `fields<T>::index`.
+         */
+        template <typename T>
+        void reset_missing(T &t, const std::array<bool, fields<T>::size> &seen)
+        {
+            using F = fields<T>;
+            if constexpr (std::find(F::required.begin(), F::required.end(), false) != F::required.end())
+            {
+                bool any = false;
+                for (std::size_t k = 0; k < F::size; k++)
+                {
+                    any = any || (!seen[k] && !F::required[k]);
+                }
+                if (!any)
+                {
+                    return;
+                }
+                T fresh{};
+                [&]<std::size_t... K>(std::index_sequence<K...>)
+                {
+                    ((seen[K] || F::required[K] || (reset_tag<T, K>(t, fresh), true)), ...);
+                }(std::make_index_sequence<F::size>{});
+            }
+        }
+
+    } // namespace reflection
+
+} // namespace kie::serde
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef KIE_TOOLBOX_SERDE_TRACKED_FIELD_HPP
+#define KIE_TOOLBOX_SERDE_TRACKED_FIELD_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include "field.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde
+{
+    /** @brief A Field that remembers if it has been assigned since it was last written as a delta.
+     *
+     * It's read and written just like `Field`, and the backends that support deltas write only the
+     * TrackedFields that are dirty, then mark them clean. Use it for the members of a large object
+     * that is sent again and again, so each update carries only what has changed.
+     *
+     * Usage:
+     * @code
+     * struct Session
+     * {
+     *     TrackedField<int, "score"> score;
+     *     TrackedField<std::vector<Player>, "players"> players;
+     * };
+     *
+     * session.score = 10;                       // marks score dirty
+     * session.players.modify().push_back(bob);  // marks players dirty
+     * send(kie::serde_json::to_json_delta(session)); // {"players":[...],"score":10}, and both are clean again
+     * @endcode
+     *
+     * Only the assignment operators and `modify()` mark it dirty. Changing `value` directly, or
+     * through the implicit conversion to `T&`, is not seen, so call `mark_dirty()` after that.
+     * It's clean when constructed, and the readers that write into `value` in place, like
+     * `kie::serde_json::from_json` and `from_json_into`, leave the flag as it is. Assigning a whole
+     * object marks all the TrackedFields in it dirty.
+     *
+     * @param T The type of field which is held by TrackedField
+     * @param _tag The tag of this field. Used to represent the name of this field.
+     */
+    template <typename T, StringLiteral _tag>
+    struct TrackedField : Field<T, _tag>
+    {
+        using Field<T, _tag>::Field;
+
+        /** @brief The default constructor. It's clean.
+         *
+         */
+        TrackedField() = default;
+
+        /** @brief The copy constructor. The dirty flag is copied as well.
+         *
+         */
+        TrackedField(const TrackedField &) = default;
+
+        /** @brief The move constructor. The dirty flag is copied as well.
+         *
+         */
+        TrackedField(TrackedField &&) = default;
+
+        /** @brief The copy assignment operator. It marks this dirty.
+         *
+         */
+        TrackedField &operator=(const TrackedField &v)
+        {
+            this->value = v.value;
+            changed = true;
+            return *this;
+        }
+
+        /** @brief The move assignment operator. It marks this dirty.
+         *
+         */
+        TrackedField &operator=(TrackedField &&v) noexcept(std::is_nothrow_move_assignable_v<T>)
+        {
+            this->value = std::move(v.value);
+            changed = true;
+            return *this;
+        }
+
+        /** @brief The assignment operator that accepts other value. It marks this dirty.
+         *
+         * The type of parameter must be the same with T.
+         * This function can both handle lvalue and rvalue.
+         *
+         */
+        template <typename U>
+        requires std::is_same_v<T, std::decay_t<U>>
+        TrackedField &operator=(U &&v)
+        {
+            this->value = std::forward<U>(v);
+            changed = true;
+            return *this;
+        }
+
+        /** @brief Get the value for modification in place, and mark this dirty.
+         *
+         */
+        T &modify()
+        {
+            changed = true;
+            return this->value;
+        }
+
+        /** @brief Check if this has been assigned since it was last marked clean.
+         *
+         */
+        bool dirty() const
+        {
+            return changed;
+        }
+
+        /** @brief Mark this dirty, after changing `value` directly.
+         *
+         */
+        void mark_dirty()
+        {
+            changed = true;
+        }
+
+        /** @brief Mark this clean. It's called by the backend after the value is written as a delta.
+         *
+         */
+        void mark_clean()
+        {
+            changed = false;
+        }
+
+    private:
+        bool changed = false;
+    };
+
+    namespace type_trait
+    {
+        /** @brief A `TrackedField` is a field as well.
+         *
+         */
+        template <typename T, StringLiteral str>
+        struct is_field<TrackedField<T, str>> : std::true_type
+        {
+        };
+
+        /** @brief Get the tag of a `TrackedField` type at compile time.
+         *
+         */
+        template <typename T, StringLiteral str>
+        struct field_tag<TrackedField<T, str>>
+        {
+            static constexpr std::string_view value = str.to_string_view();
+        };
+
+        /** @brief Check if type T is a `TrackedField`.
+         *
+         */
+        template <typename T>
+        struct is_tracked_field : std::false_type
+        {
+        };
+
+        /** @brief Check if type T is a `TrackedField`.
+         *
+         */
+        template <typename T, StringLiteral str>
+        struct is_tracked_field<TrackedField<T, str>> : std::true_type
+        {
+        };
+    }
+
+} // namespace kie::serde
+
+#endif
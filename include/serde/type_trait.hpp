@@ -0,0 +1,140 @@
+#ifndef KIE_TOOLBOX_SERDE_TYPE_TRAIT_HPP
+#define KIE_TOOLBOX_SERDE_TYPE_TRAIT_HPP
+
+#include <array>
+#include <vector>
+#include <list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde
+{
+
+    /** @brief This namespace contains some trait used by this library at compile time.
+     *
+     * It help robust this library with some compile time check with concept.
+     * At the same time, it make some overload decision posible or simpler thanks to concept.
+     *
+     */
+    namespace type_trait
+    {
+
+        /** @brief A helper variable indicating that this is not implemented.
+         *
+         * Just a helper variable and not used for now.
+         *
+         */
+        template <class...>
+        constexpr std::false_type not_implemented{};
+
+        /** @brief Check if a class is a specialization of a template.
+         *
+         * It only applies to the template type with only type parameters. If
+         * there are non-type parameters, it fails to check.
+         *
+         */
+        template <typename T, template <typename...> class Z>
+        struct is_specialization_of : std::false_type
+        {
+        };
+
+        /** @brief Check if a class is a specialization of a template.
+         *
+         * It only applies to the template type with only type parameters. If
+         * there are non-type parameters, it fails to check.
+         *
+         */
+        template <typename... Args, template <typename...> class Z>
+        struct is_specialization_of<Z<Args...>, Z> : std::true_type
+        {
+        };
+
+        /** @brief Check if type T is `std::array`
+         *
+         * With the limitation of `is_specialization_of`, this class
+         * helps to check `std::array` because of the second parameter
+         * is non-type.
+         *
+         */
+        template <typename T>
+        struct is_array_class : std::false_type
+        {
+        };
+
+        /** @brief Check if type T is `std::array`
+         *
+         * With the limitation of `is_specialization_of`, this class
+         * helps to check `std::array` because of the second parameter
+         * is non-type.
+         *
+         */
+        template <typename T, std::size_t size>
+        struct is_array_class<std::array<T, size>> : std::true_type
+        {
+        };
+
+        /** @brief A concept checks if type T is a `container`.
+         *
+         * Container means three things here, a vector, a list and an array.
+         *
+         */
+        template <typename T>
+        concept is_container = is_specialization_of<T, std::vector>::value ||
+            is_specialization_of<T, std::list>::value ||
+            is_array_class<T>::value;
+
+        /** @brief A concept checks if type T is a `dynamic container`
+         *
+         * Dynamic container means std::vector and std::list here.
+         *
+         */
+        template <typename T>
+        concept is_dynamic_container = (is_specialization_of<T, std::vector>::value ||
+                                        is_specialization_of<T, std::list>::value) &&
+                                       requires
+        {
+            typename T::value_type;
+        };
+
+        /** @brief A concept checks if type T is a `string`.
+         *
+         * String means `std::basic_string` of char with any allocator here. It is a class, but it
+         * should be serialized as a json string instead of being looped over.
+         *
+         */
+        template <typename T>
+        concept is_string = is_specialization_of<T, std::basic_string>::value &&
+                            std::is_same_v<typename T::value_type, char>;
+
+        /** @brief A concept checks if type T is a `std::string_view`.
+         *
+         * It's read as a view into the input buffer, so it's only valid as long as the input is.
+         *
+         */
+        template <typename T>
+        concept is_string_view = std::is_same_v<T, std::string_view>;
+
+        /** @brief A concept checks if type T can be used as an output buffer.
+         *
+         * Output buffer is where the serialized text or bytes are appended to. `std::string` is the
+         * typical one, but any type that has `append(const char*, std::size_t)` and `push_back(char)`
+         * works.
+         *
+         */
+        template <typename T>
+        concept is_output_buffer = requires(T &buffer, const char *data, std::size_t size, char c)
+        {
+            buffer.append(data, size);
+            buffer.push_back(c);
+        };
+    }
+
+} // namespace kie::serde
+
+#endif
@@ -0,0 +1,349 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_ASYNC_HPP
+#define KIE_TOOLBOX_SERDE_JSON_ASYNC_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/pfr.hpp>
+#include <boost/system/error_code.hpp>
+
+
+#include "../serde/reflection.hpp"
+#include "type_trait.hpp"
+#include "writer.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief How `async_write_json` buffers the json text.
+     *
+     */
+    struct async_write_options
+    {
+        /// The bytes that a buffer is filled to before it's sent. A single item larger than this makes its buffer grow.
+        std::size_t buffer_size = 16 * 1024;
+        /// How many buffers are filled and sent together with one gathered write.
+        std::size_t buffer_count = 4;
+    };
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief Write json text piece by piece, so it can be sent before the whole text is written.
+         *
+         * The pieces end between the Fields of any aggregate and between the items of any container
+         * that can be indexed, however deep they are nested, e.g. in the items of
+         * `{"result":{"items":[...]}}`. The place to resume from is kept in a stack of frames, one
+         * for each aggregate or container being written, which holds the index of its current Field
+         * or item. The `std::list`s and the values of other types are written at once, and the text
+         * put together is the same as what `write_json` writes.
+         *
+         */
+        template <typename T>
+        class json_producer
+        {
+            const T *value;
+            write_options options;
+            /// The index of the current Field or item of each aggregate or container being written, from the outermost one.
+            std::vector<std::size_t> frames;
+
+            /** @brief Check if V is an aggregate with Fields, which is written Field by Field.
+             *
+             */
+            template <typename V>
+            static constexpr bool is_object()
+            {
+                if constexpr (std::is_class_v<V> && !type_trait::is_string<V> && !type_trait::is_string_view<V> &&
+                              !kie::serde::type_trait::is_lazy<V>::value && !type_trait::is_specialization_of<V, std::optional>::value &&
+                              !type_trait::is_container<V>)
+                {
+                    return kie::serde::reflection::fields<V>::size != 0;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            /** @brief Write the rest of a value at the depth, and stop once out holds limit bytes.
+             *
+             * @return true if the value is complete.
+             */
+            template <typename V>
+            bool produce_value(const V &v, std::size_t depth, std::string &out, std::size_t limit)
+            {
+                if constexpr (type_trait::is_specialization_of<V, std::optional>::value)
+                {
+                    if (v)
+                    {
+                        return produce_value(*v, depth, out, limit);
+                    }
+                    out.append("null", 4);
+                    return true;
+                }
+                else if constexpr (type_trait::is_container<V> && std::ranges::random_access_range<const V>)
+                {
+                    return produce_items(v, depth, out, limit);
+                }
+                else if constexpr (is_object<V>())
+                {
+                    return produce_fields(v, depth, out, limit);
+                }
+                else
+                {
+                    // there is no index to resume from, or nothing to split.
+                    write_value(v, out, options);
+                    return true;
+                }
+            }
+
+            /** @brief Write the rest of a container that can be indexed.
+             *
+             */
+            template <typename C>
+            bool produce_items(const C &c, std::size_t depth, std::string &out, std::size_t limit)
+            {
+                const std::size_t size = std::ranges::size(c);
+                if (frames.size() == depth)
+                {
+                    if (size == 0)
+                    {
+                        write_container(c, out, options);
+                        return true;
+                    }
+                    frames.push_back(0);
+                }
+                while (frames[depth] < size)
+                {
+                    const std::size_t item = frames[depth];
+                    // the item is resumed if it has a frame of its own.
+                    if (frames.size() == depth + 1)
+                    {
+                        out.push_back(item == 0 ? '[' : ',');
+                    }
+                    if (!produce_value(c[item], depth + 1, out, limit))
+                    {
+                        return false;
+                    }
+                    frames[depth] = item + 1;
+                    if (out.size() >= limit && item + 1 < size)
+                    {
+                        return false;
+                    }
+                }
+                out.push_back(']');
+                frames.pop_back();
+                return true;
+            }
+
+            /** @brief Write the rest of the Kth Field of an aggregate.
+             *
+             * @return true if the Field is complete.
+             */
+            template <typename V, std::size_t K>
+            static bool produce_field(json_producer &self, const V &v, std::size_t depth, std::string &out, std::size_t limit)
+            {
+                using fields = kie::serde::reflection::fields<V>;
+                if (self.frames.size() == depth + 1)
+                {
+                    write_key<V, K>(K == 0 ? '{' : ',', out);
+                }
+                return self.produce_value(boost::pfr::get<fields::index[K]>(v).value, depth + 1, out, limit);
+            }
+
+            /** @brief Write the rest of an aggregate with Fields.
+             *
+             */
+            template <typename V>
+            bool produce_fields(const V &v, std::size_t depth, std::string &out, std::size_t limit)
+            {
+                using fields = kie::serde::reflection::fields<V>;
+                static constexpr auto steps = []<std::size_t... K>(std::index_sequence<K...>)
+                {
+                    return std::array<bool (*)(json_producer &, const V &, std::size_t, std::string &, std::size_t), fields::size>{&produce_field<V, K>...};
+                }(std::make_index_sequence<fields::size>{});
+
+                if (frames.size() == depth)
+                {
+                    frames.push_back(0);
+                }
+                while (frames[depth] < fields::size)
+                {
+                    const std::size_t field = frames[depth];
+                    if (!steps[field](*this, v, depth, out, limit))
+                    {
+                        return false;
+                    }
+                    frames[depth] = field + 1;
+                    if (out.size() >= limit && field + 1 < fields::size)
+                    {
+                        return false;
+                    }
+                }
+                out.push_back('}');
+                frames.pop_back();
+                return true;
+            }
+
+        public:
+            json_producer(const T &t, const write_options &options) : value(&t), options(options) {}
+
+            /** @brief Append the next pieces to out, until it holds at least limit bytes or the text is complete.
+             *
+             * @return true if the text is complete.
+             */
+            bool produce(std::string &out, std::size_t limit)
+            {
+                if constexpr (type_trait::is_container<T> || is_object<T>())
+                {
+                    return produce_value(*value, 0, out, limit);
+                }
+                else
+                {
+                    write_json(*value, out, options);
+                    return true;
+                }
+            }
+        };
+
+        /** @brief The composed operation of `async_write_json`.
+         *
+         * Each round fills the buffers, then sends all of them with one gathered `async_write`, and
+         * they are reused by the next round once it completes. The first round fills only one buffer,
+         * so the first bytes are sent as early as possible.
+         *
+         */
+        template <typename Stream, typename T>
+        class async_json_write
+        {
+            struct state
+            {
+                json_producer<T> producer;
+                async_write_options options;
+                std::vector<std::string> buffers;
+                std::vector<boost::asio::const_buffer> gathered;
+                std::size_t total = 0;
+                bool started = false;
+                bool complete = false;
+            };
+
+            Stream &stream;
+            std::unique_ptr<state> s;
+
+        public:
+            async_json_write(Stream &stream, const T &t, const async_write_options &options, const write_options &write)
+                : stream(stream), s(std::make_unique<state>(state{json_producer<T>{t, write}, options}))
+            {
+                s->options.buffer_count = std::max<std::size_t>(s->options.buffer_count, 1);
+                s->buffers.resize(s->options.buffer_count);
+                s->gathered.reserve(s->options.buffer_count);
+            }
+
+            template <typename Self>
+            void operator()(Self &self, boost::system::error_code ec = {}, std::size_t written = 0)
+            {
+                if (s->started)
+                {
+                    s->total += written;
+                    if (ec)
+                    {
+                        self.complete(ec, s->total);
+                        return;
+                    }
+                }
+                const std::size_t count = s->started ? s->buffers.size() : 1;
+                s->started = true;
+
+                s->gathered.clear();
+                for (std::size_t i = 0; i < count && !s->complete; i++)
+                {
+                    std::string &buffer = s->buffers[i];
+                    buffer.clear();
+                    buffer.reserve(s->options.buffer_size);
+                    s->complete = s->producer.produce(buffer, s->options.buffer_size);
+                    s->gathered.push_back(boost::asio::buffer(buffer));
+                }
+                if (s->gathered.empty())
+                {
+                    self.complete({}, s->total);
+                    return;
+                }
+                boost::asio::async_write(stream, s->gathered, std::move(self));
+            }
+        };
+    }
+
+    /** @brief Serialize T and send it to an Asio stream as it's written, with buffers of bounded size.
+     *
+     * The json text is written into a few buffers of `buffer_size`, which are sent together with
+     * one gathered `boost::asio::async_write`, and then filled again with the text that follows.
+     * So the whole text is never held in memory, and the first bytes leave before the rest is
+     * written. The text is the same as what `write_json` writes.
+     *
+     * The text is split between the Fields of the aggregates and between the items of the containers
+     * at any depth, so the records of a batch response are streamed even when it's wrapped in an
+     * envelope like `{"result":{"items":[...]}}`. The `std::list`s are written at once, and a single
+     * string or number larger than `buffer_size` makes its buffer grow to hold it.
+     *
+     * Usage:
+     * @code
+     * kie::serde_json::async_write_json(socket, response, [](boost::system::error_code ec, std::size_t written)
+     *                                   { ... });
+     * @endcode
+     *
+     * t must not be changed or destroyed until the operation completes, and no other write may be
+     * made to the stream in the meantime, just like `boost::asio::async_write`.
+     *
+     * @param stream A stream that models AsyncWriteStream, like `boost::asio::ip::tcp::socket`.
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @param options The size and the count of the buffers.
+     * @param write Choose `number_format::shortest` for faster and shorter floating point numbers.
+     * @param token The completion token, whose signature is `void(boost::system::error_code, std::size_t)`.
+     *              The size is the count of bytes that are sent.
+     */
+    template <typename Stream, typename T, typename CompletionToken>
+    auto async_write_json(Stream &stream, const T &t, const async_write_options &options, const write_options &write, CompletionToken &&token)
+    {
+        return boost::asio::async_compose<CompletionToken, void(boost::system::error_code, std::size_t)>(
+            impl::async_json_write<Stream, T>{stream, t, options, write}, token, stream);
+    }
+
+    /** @brief Serialize T and send it to an Asio stream as it's written, with the default buffers.
+     *
+     * See above.
+     *
+     * @param stream A stream that models AsyncWriteStream, like `boost::asio::ip::tcp::socket`.
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @param token The completion token, whose signature is `void(boost::system::error_code, std::size_t)`.
+     */
+    template <typename Stream, typename T, typename CompletionToken>
+    auto async_write_json(Stream &stream, const T &t, CompletionToken &&token)
+    {
+        return async_write_json(stream, t, async_write_options{}, write_options{}, std::forward<CompletionToken>(token));
+    }
+
+} // namespace kie::serde_json
+
+#endif
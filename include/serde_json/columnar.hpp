@@ -0,0 +1,296 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_COLUMNAR_HPP
+#define KIE_TOOLBOX_SERDE_JSON_COLUMNAR_HPP
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+#include <boost/pfr.hpp>
+
+
+#include "../serde/reflection.hpp"
+#include "type_trait.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     */
+    namespace impl
+    {
+        /** @brief Check if C is a container of aggregates with Fields, which can be written column by column.
+         *
+         */
+        template <typename C>
+        concept is_columnar = type_trait::is_container<C> &&
+                              std::is_aggregate_v<typename C::value_type> && std::is_class_v<typename C::value_type> &&
+                              !type_trait::is_container<typename C::value_type> &&
+                              kie::serde::reflection::fields<typename C::value_type>::size != 0;
+
+        /** @brief Write the values of the Kth Field of all the rows as a json array.
+         *
+         */
+        template <std::size_t K, typename C, type_trait::is_output_buffer B>
+        void write_column(const C &rows, B &out, const write_options &options)
+        {
+            using fields = kie::serde::reflection::fields<typename C::value_type>;
+            char separator = '[';
+            for (const auto &row : rows)
+            {
+                out.push_back(separator);
+                separator = ',';
+                write_value(boost::pfr::get<fields::index[K]>(row).value, out, options);
+            }
+            if (separator == '[')
+            {
+                out.push_back('[');
+            }
+            out.push_back(']');
+        }
+
+        /** @brief Read a json array into the Kth Field of the rows.
+         *
+         * The first column decides how many rows there are, and the rows are added or removed to
+         * match. Every other column must have as many values.
+         *
+         * @param length The count of rows, or the max of `std::size_t` if no column is read yet.
+         */
+        template <typename C, std::size_t K>
+        bool read_column(reader &r, C &rows, std::size_t &length)
+        {
+            using T = typename C::value_type;
+            using fields = kie::serde::reflection::fields<T>;
+            constexpr std::size_t unknown = std::numeric_limits<std::size_t>::max();
+
+            value_type type = value_type::null;
+            if (!r.next_type(type))
+            {
+                return false;
+            }
+            std::size_t size = 0;
+            bool ok = true;
+            if (type != value_type::array)
+            {
+                // just like a container Field, a column that is not an array is empty.
+                ok = r.skip_unneeded();
+            }
+            else if (length == unknown)
+            {
+                const std::size_t old_size = rows.size();
+                ok = r.read_array([&]
+                                  {
+                    if (size < old_size)
+                    {
+                        reset_unread(rows[size]);
+                    }
+                    else
+                    {
+                        rows.emplace_back();
+                    }
+                    const std::size_t i = size++;
+                    return read_member<T, K>(r, rows[i]) || r.fail_in(i); });
+            }
+            else
+            {
+                ok = r.read_array([&]
+                                  {
+                    if (size == length)
+                    {
+                        r.error.key = fields::tags[K];
+                        return r.fail(read_errc::column_length);
+                    }
+                    const std::size_t i = size++;
+                    return read_member<T, K>(r, rows[i]) || r.fail_in(i); });
+            }
+            if (!ok)
+            {
+                return false;
+            }
+
+            if (length == unknown)
+            {
+                length = size;
+                if (rows.size() > length)
+                {
+                    rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(length), rows.end());
+                }
+            }
+            else if (size != length)
+            {
+                r.error.key = fields::tags[K];
+                return r.fail(read_errc::column_length);
+            }
+            return true;
+        }
+
+        /** @brief Read a json object of columns into a vector of aggregates.
+         *
+         * The keys that are not tag of any Field are skipped. All the Fields must be present except
+         * the optional ones, and the rows that the vector already holds are read over.
+         *
+         */
+        template <typename C>
+        bool read_columns(reader &r, C &rows)
+        {
+            using T = typename C::value_type;
+            using fields = kie::serde::reflection::fields<T>;
+            static constexpr auto readers = []<std::size_t... K>(std::index_sequence<K...>)
+            {
+                return std::array<bool (*)(reader &, C &, std::size_t &), fields::size>{&read_column<C, K>...};
+            }(std::make_index_sequence<fields::size>{});
+
+            value_type type = value_type::null;
+            if (!r.next_type(type))
+            {
+                return false;
+            }
+            if (type != value_type::object)
+            {
+                return r.mismatch(value_type::object, type);
+            }
+            use_resource(r, rows);
+
+            std::size_t length = std::numeric_limits<std::size_t>::max();
+            std::array<bool, fields::size> seen{};
+            const bool ok = r.read_object([&](std::string_view key)
+                                          {
+                const std::size_t k = fields::find(key);
+                if (k == fields::size)
+                {
+                    return r.skip_unneeded();
+                }
+                seen[k] = true;
+                return readers[k](r, rows, length) || r.fail_in(fields::tags[k]); });
+            if (!ok)
+            {
+                return false;
+            }
+
+            // report the first missing one in the order of declaration, just like an object.
+            const std::size_t missing = kie::serde::reflection::find_missing<T>(seen);
+            if (missing != fields::size)
+            {
+                r.error.key = fields::tags[missing];
+                r.fail(read_errc::missing_field);
+                return r.fail_in(fields::tags[missing]);
+            }
+            if (length == std::numeric_limits<std::size_t>::max())
+            {
+                // only some optional columns, so there is no row.
+                rows.clear();
+            }
+            for (auto &row : rows)
+            {
+                kie::serde::reflection::reset_missing(row, seen);
+            }
+            return true;
+        }
+    }
+
+    /** @brief Serialize a container of aggregates column by column, and append the json text to the buffer.
+     *
+     * Instead of an array of objects, it's written as one object that maps each tag to the array of
+     * the values of that Field in all the rows, e.g. `{"id":[1,2],"name":["a","b"]}` for two rows.
+     * Each key is written once instead of once per row, and each column is written in a loop over
+     * values of the same type. The columns are written in the order of their tags, and they are
+     * `[]` instead of `null` when there is no row.
+     *
+     * Usage:
+     * @code
+     * std::vector<Record> records = query();
+     * send(kie::serde_json::to_json_columnar(records));
+     * @endcode
+     *
+     * @param rows The rows to serialize. Their type should be an aggregate of Fields.
+     * @param out The buffer that the json text is appended to.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <impl::is_columnar C, type_trait::is_output_buffer B>
+    void write_json_columnar(const C &rows, B &out, const write_options &options = {})
+    {
+        using fields = kie::serde::reflection::fields<typename C::value_type>;
+        [&]<std::size_t... K>(std::index_sequence<K...>)
+        {
+            ((impl::write_key<typename C::value_type, K>(K == 0 ? '{' : ',', out),
+              impl::write_column<K>(rows, out, options)),
+             ...);
+        }(std::make_index_sequence<fields::size>{});
+        out.push_back('}');
+    }
+
+    /** @brief Serialize a container of aggregates to json string column by column.
+     *
+     * See `write_json_columnar`.
+     *
+     * @param rows The rows to serialize. Their type should be an aggregate of Fields.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <impl::is_columnar C>
+    std::string to_json_columnar(const C &rows, const write_options &options = {})
+    {
+        std::string out;
+        write_json_columnar(rows, out, options);
+        return out;
+    }
+
+    /** @brief Read the json written by `to_json_columnar` into an existing vector, in place.
+     *
+     * All the columns must be of the same length, or `nlohmann::json::other_error` is thrown. The
+     * columns of the optional Fields may be missing, and they get their default value then.
+     * Otherwise it throws the same exceptions as `from_json`. The rows are read over the existing
+     * ones, so their memory is reused as `from_json_into` does.
+     *
+     * @param rows The vector to overwrite.
+     * @param json_str a json string.
+     * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+     */
+    template <impl::is_columnar C>
+    requires type_trait::is_specialization_of<C, std::vector>::value
+    void from_json_columnar_into(C &rows, std::string_view json_str, const read_options &options = {})
+    {
+        impl::reader r{json_str};
+        r.resource = options.resource;
+        r.projection = options.projection;
+        if (!impl::read_columns(r, rows) || !r.finish())
+        {
+            r.prefer_syntax_error();
+            impl::throw_read_error(r.error);
+        }
+    }
+
+    /** @brief Read the json written by `to_json_columnar` into a vector of aggregates.
+     *
+     * Usage:
+     * @code
+     * auto records = kie::serde_json::from_json_columnar<std::vector<Record>>(json_str);
+     * @endcode
+     *
+     * @param json_str a json string.
+     * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+     */
+    template <impl::is_columnar C>
+    requires type_trait::is_specialization_of<C, std::vector>::value
+    C from_json_columnar(std::string_view json_str, const read_options &options = {})
+    {
+        C rows;
+        from_json_columnar_into(rows, json_str, options);
+        return rows;
+    }
+
+} // namespace kie::serde_json
+
+#endif
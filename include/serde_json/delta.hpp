@@ -0,0 +1,264 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_DELTA_HPP
+#define KIE_TOOLBOX_SERDE_JSON_DELTA_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+#include <boost/pfr.hpp>
+
+
+#include "../serde/field.hpp"
+#include "../serde/reflection.hpp"
+#include "../serde/tracked_field.hpp"
+#include "pointer.hpp"
+#include "type_trait.hpp"
+#include "writer.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     */
+    namespace impl
+    {
+        /** @brief Check if T is an aggregate whose Fields are looked into for changes.
+         *
+         */
+        template <typename T>
+        constexpr bool is_delta_object = std::is_aggregate_v<T> && std::is_class_v<T> && !type_trait::is_container<T>;
+
+        /** @brief How a Field has changed since the last delta.
+         *
+         */
+        enum class delta_change
+        {
+            none,
+            /// A dirty TrackedField, which is written as a whole.
+            whole,
+            /// An object that has some dirty TrackedField inside.
+            nested,
+        };
+
+        template <typename T>
+        bool has_delta(const T &t);
+
+        /** @brief Get how a Field has changed.
+         *
+         */
+        template <typename F>
+        delta_change change_of(const F &field)
+        {
+            if constexpr (kie::serde::type_trait::is_tracked_field<F>::value)
+            {
+                if (field.dirty())
+                {
+                    return delta_change::whole;
+                }
+            }
+            if constexpr (is_delta_object<typename F::Type>)
+            {
+                if (has_delta(field.value))
+                {
+                    return delta_change::nested;
+                }
+            }
+            return delta_change::none;
+        }
+
+        /** @brief Check if any TrackedField in t, or in the objects it holds, is dirty.
+         *
+         */
+        template <typename T>
+        bool has_delta(const T &t)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            return [&]<std::size_t... K>(std::index_sequence<K...>)
+            {
+                return ((change_of(boost::pfr::get<fields::index[K]>(t)) != delta_change::none) || ...);
+            }(std::make_index_sequence<fields::size>{});
+        }
+
+        /** @brief Mark all the TrackedFields in t, and in the objects it holds, clean.
+         *
+         */
+        template <typename T>
+        void clear_delta(T &t)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            [&]<std::size_t... K>(std::index_sequence<K...>)
+            {
+                ([&](auto &field)
+                 {
+                     if constexpr (kie::serde::type_trait::is_tracked_field<std::decay_t<decltype(field)>>::value)
+                     {
+                         field.mark_clean();
+                     }
+                     if constexpr (is_delta_object<typename std::decay_t<decltype(field)>::Type>)
+                     {
+                         clear_delta(field.value);
+                     }
+                 }(boost::pfr::get<fields::index[K]>(t)),
+                 ...);
+            }(std::make_index_sequence<fields::size>{});
+        }
+
+        /** @brief Write the changed Fields of t as a partial object, in the order of their tags.
+         *
+         */
+        template <typename T, type_trait::is_output_buffer B>
+        void write_delta_object(const T &t, B &out, const write_options &options)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            bool first = true;
+            [&]<std::size_t... K>(std::index_sequence<K...>)
+            {
+                ([&](const auto &field)
+                 {
+                     const delta_change change = change_of(field);
+                     if (change == delta_change::none)
+                     {
+                         return;
+                     }
+                     write_key<T, K>(first ? '{' : ',', out);
+                     first = false;
+                     if (change == delta_change::whole)
+                     {
+                         write_value(field.value, out, options);
+                     }
+                     else if constexpr (is_delta_object<typename std::decay_t<decltype(field)>::Type>)
+                     {
+                         write_delta_object(field.value, out, options);
+                     }
+                 }(boost::pfr::get<fields::index[K]>(t)),
+                 ...);
+            }(std::make_index_sequence<fields::size>{});
+            if (first)
+            {
+                out.push_back('{');
+            }
+            out.push_back('}');
+        }
+
+        /** @brief Write a `replace` operation for each dirty TrackedField of t.
+         *
+         * @param path The JSON Pointer of t. It's restored before returning.
+         * @param first True if no operation has been written yet.
+         */
+        template <typename T, type_trait::is_output_buffer B>
+        void write_patch_operations(const T &t, std::string &path, B &out, const write_options &options, bool &first)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            [&]<std::size_t... K>(std::index_sequence<K...>)
+            {
+                ([&](const auto &field)
+                 {
+                     const delta_change change = change_of(field);
+                     if (change == delta_change::none)
+                     {
+                         return;
+                     }
+                     const std::size_t length = path.size();
+                     append_pointer_token(path, fields::tags[K]);
+                     if (change == delta_change::whole)
+                     {
+                         out.push_back(first ? '[' : ',');
+                         first = false;
+                         out.append("{\"op\":\"replace\",\"path\":", 23);
+                         write_string(path, out);
+                         out.append(",\"value\":", 9);
+                         write_value(field.value, out, options);
+                         out.push_back('}');
+                     }
+                     else if constexpr (is_delta_object<typename std::decay_t<decltype(field)>::Type>)
+                     {
+                         write_patch_operations(field.value, path, out, options, first);
+                     }
+                     path.resize(length);
+                 }(boost::pfr::get<fields::index[K]>(t)),
+                 ...);
+            }(std::make_index_sequence<fields::size>{});
+        }
+    }
+
+    /** @brief Append the TrackedFields of t that have changed as a partial json object, and mark them clean.
+     *
+     * Only the dirty TrackedFields are written, each as a whole, and the objects that hold some
+     * dirty TrackedField are written as partial objects as well, so the result can be applied to
+     * the last state as a JSON Merge Patch (RFC 7396). `{}` is written if nothing has changed.
+     * Since `null` removes a key in a merge patch, the empty containers are written as `[]`, and
+     * a `std::nullopt` removes the key, which reads back as `std::nullopt` since it may be missing.
+     * The Fields that are not TrackedField, and the items of containers, are not looked into, so
+     * assign or `modify()` the TrackedField that holds a container to send its new items.
+     *
+     * Usage:
+     * @code
+     * std::string buffer;
+     * kie::serde_json::write_json_delta(session, buffer);
+     * @endcode
+     *
+     * @param t The object to serialize. Its TrackedFields are marked clean.
+     * @param out The buffer that the json text is appended to.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <typename T, type_trait::is_output_buffer B>
+    requires impl::is_delta_object<T>
+    void write_json_delta(T &t, B &out, const write_options &options = {})
+    {
+        // null removes the key in a merge patch, so the empty containers must be kept as arrays.
+        write_options patch_options = options;
+        patch_options.empty_as_array = true;
+        impl::write_delta_object(t, out, patch_options);
+        impl::clear_delta(t);
+    }
+
+    /** @brief Serialize the TrackedFields of t that have changed to a partial json object, and mark them clean.
+     *
+     * See `write_json_delta`.
+     *
+     * @param t The object to serialize. Its TrackedFields are marked clean.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <typename T>
+    requires impl::is_delta_object<T>
+    std::string to_json_delta(T &t, const write_options &options = {})
+    {
+        std::string out;
+        write_json_delta(t, out, options);
+        return out;
+    }
+
+    /** @brief Serialize the TrackedFields of t that have changed to a JSON Patch (RFC 6902), and mark them clean.
+     *
+     * There is one `replace` operation for each dirty TrackedField, with the JSON Pointer to it
+     * from the root of t, e.g. `[{"op":"replace","path":"/player/score","value":3}]`. `[]` is
+     * returned if nothing has changed. The same Fields are looked into as `write_json_delta`.
+     *
+     * @param t The object to serialize. Its TrackedFields are marked clean.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <typename T>
+    requires impl::is_delta_object<T>
+    std::string to_json_patch(T &t, const write_options &options = {})
+    {
+        std::string out;
+        std::string path;
+        bool first = true;
+        impl::write_patch_operations(t, path, out, options, first);
+        out.append(first ? "[]" : "]");
+        impl::clear_delta(t);
+        return out;
+    }
+
+} // namespace kie::serde_json
+
+#endif
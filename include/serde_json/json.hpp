@@ -4,6 +4,8 @@
 #include <array>
 #include <vector>
 #include <list>
+#include <memory_resource>
+#include <optional>
 #include <type_traits>
 #include <string_view>
 #include <string>
@@ -14,6 +16,14 @@
 
 
 #include "../serde/field.hpp"
+#include "../serde/lazy.hpp"
+#include "../serde/optional_field.hpp"
+#include "../serde/tracked_field.hpp"
+#include "type_trait.hpp"
+#include "writer.hpp"
+#include "reader.hpp"
+#include "delta.hpp"
+#include "columnar.hpp"
 
 
 /** @brief the main namespace of this library
@@ -23,100 +33,29 @@
 namespace kie::serde_json
 {
 
-    /** @brief This namespace contains some trait used by this library at compile time.
+    /** @brief to_json overload that only accept container.
      *
-     * It help robust this library with some compile time check with concept.
-     * At the same time, it make some overload decision posible or simpler thanks to concept.
+     * This is just a declaration for overload.
      *
      */
-    namespace type_trait
-    {
-
-        /** @brief A helper variable indicating that this is not implemented.
-         *
-         * Just a helper variable and not used for now.
-         *
-         */
-        template <class...>
-        constexpr std::false_type not_implemented{};
-
-        /** @brief Check if a class is a specialization of a template.
-         *
-         * It only applies to the template type with only type parameters. If
-         * there are non-type parameters, it fails to check.
-         *
-         */
-        template <typename T, template <typename...> class Z>
-        struct is_specialization_of : std::false_type
-        {
-        };
-
-        /** @brief Check if a class is a specialization of a template.
-         *
-         * It only applies to the template type with only type parameters. If
-         * there are non-type parameters, it fails to check.
-         *
-         */
-        template <typename... Args, template <typename...> class Z>
-        struct is_specialization_of<Z<Args...>, Z> : std::true_type
-        {
-        };
-
-        /** @brief Check if type T is `std::array`
-         *
-         * With the limitation of `is_specialization_of`, this class
-         * helps to check `std::array` because of the second parameter
-         * is non-type.
-         *
-         */
-        template <typename T>
-        struct is_array_class : std::false_type
-        {
-        };
-
-        /** @brief Check if type T is `std::array`
-         *
-         * With the limitation of `is_specialization_of`, this class
-         * helps to check `std::array` because of the second parameter
-         * is non-type.
-         *
-         */
-        template <typename T, std::size_t size>
-        struct is_array_class<std::array<T, size>> : std::true_type
-        {
-        };
-
-        /** @brief A concept checks if type T is a `container`.
-         *
-         * Container means three things here, a vector, a list and an array.
-         *
-         */
-        template <typename T>
-        concept is_container = is_specialization_of<T, std::vector>::value ||
-            is_specialization_of<T, std::list>::value ||
-            is_array_class<T>::value;
+    template <type_trait::is_container T>
+    nlohmann::json to_json(const T &t);
 
-        /** @brief A concept checks if type T is a `dynamic container`
-         *
-         * Dynamic container means std::vector and std::list here.
-         *
-         */
-        template <typename T>
-        concept is_dynamic_container = (is_specialization_of<T, std::vector>::value ||
-                                        is_specialization_of<T, std::list>::value) &&
-                                       requires
-        {
-            typename T::value_type;
-        };
-    }
+    /** @brief to_json overload for `kie::serde::Lazy`.
+     *
+     * This is just a declaration for overload.
+     *
+     */
+    template <typename T>
+    nlohmann::json to_json(const kie::serde::Lazy<T> &t);
 
-    /** @brief to_json overload that only accept container.
+    /** @brief to_json overload for `std::optional`.
      *
      * This is just a declaration for overload.
      *
      */
-    template <type_trait::is_container T>
-    nlohmann::json to_json(const T &t);
+    template <typename T>
+    nlohmann::json to_json(const std::optional<T> &t);
 
     /** @brief The version of to_json that accepts all the types
      *
@@ -134,7 +73,7 @@ namespace kie::serde_json
         boost::pfr::for_each_field(t, [&j]<typename TT>(const TT &field, std::size_t)
                                    {
             if constexpr(kie::serde::type_trait::is_field<TT>::value){
-                if constexpr(std::is_class_v<typename TT::Type> && !std::is_same_v<typename TT::Type, std::string>){
+                if constexpr(std::is_class_v<typename TT::Type> && !type_trait::is_string<typename TT::Type> && !type_trait::is_string_view<typename TT::Type>){
                     j[std::string{field.tag()}] = to_json(field.value);
                 }else{
                     j[std::string{field.tag()}] = field.value;
@@ -169,7 +108,7 @@ namespace kie::serde_json
         nlohmann::json j;
         for (const auto &item : t)
         {
-            if constexpr (std::is_class_v<std::decay_t<decltype(item)>> && !std::is_same_v<std::decay_t<decltype(item)>, std::string>)
+            if constexpr (std::is_class_v<std::decay_t<decltype(item)>> && !type_trait::is_string<std::decay_t<decltype(item)>> && !type_trait::is_string_view<std::decay_t<decltype(item)>>)
             {
                 j.push_back(to_json(item));
             }
@@ -181,6 +120,51 @@ namespace kie::serde_json
         return j;
     }
 
+    /** @brief to_json overload for `kie::serde::Lazy`.
+     *
+     * The raw text is parsed as it is if the value is not modified, so the members that T doesn't
+     * know are kept, just like `to_json_string` copies the text.
+     *
+     */
+    template <typename T>
+    nlohmann::json to_json(const kie::serde::Lazy<T> &t)
+    {
+        if (t.has_raw())
+        {
+            return nlohmann::json::parse(t.raw());
+        }
+        if constexpr (std::is_class_v<T> && !type_trait::is_string<T> && !type_trait::is_string_view<T>)
+        {
+            return to_json(t.get());
+        }
+        else
+        {
+            return nlohmann::json(t.get());
+        }
+    }
+
+    /** @brief to_json overload for `std::optional`.
+     *
+     * `std::nullopt` is written as null.
+     *
+     */
+    template <typename T>
+    nlohmann::json to_json(const std::optional<T> &t)
+    {
+        if (!t)
+        {
+            return nullptr;
+        }
+        if constexpr (std::is_class_v<T> && !type_trait::is_string<T> && !type_trait::is_string_view<T>)
+        {
+            return to_json(*t);
+        }
+        else
+        {
+            return nlohmann::json(*t);
+        }
+    }
+
     /** @brief This namespace contains some function used internally.
      *
      * They are all for some overload resolution.
@@ -211,6 +195,26 @@ namespace kie::serde_json
         template <type_trait::is_dynamic_container T>
         T from_json(const nlohmann::json &j);
 
+        /** @brief Convert json object to `kie::serde::Lazy`.
+         *
+         * This is a declaration.
+         *
+         * @param j The json object that contains only one thing.
+         */
+        template <typename T>
+        requires kie::serde::type_trait::is_lazy<T>::value
+            T from_json(const nlohmann::json &j);
+
+        /** @brief Convert json object to `std::optional`.
+         *
+         * This is a declaration.
+         *
+         * @param j The json object that contains only one thing.
+         */
+        template <typename T>
+        requires type_trait::is_specialization_of<T, std::optional>::value
+            T from_json(const nlohmann::json &j);
+
         /** @brief Convert json object to an aggregate type.
          *
          * Almost all the time, user should define a class that only contains Fields.
@@ -227,7 +231,12 @@ namespace kie::serde_json
             boost::pfr::for_each_field(t, [&j]<typename TT>(TT &field, std::size_t)
                                        {
                 if constexpr(kie::serde::type_trait::is_field<TT>::value){
-                    if constexpr(std::is_class_v<typename TT::Type> && !std::is_same_v<typename TT::Type, std::string>){
+                    if constexpr(kie::serde::type_trait::is_optional_field<TT>::value){
+                        if (!j.contains(std::string{field.tag()})){
+                            return; // keep the default value
+                        }
+                    }
+                    if constexpr(std::is_class_v<typename TT::Type> && !type_trait::is_string<typename TT::Type> && !type_trait::is_string_view<typename TT::Type>){
                         field = impl::from_json<typename TT::Type>(j.at(std::string{field.tag()}));
                     }else{
                         j.at(std::string{field.tag()}).get_to(field.value);
@@ -260,30 +269,76 @@ namespace kie::serde_json
             }
             return t;
         }
+
+        /** @brief Convert json object to `kie::serde::Lazy`.
+         *
+         * There is no raw text to keep once the json is parsed, so the value is built at once.
+         *
+         * @param j The json object that contains only one thing.
+         */
+        template <typename T>
+        requires kie::serde::type_trait::is_lazy<T>::value
+            T from_json(const nlohmann::json &j)
+        {
+            return T{impl::from_json<typename T::Type>(j)};
+        }
+
+        /** @brief Convert json object to `std::optional`.
+         *
+         * null becomes `std::nullopt`.
+         *
+         * @param j The json object that contains only one thing.
+         */
+        template <typename T>
+        requires type_trait::is_specialization_of<T, std::optional>::value
+            T from_json(const nlohmann::json &j)
+        {
+            if (j.is_null())
+            {
+                return std::nullopt;
+            }
+            return T{impl::from_json<typename T::value_type>(j)};
+        }
     }
 
     /** @brief Converting string_view to aggregate type.
      *
      * This is a friendly deserialization function for json.
      *
+     * The input is read only once, and each value is assigned to its Field as soon as the key is
+     * read, so no `nlohmann::json` is built in between. It throws the same exceptions as
+     * `nlohmann::json` does when the input is malformed, a Field is missing or of wrong type. As
+     * `nlohmann::json` parses the whole input first, a syntax error anywhere is reported instead of
+     * a Field that is missing or of wrong type.
+     * A key that appears more than once is read every time, so the last one wins as well, but unlike
+     * `nlohmann::json`, each of them must be of the right type, or `type_error` is thrown.
+     * The keys of `OptionalField` and the Fields of `std::optional` may be missing, and they keep
+     * the value that a new T has then. Use `try_from_json` to get the error without exceptions.
+     *
+     * The Fields of `std::pmr::string`, `std::pmr::vector` and so on are built in `resource` if it's
+     * given, so a whole object graph can live in a `std::pmr::monotonic_buffer_resource` and be
+     * freed at once. The resource must outlive the result.
+     *
+     * Usage:
+     * @code
+     * std::pmr::monotonic_buffer_resource arena;
+     * auto request = kie::serde_json::from_json<Request>(json_str, &arena);
+     * @endcode
+     *
+     * The Fields of `std::string_view` point into `json_str` instead of copying, so the result must not
+     * outlive the input. Only the strings with escapes are copied, into `resource`, and it throws
+     * `nlohmann::json::other_error` if there is no resource to copy them to.
+     *
      * @param json_str a json string.
+     * @param resource The memory resource for the allocator-aware Fields and the escaped string_views, or null to leave them as they are.
      *
      */
     template <typename T>
     requires std::is_aggregate_v<T> && std::is_class_v<T>
-        T from_json(std::string_view json_str)
+        T from_json(std::string_view json_str, std::pmr::memory_resource *resource = nullptr)
     {
-        nlohmann::json j = nlohmann::json::parse(json_str);
         T t{};
-        boost::pfr::for_each_field(t, [&j]<typename TT>(TT &field, std::size_t)
-                                   {
-            if constexpr(kie::serde::type_trait::is_field<TT>::value){
-                if constexpr(std::is_class_v<typename TT::Type> && !std::is_same_v<typename TT::Type, std::string>){
-                    field = impl::from_json<typename TT::Type>(j.at(std::string{field.tag()}));
-                }else{
-                    j.at(std::string{field.tag()}).get_to(field.value);
-                }
-            } });
+        impl::read_json(json_str, t, resource);
         return t;
     }
 
@@ -291,27 +346,135 @@ namespace kie::serde_json
      *
      * This is a friendly deserialization function for json.
      *
+     * The container is empty if the json is not an array.
+     *
      * @param json_str a json string.
+     * @param resource The memory resource for the container if it's allocator-aware, and for its items.
+     *                 The `std::string_view` items point into `json_str` unless they have escapes, see above.
      *
      */
     template <type_trait::is_dynamic_container T>
-    T from_json(std::string_view json_str)
+    T from_json(std::string_view json_str, std::pmr::memory_resource *resource = nullptr)
     {
-        nlohmann::json j = nlohmann::json::parse(json_str);
-        if (!j.is_array())
-        {
-            return {};
-        }
         T t;
-        if constexpr (type_trait::is_specialization_of<T, std::vector>::value)
-        {
-            t.reserve(j.size());
-        }
-        for (const auto &item : j)
+        impl::read_json(json_str, t, resource);
+        return t;
+    }
+
+    /** @brief Converting string_view to aggregate type, with options.
+     *
+     * Set `options.projection` when T models only a small part of large documents. The values that
+     * no Field takes are then skipped by matching only their quotes and brackets with the SIMD
+     * kernels, instead of being checked byte by byte. The errors inside them are not reported, but
+     * everything that is read into T is checked as usual.
+     *
+     * Usage:
+     * @code
+     * auto summary = kie::serde_json::from_json<Summary>(json_str, {.projection = true});
+     * @endcode
+     *
+     * @param json_str a json string.
+     * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+     *
+     */
+    template <typename T>
+    requires std::is_aggregate_v<T> && std::is_class_v<T>
+        T from_json(std::string_view json_str, const read_options &options)
+    {
+        T t{};
+        impl::read_json(json_str, t, options);
+        return t;
+    }
+
+    /** @brief Converting string_view to container type, with options.
+     *
+     * @param json_str a json string.
+     * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+     *
+     */
+    template <type_trait::is_dynamic_container T>
+    T from_json(std::string_view json_str, const read_options &options)
+    {
+        T t;
+        impl::read_json(json_str, t, options);
+        return t;
+    }
+
+    /** @brief Converting string_view to aggregate or container type, without exceptions.
+     *
+     * It reads the same as `from_json`, but the error is returned instead of thrown, together with
+     * the JSON Pointer to the value where it happens. Nothing is thrown on the way either, so a flood
+     * of malformed input costs no more than reading it, except that `std::bad_alloc` may still be
+     * thrown when memory runs out.
+     *
+     * Usage:
+     * @code
+     * auto result = kie::serde_json::try_from_json<Request>(json_str);
+     * if (!result)
+     * {
+     *     // result.error().code is read_errc::missing_field, result.path() is "/user/id"
+     * }
+     * @endcode
+     *
+     * @param json_str a json string.
+     * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+     *
+     */
+    template <typename T>
+    requires(std::is_aggregate_v<T> && std::is_class_v<T>) || type_trait::is_dynamic_container<T>
+    read_result<T> try_from_json(std::string_view json_str, const read_options &options = {})
+    {
+        T t{};
+        impl::reader r{json_str};
+        if (!impl::read_document(r, t, options))
         {
-            t.push_back(impl::from_json<std::decay_t<typename T::value_type>>(item));
+            return read_result<T>{r.error, std::move(r.path)};
         }
-        return t;
+        return read_result<T>{std::move(t)};
+    }
+
+    /** @brief Converting string_view into an existing aggregate or container, in place.
+     *
+     * Every Field of target is overwritten with the value in the json, but the strings and containers
+     * it already holds are reused instead of built again. Their capacity is kept, and the items of a
+     * vector are read over the existing ones, so handling one message after another in the same
+     * target allocates nothing once it has grown large enough. The members that are not Field are
+     * reset, so target ends up the same as what `from_json<T>` returns.
+     *
+     * It throws the same exceptions as `from_json<T>`, and target is partly overwritten then.
+     *
+     * Usage:
+     * @code
+     * Request request;
+     * for (std::string_view message : messages)
+     * {
+     *     kie::serde_json::from_json_into(request, message);
+     *     handle(request);
+     * }
+     * @endcode
+     *
+     * @param target The value to overwrite.
+     * @param json_str a json string.
+     * @param resource The memory resource for the allocator-aware Fields and the escaped string_views, the same as `from_json<T>`.
+     */
+    template <typename T>
+    requires(std::is_aggregate_v<T> && std::is_class_v<T>) || type_trait::is_dynamic_container<T>
+    void from_json_into(T &target, std::string_view json_str, std::pmr::memory_resource *resource = nullptr)
+    {
+        impl::read_json(json_str, target, resource);
+    }
+
+    /** @brief Converting string_view into an existing aggregate or container in place, with options.
+     *
+     * @param target The value to overwrite.
+     * @param json_str a json string.
+     * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+     */
+    template <typename T>
+    requires(std::is_aggregate_v<T> && std::is_class_v<T>) || type_trait::is_dynamic_container<T>
+    void from_json_into(T &target, std::string_view json_str, const read_options &options)
+    {
+        impl::read_json(json_str, target, options);
     }
 
 } // namespace kie::serde_json
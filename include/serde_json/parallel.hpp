@@ -0,0 +1,505 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_PARALLEL_HPP
+#define KIE_TOOLBOX_SERDE_JSON_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+
+#include "reader.hpp"
+#include "simd.hpp"
+#include "type_trait.hpp"
+#include "writer.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief How a large json array is split and read or written in parallel.
+     *
+     */
+    struct parallel_options
+    {
+        /// How many threads take part, including the caller. 0 means as many as the executor has, or the CPU number if it's unknown.
+        std::size_t concurrency = 0;
+        /// The least bytes of a chunk. The input smaller than two chunks is read or written on the caller only.
+        std::size_t chunk_size = 64 * 1024;
+    };
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief A vector whose items can be written by different threads at the same time.
+         *
+         */
+        template <typename T>
+        concept is_parallel_vector = type_trait::is_specialization_of<T, std::vector>::value &&
+                                     !std::is_same_v<typename T::value_type, bool> &&
+                                     std::is_default_constructible_v<typename T::value_type>;
+
+        /** @brief Anything that `boost::asio::post` accepts, like an executor, an io_context or a thread_pool.
+         *
+         */
+        template <typename E>
+        concept is_postable = requires(E &e) { boost::asio::post(e, [] {}); };
+
+        /** @brief A pool of io_context that lists them in `get_all()`, like `kie::context`.
+         *
+         */
+        template <typename P>
+        concept is_context_pool = requires(P &p) {
+            {
+                *p.get_all().front()
+            } -> std::convertible_to<boost::asio::io_context &>;
+        };
+
+        /** @brief Anything the helpers can be posted to.
+         *
+         */
+        template <typename E>
+        concept is_parallel_executor = is_postable<E> || is_context_pool<E>;
+
+        /** @brief A container whose items can be written out by different threads by index.
+         *
+         */
+        template <typename T>
+        concept is_random_access_container = type_trait::is_container<T> && std::ranges::random_access_range<const T> && std::ranges::sized_range<const T>;
+
+        /** @brief A run of items of the top level array.
+         *
+         */
+        struct array_chunk
+        {
+            /// The byte offset of the first item, right after the bracket or the comma.
+            std::size_t begin = 0;
+            /// The index of the first item in the array.
+            std::size_t first = 0;
+            std::size_t count = 0;
+        };
+
+        /** @brief Find where the items of the top level array are, and cut them into chunks of at least chunk_size bytes.
+         *
+         * It only tracks the nesting and jumps over the strings, nothing is validated. So it's much
+         * faster than reading, and the readers of the chunks find any error in the input.
+         *
+         * @return False if the input is not a non-empty array, or it's cut short. It's left to the sequential reader then.
+         */
+        inline bool split_array(std::string_view json_str, std::size_t chunk_size, std::vector<array_chunk> &chunks)
+        {
+            const auto &kernels = simd::active();
+            const char *data = json_str.data();
+            const std::size_t size = json_str.size();
+            const auto skip_whitespace = [&](std::size_t i)
+            {
+                while (i < size && (data[i] == ' ' || data[i] == '\n' || data[i] == '\r' || data[i] == '\t'))
+                {
+                    i++;
+                }
+                return i;
+            };
+
+            std::size_t i = skip_whitespace(0);
+            if (i == size || data[i] != '[')
+            {
+                return false;
+            }
+            i++;
+            const std::size_t first_item = skip_whitespace(i);
+            if (first_item == size || data[first_item] == ']')
+            {
+                return false;
+            }
+
+            array_chunk chunk{i, 0, 0};
+            std::size_t depth = 0;
+            for (; i < size; i++)
+            {
+                switch (data[i])
+                {
+                case '"':
+                    // the escaped characters can't end the string, so jump over them.
+                    i++;
+                    while (true)
+                    {
+                        if (i >= size)
+                        {
+                            return false;
+                        }
+                        i += kernels.find_escape(data + i, size - i);
+                        if (i < size && data[i] == '"')
+                        {
+                            break;
+                        }
+                        i += i < size && data[i] == '\\' ? 2 : 1;
+                    }
+                    break;
+                case '[':
+                case '{':
+                    depth++;
+                    break;
+                case ']':
+                case '}':
+                    if (depth == 0)
+                    {
+                        chunk.count++;
+                        chunks.push_back(chunk);
+                        return true;
+                    }
+                    depth--;
+                    break;
+                case ',':
+                    if (depth == 0)
+                    {
+                        chunk.count++;
+                        if (i + 1 - chunk.begin >= chunk_size)
+                        {
+                            chunks.push_back(chunk);
+                            chunk = array_chunk{i + 1, chunk.first + chunk.count, 0};
+                        }
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+            return false;
+        }
+
+        /** @brief The state shared by the caller and the helper threads.
+         *
+         * The chunks are claimed one by one, so the fast threads take more of them. A helper that
+         * starts after all the chunks are claimed leaves at once, and it only touches the counters,
+         * so it's fine that the caller has returned by then.
+         *
+         */
+        struct parallel_batch
+        {
+            std::size_t size = 0;
+            std::function<void(std::size_t)> run;
+            std::vector<std::exception_ptr> exceptions;
+            std::atomic<std::size_t> next{0};
+            std::size_t done = 0;
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            void work()
+            {
+                while (true)
+                {
+                    const std::size_t c = next.fetch_add(1, std::memory_order_relaxed);
+                    if (c >= size)
+                    {
+                        return;
+                    }
+                    try
+                    {
+                        run(c);
+                    }
+                    catch (...)
+                    {
+                        exceptions[c] = std::current_exception();
+                    }
+                    std::lock_guard lock{mutex};
+                    if (++done == size)
+                    {
+                        finished.notify_all();
+                    }
+                }
+            }
+
+            void wait()
+            {
+                std::unique_lock lock{mutex};
+                finished.wait(lock, [this]
+                              { return done == size; });
+            }
+        };
+
+        /** @brief The number of threads to use, including the caller.
+         *
+         */
+        template <is_parallel_executor E>
+        std::size_t concurrency_of(E &executor, const parallel_options &options)
+        {
+            std::size_t concurrency = options.concurrency;
+            if (concurrency == 0)
+            {
+                if constexpr (is_context_pool<E>)
+                {
+                    concurrency = executor.get_all().size();
+                }
+                else
+                {
+                    concurrency = std::thread::hardware_concurrency();
+                }
+            }
+            return std::max<std::size_t>(concurrency, 1);
+        }
+
+        /** @brief Post the h-th helper. The helpers are spread over the io_contexts of a pool.
+         *
+         */
+        template <is_parallel_executor E, typename F>
+        void post_helper(E &executor, std::size_t h, F &&task)
+        {
+            if constexpr (is_context_pool<E>)
+            {
+                const auto &all = executor.get_all();
+                boost::asio::post(*all[h % all.size()], std::forward<F>(task));
+            }
+            else
+            {
+                boost::asio::post(executor, std::forward<F>(task));
+            }
+        }
+
+        /** @brief Call run(c) for every chunk c on the caller and concurrency - 1 helpers, and wait for all of them.
+         *
+         * The caller takes part in the work and never waits for a helper that hasn't started, so it's
+         * fine to call it on a thread of the executor, or before the executor runs at all.
+         *
+         * @return The exception thrown by each chunk, if any.
+         */
+        template <is_parallel_executor E>
+        std::vector<std::exception_ptr> run_parallel(E &executor, std::size_t concurrency, std::size_t chunks, std::function<void(std::size_t)> run)
+        {
+            auto batch = std::make_shared<parallel_batch>();
+            batch->size = chunks;
+            batch->run = std::move(run);
+            batch->exceptions.resize(chunks);
+
+            const std::size_t helpers = std::min(concurrency, chunks) - 1;
+            for (std::size_t h = 0; h < helpers; h++)
+            {
+                try
+                {
+                    post_helper(executor, h, [batch]
+                                { batch->work(); });
+                }
+                catch (...)
+                {
+                    break; // the caller does the chunks left over.
+                }
+            }
+            batch->work();
+            batch->wait();
+            return std::move(batch->exceptions);
+        }
+
+        /** @brief Read the items of a chunk, and the comma or the bracket after them.
+         *
+         */
+        template <is_parallel_vector T>
+        read_error read_chunk(std::string_view json_str, const std::vector<array_chunk> &chunks, std::size_t c, T &t)
+        {
+            const auto &chunk = chunks[c];
+            const bool last = c + 1 == chunks.size();
+            reader r{json_str, chunk.begin};
+            bool ok = true;
+            for (std::size_t k = 0; ok && k < chunk.count; k++)
+            {
+                ok = (k == 0 || r.consume(',')) && read_value(r, t[chunk.first + k]);
+            }
+            ok = ok && r.consume(last ? ']' : ',') && (!last || r.finish());
+            return ok ? read_error{} : r.error;
+        }
+
+        template <is_parallel_vector T, is_parallel_executor E>
+        T read_parallel(std::string_view json_str, E &executor, const parallel_options &options)
+        {
+            T t;
+            const std::size_t concurrency = concurrency_of(executor, options);
+            // a few chunks per thread, so a thread that is slow to start doesn't hold up the others.
+            const std::size_t chunk_size = std::max(options.chunk_size, json_str.size() / (concurrency * 4));
+            std::vector<array_chunk> chunks;
+            if (concurrency == 1 || json_str.size() < 2 * chunk_size || !split_array(json_str, chunk_size, chunks) || chunks.size() < 2)
+            {
+                read_json(json_str, t);
+                return t;
+            }
+
+            t.resize(chunks.back().first + chunks.back().count);
+            std::vector<read_error> errors(chunks.size());
+            const auto exceptions = run_parallel(executor, concurrency, chunks.size(), [&](std::size_t c)
+                                                 { errors[c] = read_chunk(json_str, chunks, c, t); });
+
+            // report the error of the first chunk, which is the one the sequential reader would meet.
+            for (std::size_t c = 0; c < chunks.size(); c++)
+            {
+                if (exceptions[c])
+                {
+                    std::rethrow_exception(exceptions[c]);
+                }
+                if (errors[c])
+                {
+                    reader r{json_str};
+                    r.error = errors[c];
+                    r.prefer_syntax_error();
+                    throw_read_error(r.error);
+                }
+            }
+            return t;
+        }
+
+        template <is_random_access_container T, is_parallel_executor E>
+        std::vector<std::string> write_parallel(const T &t, E &executor, const parallel_options &options, const write_options &write)
+        {
+            std::vector<std::string> buffers;
+            const auto size = static_cast<std::size_t>(std::ranges::size(t));
+            const std::size_t concurrency = concurrency_of(executor, options);
+            if (concurrency == 1 || size < 2)
+            {
+                write_json(t, buffers.emplace_back(), write);
+                return buffers;
+            }
+
+            // the first item tells roughly how large the others are.
+            std::string first;
+            write_value(*std::ranges::begin(t), first, write);
+            const std::size_t item_size = first.size() + 1;
+            const std::size_t per_chunk = std::max({options.chunk_size / item_size, size / (concurrency * 4), std::size_t{1}});
+            const std::size_t chunks = (size + per_chunk - 1) / per_chunk;
+            if (chunks < 2)
+            {
+                write_json(t, buffers.emplace_back(), write);
+                return buffers;
+            }
+
+            buffers.resize(chunks);
+            const auto exceptions = run_parallel(executor, concurrency, chunks, [&](std::size_t c)
+                                                 {
+                const std::size_t begin = c * per_chunk;
+                const std::size_t end = std::min(size, begin + per_chunk);
+                auto &out = buffers[c];
+                out.reserve((end - begin) * item_size + 1);
+                auto it = std::ranges::begin(t) + static_cast<std::ptrdiff_t>(begin);
+                for (std::size_t i = begin; i < end; i++, ++it)
+                {
+                    out.push_back(i == 0 ? '[' : ',');
+                    write_value(*it, out, write);
+                }
+                if (end == size)
+                {
+                    out.push_back(']');
+                } });
+            for (const auto &exception : exceptions)
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+            }
+            return buffers;
+        }
+    }
+
+    /** @brief Converting a large json array to a vector on many threads.
+     *
+     * The items of the top level array are found by a quick scan, cut into chunks, and read by the
+     * caller and the threads of the executor at the same time, straight into a vector of the right
+     * size. The result and the exceptions are the same as `from_json<T>`. Small input is read on the
+     * caller only, as the threads cost more than they save.
+     *
+     * The caller takes part in the work and never waits for a helper that hasn't started, so it's
+     * fine to call it on a thread of the executor, or before the executor runs at all.
+     *
+     * Usage:
+     * @code
+     * boost::asio::thread_pool pool{32};
+     * auto records = kie::serde_json::from_json_parallel<std::vector<Record>>(json_str, pool);
+     *
+     * kie::context ctx{32};
+     * ctx.run_as_daemon();
+     * auto more = kie::serde_json::from_json_parallel<std::vector<Record>>(json_str, ctx);
+     * @endcode
+     *
+     * @param json_str a json string.
+     * @param executor Anything that `boost::asio::post` accepts, or a `kie::context` whose io_contexts share the helpers.
+     * @param options How many threads to use and how large the chunks are. The concurrency is the size of the `kie::context`
+     *                or the CPU number by default.
+     */
+    template <impl::is_parallel_vector T, impl::is_parallel_executor E>
+    T from_json_parallel(std::string_view json_str, E &executor, const parallel_options &options = {})
+    {
+        return impl::read_parallel<T>(json_str, executor, options);
+    }
+
+    /** @brief Serialize a large container to json on many threads, as a list of buffers.
+     *
+     * The items are cut into chunks, and each chunk is written to its own buffer by the caller and
+     * the threads of the executor at the same time. The buffers joined in order are byte-identical
+     * to `to_json_string(t, write)`, so they can be sent with scatter-gather output as they are.
+     *
+     * Usage:
+     * @code
+     * auto buffers = kie::serde_json::to_json_buffers(records, pool);
+     * std::vector<boost::asio::const_buffer> views(buffers.begin(), buffers.end());
+     * boost::asio::write(socket, views);
+     * @endcode
+     *
+     * @param t The container to serialize. It should support random access, like `std::vector`.
+     * @param executor Anything that `boost::asio::post` accepts, or a `kie::context`.
+     * @param options How many threads to use and how large the chunks are. The chunk size is estimated from the first item.
+     * @param write How the numbers are written.
+     */
+    template <impl::is_random_access_container T, impl::is_parallel_executor E>
+    std::vector<std::string> to_json_buffers(const T &t, E &executor, const parallel_options &options = {}, const write_options &write = {})
+    {
+        return impl::write_parallel(t, executor, options, write);
+    }
+
+    /** @brief Serialize a large container to json string on many threads.
+     *
+     * It's `to_json_buffers` joined into one string. The result is byte-identical to `to_json_string(t, write)`.
+     *
+     */
+    template <impl::is_random_access_container T, impl::is_parallel_executor E>
+    std::string to_json_string(const T &t, E &executor, const parallel_options &options = {}, const write_options &write = {})
+    {
+        auto buffers = impl::write_parallel(t, executor, options, write);
+        if (buffers.size() == 1)
+        {
+            return std::move(buffers[0]);
+        }
+        std::size_t size = 0;
+        for (const auto &buffer : buffers)
+        {
+            size += buffer.size();
+        }
+        std::string out;
+        out.reserve(size);
+        for (const auto &buffer : buffers)
+        {
+            out.append(buffer);
+        }
+        return out;
+    }
+
+} // namespace kie::serde_json
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_POINTER_HPP
+#define KIE_TOOLBOX_SERDE_JSON_POINTER_HPP
+
+#include <string>
+#include <string_view>
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     */
+    namespace impl
+    {
+        /** @brief Append a key to a JSON Pointer, escaping `~` and `/` as RFC 6901 requires.
+         *
+         */
+        inline void append_pointer_token(std::string &path, std::string_view key)
+        {
+            path.push_back('/');
+            for (char c : key)
+            {
+                if (c == '~')
+                {
+                    path.append("~0");
+                }
+                else if (c == '/')
+                {
+                    path.append("~1");
+                }
+                else
+                {
+                    path.push_back(c);
+                }
+            }
+        }
+    }
+
+} // namespace kie::serde_json
+
+#endif
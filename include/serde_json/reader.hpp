@@ -0,0 +1,1696 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_READER_HPP
+#define KIE_TOOLBOX_SERDE_JSON_READER_HPP
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+#include <boost/pfr.hpp>
+#include <nlohmann/json.hpp>
+
+
+#include "../serde/field.hpp"
+#include "../serde/lazy.hpp"
+#include "../serde/reflection.hpp"
+#include "pointer.hpp"
+#include "simd.hpp"
+#include "type_trait.hpp"
+#include "utf8.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief The type of a json value.
+     *
+     * It's used to report what is expected and what is actually found when reading fails.
+     *
+     */
+    enum class value_type
+    {
+        null,
+        boolean,
+        number,
+        string,
+        array,
+        object,
+    };
+
+    /** @brief The reason why reading json fails.
+     *
+     */
+    enum class read_errc
+    {
+        none,
+        unexpected_end,
+        syntax_error,
+        invalid_string,
+        invalid_number,
+        number_overflow,
+        type_mismatch,
+        missing_field,
+        no_arena,
+        column_length,
+    };
+
+    /** @brief The detail of a failed read.
+     *
+     * It does not own anything, so creating one never allocates.
+     *
+     */
+    struct read_error
+    {
+        read_errc code = read_errc::none;
+        /// The byte offset in the input where reading stops.
+        std::size_t position = 0;
+        /// Valid when code is `type_mismatch`.
+        value_type expected = value_type::null;
+        /// Valid when code is `type_mismatch`.
+        value_type actual = value_type::null;
+        /// Valid when code is `missing_field` or `column_length`. It's the tag of the Field.
+        std::string_view key;
+        /// Valid when code is `number_overflow`. It's the number in the input.
+        std::string_view text;
+
+        explicit operator bool() const
+        {
+            return code != read_errc::none;
+        }
+    };
+
+    /** @brief How json is read.
+     *
+     */
+    struct read_options
+    {
+        /// The memory resource for the allocator-aware Fields and the escaped string_views, or null to leave them as they are.
+        std::pmr::memory_resource *resource = nullptr;
+        /// Skip the values that no Field takes, like the ones of unknown keys, by matching only their quotes and brackets.
+        /// It's much faster when most of the input is not modeled, but the errors inside the skipped values are not reported.
+        bool projection = false;
+    };
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief A json number as it is read, before it's converted to the target type.
+         *
+         * It's kept in the same three kinds as nlohmann_json does, so the conversion is the same.
+         *
+         */
+        struct number
+        {
+            enum class kind
+            {
+                integer,
+                unsigned_integer,
+                floating,
+            };
+
+            kind type = kind::integer;
+            std::int64_t integer = 0;
+            std::uint64_t unsigned_integer = 0;
+            double floating = 0;
+
+            template <typename T>
+            T get() const
+            {
+                switch (type)
+                {
+                case kind::integer:
+                    return static_cast<T>(integer);
+                case kind::unsigned_integer:
+                    return static_cast<T>(unsigned_integer);
+                default:
+                    return static_cast<T>(floating);
+                }
+            }
+        };
+
+        /** @brief An output buffer that drops everything. It's used to validate a string without keeping it.
+         *
+         */
+        struct discard
+        {
+            void append(const char *, std::size_t) {}
+            void push_back(char) {}
+        };
+
+        /** @brief A json tokenizer that works on a contiguous input.
+         *
+         * It reads the input once from the beginning to the end. It does not build any tree and
+         * does not throw, every function returns false and records the error when it fails.
+         *
+         */
+        class reader
+        {
+            const char *begin;
+            const char *cur;
+            const char *end;
+            std::string key_buffer;
+            std::string string_buffer;
+
+        public:
+            read_error error;
+
+            /** @brief The memory resource that the allocator-aware values are built in.
+             *
+             * The `std::string_view` values that have escapes are copied to it as well. It's null by
+             * default, which leaves the allocators as they are.
+             */
+            std::pmr::memory_resource *resource = nullptr;
+
+            /** @brief Whether the values that are not needed are skipped by `skip_structure` instead of `skip_value`.
+             *
+             */
+            bool projection = false;
+
+            /** @brief The JSON Pointer to the value where reading fails, like `/records/3/name`.
+             *
+             * It's built while the failure returns through the objects and arrays, so it costs nothing
+             * when reading succeeds. It's empty if the failure is at the root.
+             */
+            std::string path;
+
+            explicit reader(std::string_view input) : begin(input.data()), cur(input.data()), end(input.data() + input.size()) {}
+
+            /** @brief Start reading in the middle of the input. The error positions are still counted from its beginning.
+             *
+             */
+            reader(std::string_view input, std::size_t position) : begin(input.data()), cur(input.data() + position), end(input.data() + input.size()) {}
+
+            /** @brief Get the current position, counted from the beginning of the input.
+             *
+             */
+            std::size_t offset() const
+            {
+                return static_cast<std::size_t>(cur - begin);
+            }
+
+            /** @brief Go back to a position got from `offset`, so the same value is read again.
+             *
+             */
+            void rewind(std::size_t position)
+            {
+                cur = begin + position;
+            }
+
+            /** @brief Record the error at current position.
+             *
+             * @return Always false, so it can be returned directly.
+             */
+            bool fail(read_errc code)
+            {
+                error.code = code;
+                error.position = static_cast<std::size_t>(cur - begin);
+                return false;
+            }
+
+            /** @brief Record that the failure is inside the member of key.
+             *
+             * @return Always false, so it can be returned directly.
+             */
+            bool fail_in(std::string_view key)
+            {
+                std::string token;
+                append_pointer_token(token, key);
+                path.insert(0, token);
+                return false;
+            }
+
+            /** @brief Record that the failure is inside the item at index.
+             *
+             * @return Always false, so it can be returned directly.
+             */
+            bool fail_in(std::size_t index)
+            {
+                path.insert(0, "/" + std::to_string(index));
+                return false;
+            }
+
+            /** @brief Record a type mismatch error at current position.
+             *
+             * @return Always false, so it can be returned directly.
+             */
+            bool mismatch(value_type expected, value_type actual)
+            {
+                error.expected = expected;
+                error.actual = actual;
+                return fail(read_errc::type_mismatch);
+            }
+
+            void skip_whitespace()
+            {
+                while (cur != end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t'))
+                {
+                    cur++;
+                }
+            }
+
+            /** @brief Peek the type of next value without consuming it.
+             *
+             */
+            bool next_type(value_type &type)
+            {
+                skip_whitespace();
+                if (cur == end)
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                switch (*cur)
+                {
+                case '{':
+                    type = value_type::object;
+                    return true;
+                case '[':
+                    type = value_type::array;
+                    return true;
+                case '"':
+                    type = value_type::string;
+                    return true;
+                case 't':
+                case 'f':
+                    type = value_type::boolean;
+                    return true;
+                case 'n':
+                    type = value_type::null;
+                    return true;
+                case '-':
+                case '0':
+                case '1':
+                case '2':
+                case '3':
+                case '4':
+                case '5':
+                case '6':
+                case '7':
+                case '8':
+                case '9':
+                    type = value_type::number;
+                    return true;
+                default:
+                    return fail(read_errc::syntax_error);
+                }
+            }
+
+            /** @brief Consume the character c after whitespace, like a comma or a colon.
+             *
+             */
+            bool consume(char c)
+            {
+                skip_whitespace();
+                if (cur == end)
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                if (*cur != c)
+                {
+                    return fail(read_errc::syntax_error);
+                }
+                cur++;
+                return true;
+            }
+
+            /** @brief Make sure there is nothing but whitespace left.
+             *
+             */
+            bool finish()
+            {
+                skip_whitespace();
+                return cur == end ? true : fail(read_errc::syntax_error);
+            }
+
+            bool read_literal(std::string_view literal)
+            {
+                if (static_cast<std::size_t>(end - cur) < literal.size())
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                if (std::string_view{cur, literal.size()} != literal)
+                {
+                    return fail(read_errc::syntax_error);
+                }
+                cur += literal.size();
+                return true;
+            }
+
+            bool read_null()
+            {
+                return read_literal("null");
+            }
+
+            bool read_boolean(bool &value)
+            {
+                value = *cur == 't';
+                return read_literal(value ? "true" : "false");
+            }
+
+            bool read_number(number &value)
+            {
+                const char *start = cur;
+                const bool negative = *cur == '-';
+                if (negative)
+                {
+                    cur++;
+                }
+
+                if (cur == end)
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                if (*cur == '0')
+                {
+                    cur++;
+                }
+                else if (*cur >= '1' && *cur <= '9')
+                {
+                    skip_digits();
+                }
+                else
+                {
+                    return fail(read_errc::invalid_number);
+                }
+
+                bool is_float = false;
+                if (cur != end && *cur == '.')
+                {
+                    cur++;
+                    if (!skip_digits())
+                    {
+                        return fail(read_errc::invalid_number);
+                    }
+                    is_float = true;
+                }
+                if (cur != end && (*cur == 'e' || *cur == 'E'))
+                {
+                    cur++;
+                    if (cur != end && (*cur == '+' || *cur == '-'))
+                    {
+                        cur++;
+                    }
+                    if (!skip_digits())
+                    {
+                        return fail(read_errc::invalid_number);
+                    }
+                    is_float = true;
+                }
+
+                if (!is_float)
+                {
+                    // the integer that overflows is read as floating number, like nlohmann_json does.
+                    if (negative && std::from_chars(start, cur, value.integer).ec == std::errc{})
+                    {
+                        value.type = number::kind::integer;
+                        return true;
+                    }
+                    if (!negative && std::from_chars(start, cur, value.unsigned_integer).ec == std::errc{})
+                    {
+                        value.type = number::kind::unsigned_integer;
+                        return true;
+                    }
+                }
+
+                value.type = number::kind::floating;
+                if (std::from_chars(start, cur, value.floating).ec != std::errc{})
+                {
+                    // out of range, so it overflows if it's not below 1. Otherwise it underflows, and some
+                    // versions of from_chars report the subnormal numbers as out of range as well, so they are
+                    // read with the wider exponent of long double, or become zero if even that underflows.
+                    long double wide = 0;
+                    value.floating = std::from_chars(start, cur, wide).ec == std::errc{} ? static_cast<double>(wide) : (negative ? -0.0 : 0.0);
+                    if (decimal_exponent(start, cur) >= 0)
+                    {
+                        error.text = std::string_view{start, static_cast<std::size_t>(cur - start)};
+                        cur = start;
+                        return fail(read_errc::number_overflow);
+                    }
+                }
+                return true;
+            }
+
+            /** @brief Read a json string and append the unescaped content to out.
+             *
+             * The string is validated as it's read, so control characters, bad escapes and invalid
+             * UTF-8 are all rejected. The runs between escapes are found and validated by the SIMD
+             * kernels picked for the running CPU.
+             *
+             * @param out The buffer to append to. It's not cleared.
+             */
+            template <type_trait::is_output_buffer S>
+            bool read_string(S &out)
+            {
+                const auto &kernels = simd::active();
+                cur++; // the quote
+                while (true)
+                {
+                    const char *run = cur;
+                    cur += kernels.find_escape(cur, static_cast<std::size_t>(end - cur));
+                    const auto run_size = static_cast<std::size_t>(cur - run);
+                    if (!kernels.validate_utf8(run, run_size))
+                    {
+                        // a run ends with an ASCII byte or the end of input, so a truncated sequence is only an error there.
+                        std::size_t bad = 0;
+                        utf8_validate(reinterpret_cast<const unsigned char *>(run), run_size, bad);
+                        cur = run + bad;
+                        return fail(cur == end ? read_errc::unexpected_end : read_errc::invalid_string);
+                    }
+                    if (cur == end)
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    out.append(run, run_size);
+                    if (*cur == '"')
+                    {
+                        cur++;
+                        return true;
+                    }
+                    if (*cur != '\\')
+                    {
+                        return fail(read_errc::invalid_string);
+                    }
+                    if (!read_escape(out))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            /** @brief Take the string at current position as a view into the input.
+             *
+             * It only works if the string has no escape, which is almost always the case. Nothing is
+             * consumed if it doesn't work, and the caller should fall back to `read_string`.
+             *
+             */
+            bool try_read_view(std::string_view &out) noexcept
+            {
+                const auto &kernels = simd::active();
+                const char *start = cur + 1;
+                const std::size_t size = kernels.find_escape(start, static_cast<std::size_t>(end - start));
+                if (start + size == end || start[size] != '"' || !kernels.validate_utf8(start, size))
+                {
+                    return false;
+                }
+                out = std::string_view{start, size};
+                cur = start + size + 1;
+                return true;
+            }
+
+            /** @brief Read a json string as a view.
+             *
+             * The view points into the input if the string has no escape. Otherwise the unescaped
+             * string is copied to the memory resource, and it fails if there is none.
+             *
+             */
+            bool read_string_view(std::string_view &out)
+            {
+                if (try_read_view(out))
+                {
+                    return true;
+                }
+                const char *start = cur;
+                string_buffer.clear();
+                if (!read_string(string_buffer))
+                {
+                    return false;
+                }
+                if (resource == nullptr)
+                {
+                    cur = start;
+                    return fail(read_errc::no_arena);
+                }
+                auto *copy = static_cast<char *>(resource->allocate(string_buffer.size(), alignof(char)));
+                std::memcpy(copy, string_buffer.data(), string_buffer.size());
+                out = std::string_view{copy, string_buffer.size()};
+                return true;
+            }
+
+            /** @brief Read the key of an object member, including the following colon.
+             *
+             * The key points into the input if it has no escape, which is almost always the case.
+             * Otherwise it points to an internal buffer and is valid until the next key is read.
+             *
+             */
+            bool read_key(std::string_view &key)
+            {
+                skip_whitespace();
+                if (cur == end)
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                if (*cur != '"')
+                {
+                    return fail(read_errc::syntax_error);
+                }
+
+                if (!try_read_view(key))
+                {
+                    key_buffer.clear();
+                    if (!read_string(key_buffer))
+                    {
+                        return false;
+                    }
+                    key = key_buffer;
+                }
+                return consume(':');
+            }
+
+            /** @brief Read an object, and call `on_member(key)` for every member.
+             *
+             * The callback must read the value of the member, and return false if it fails.
+             *
+             */
+            template <typename F>
+            bool read_object(F &&on_member)
+            {
+                cur++; // the brace
+                skip_whitespace();
+                if (cur != end && *cur == '}')
+                {
+                    cur++;
+                    return true;
+                }
+                while (true)
+                {
+                    std::string_view key;
+                    if (!read_key(key) || !on_member(key))
+                    {
+                        return false;
+                    }
+                    skip_whitespace();
+                    if (cur == end)
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    if (*cur == '}')
+                    {
+                        cur++;
+                        return true;
+                    }
+                    if (*cur != ',')
+                    {
+                        return fail(read_errc::syntax_error);
+                    }
+                    cur++;
+                }
+            }
+
+            /** @brief Read an array, and call `on_item()` for every item.
+             *
+             * The callback must read the item, and return false if it fails.
+             *
+             */
+            template <typename F>
+            bool read_array(F &&on_item)
+            {
+                cur++; // the bracket
+                skip_whitespace();
+                if (cur != end && *cur == ']')
+                {
+                    cur++;
+                    return true;
+                }
+                while (true)
+                {
+                    if (!on_item())
+                    {
+                        return false;
+                    }
+                    skip_whitespace();
+                    if (cur == end)
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    if (*cur == ']')
+                    {
+                        cur++;
+                        return true;
+                    }
+                    if (*cur != ',')
+                    {
+                        return fail(read_errc::syntax_error);
+                    }
+                    cur++;
+                }
+            }
+
+            /** @brief Skip next value, which may be of any type.
+             *
+             * The skipped value is still validated. It does not recurse, so deep nesting can't
+             * overflow the stack.
+             *
+             */
+            bool skip_value()
+            {
+                nesting_stack nesting;
+                value_type type = value_type::null;
+                while (true)
+                {
+                    if (!next_type(type))
+                    {
+                        return false;
+                    }
+                    bool scalar = true;
+                    switch (type)
+                    {
+                    case value_type::object:
+                    case value_type::array:
+                    {
+                        const char close = type == value_type::object ? '}' : ']';
+                        cur++;
+                        skip_whitespace();
+                        if (cur != end && *cur == close)
+                        {
+                            cur++;
+                            break;
+                        }
+                        nesting.push(type == value_type::object);
+                        if (type == value_type::object && !skip_key())
+                        {
+                            return false;
+                        }
+                        scalar = false;
+                        break;
+                    }
+                    default:
+                        if (!skip_scalar(type))
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                    if (!scalar)
+                    {
+                        continue;
+                    }
+
+                    // a value is finished, close all the containers that end here.
+                    while (!nesting.empty())
+                    {
+                        skip_whitespace();
+                        if (cur == end)
+                        {
+                            return fail(read_errc::unexpected_end);
+                        }
+                        const bool is_object = nesting.top();
+                        if (*cur == (is_object ? '}' : ']'))
+                        {
+                            cur++;
+                            nesting.pop();
+                            continue;
+                        }
+                        if (*cur != ',')
+                        {
+                            return fail(read_errc::syntax_error);
+                        }
+                        cur++;
+                        if (is_object && !skip_key())
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                    if (nesting.empty())
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            /** @brief Skip next value by matching only its quotes and brackets.
+             *
+             * The quotes and brackets are found by the SIMD kernels and nothing else is looked at, so
+             * it's much faster than `skip_value`. Only the end of the strings and the nesting depth
+             * are checked, anything else may be wrong in the skipped value.
+             *
+             */
+            bool skip_structure()
+            {
+                value_type type = value_type::null;
+                if (!next_type(type))
+                {
+                    return false;
+                }
+                if (type == value_type::string)
+                {
+                    return skip_string_structure();
+                }
+                if (type != value_type::object && type != value_type::array)
+                {
+                    // a scalar ends where the next token or whitespace starts.
+                    while (cur != end && *cur != ',' && *cur != '}' && *cur != ']' && *cur != ' ' && *cur != '\n' && *cur != '\r' && *cur != '\t')
+                    {
+                        cur++;
+                    }
+                    return true;
+                }
+
+                const auto &kernels = simd::active();
+                std::size_t depth = 0;
+                while (true)
+                {
+                    cur += kernels.find_structural(cur, static_cast<std::size_t>(end - cur));
+                    if (cur == end)
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    switch (*cur)
+                    {
+                    case '"':
+                        if (!skip_string_structure())
+                        {
+                            return false;
+                        }
+                        break;
+                    case '[':
+                    case '{':
+                        depth++;
+                        cur++;
+                        break;
+                    default:
+                        cur++;
+                        if (--depth == 0)
+                        {
+                            return true;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            /** @brief Skip a value whose content is not needed, in the way chosen by `projection`.
+             *
+             */
+            bool skip_unneeded()
+            {
+                return projection ? skip_structure() : skip_value();
+            }
+
+            /** @brief Replace an error found after the syntax, like a Field of wrong type, with the first syntax error of the input.
+             *
+             * nlohmann_json parses the whole input before converting it, so a syntax error anywhere comes
+             * first. The whole input is checked by `skip_value` again, which only happens when reading fails.
+             * The path is cleared if the error is replaced, since the syntax check doesn't build it.
+             */
+            void prefer_syntax_error()
+            {
+                switch (error.code)
+                {
+                case read_errc::type_mismatch:
+                case read_errc::missing_field:
+                case read_errc::no_arena:
+                case read_errc::column_length:
+                    break;
+                default:
+                    return;
+                }
+                reader check{std::string_view{begin, static_cast<std::size_t>(end - begin)}};
+                if (!check.skip_value() || !check.finish())
+                {
+                    error = check.error;
+                    path.clear();
+                }
+            }
+
+            /** @brief Skip next value, and take its text as it is in the input.
+             *
+             * It's always skipped by `skip_value`, even under projection, since the text is written back
+             * verbatim and must be valid json.
+             */
+            bool read_raw(std::string_view &raw)
+            {
+                skip_whitespace();
+                const char *start = cur;
+                if (!skip_value())
+                {
+                    return false;
+                }
+                raw = std::string_view{start, static_cast<std::size_t>(cur - start)};
+                return true;
+            }
+
+        private:
+            /** @brief One bit per nesting level, set for object. Only very deep nesting allocates.
+             *
+             */
+            class nesting_stack
+            {
+                std::uint64_t bits = 0;
+                std::size_t depth = 0;
+                std::vector<bool> spill;
+
+            public:
+                bool empty() const
+                {
+                    return depth == 0;
+                }
+
+                void push(bool is_object)
+                {
+                    if (depth < 64)
+                    {
+                        bits = is_object ? (bits | (std::uint64_t{1} << depth)) : (bits & ~(std::uint64_t{1} << depth));
+                    }
+                    else
+                    {
+                        spill.push_back(is_object);
+                    }
+                    depth++;
+                }
+
+                bool top() const
+                {
+                    return depth <= 64 ? (bits >> (depth - 1)) & 1 : spill.back();
+                }
+
+                void pop()
+                {
+                    depth--;
+                    if (depth >= 64)
+                    {
+                        spill.pop_back();
+                    }
+                }
+            };
+
+            /** @brief Get the decimal exponent of the first significant digit of a number that is validated, e.g. 2 for `-123.4` and -2 for `0.01e0`.
+             *
+             * It saturates far beyond the range of double, and it's for the numbers that are not zero.
+             */
+            static std::int64_t decimal_exponent(const char *start, const char *end)
+            {
+                constexpr std::int64_t limit = 1000000;
+                const char *p = start + (*start == '-' ? 1 : 0);
+                std::int64_t exponent = -1;
+                while (p != end && *p == '0')
+                {
+                    p++;
+                }
+                while (p != end && *p >= '0' && *p <= '9')
+                {
+                    exponent = std::min(exponent + 1, limit);
+                    p++;
+                }
+                if (p != end && *p == '.')
+                {
+                    p++;
+                    if (exponent < 0)
+                    {
+                        while (p != end && *p == '0')
+                        {
+                            exponent = std::max(exponent - 1, -limit);
+                            p++;
+                        }
+                    }
+                    while (p != end && *p >= '0' && *p <= '9')
+                    {
+                        p++;
+                    }
+                }
+                if (p != end && (*p == 'e' || *p == 'E'))
+                {
+                    p++;
+                    const bool negative = *p == '-';
+                    p += (*p == '-' || *p == '+') ? 1 : 0;
+                    std::int64_t e = 0;
+                    while (p != end && *p >= '0' && *p <= '9')
+                    {
+                        e = std::min(e * 10 + (*p - '0'), limit);
+                        p++;
+                    }
+                    exponent += negative ? -e : e;
+                }
+                return exponent;
+            }
+
+            bool skip_digits()
+            {
+                const char *start = cur;
+                while (cur != end && *cur >= '0' && *cur <= '9')
+                {
+                    cur++;
+                }
+                return cur != start;
+            }
+
+            /** @brief Jump to the end of the string at current position, only the escaped quotes are cared about.
+             *
+             */
+            bool skip_string_structure()
+            {
+                const auto &kernels = simd::active();
+                cur++; // the quote
+                while (true)
+                {
+                    cur += kernels.find_escape(cur, static_cast<std::size_t>(end - cur));
+                    if (cur == end)
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    if (*cur == '"')
+                    {
+                        cur++;
+                        return true;
+                    }
+                    if (*cur == '\\' && end - cur < 2)
+                    {
+                        cur = end;
+                        return fail(read_errc::unexpected_end);
+                    }
+                    cur += *cur == '\\' ? 2 : 1;
+                }
+            }
+
+            bool skip_key()
+            {
+                std::string_view key;
+                return read_key(key);
+            }
+
+            bool skip_scalar(value_type type)
+            {
+                switch (type)
+                {
+                case value_type::string:
+                {
+                    discard out;
+                    return read_string(out);
+                }
+                case value_type::number:
+                {
+                    number n;
+                    return read_number(n);
+                }
+                case value_type::boolean:
+                {
+                    bool b;
+                    return read_boolean(b);
+                }
+                default:
+                    return read_null();
+                }
+            }
+
+            static int hex_value(char c)
+            {
+                if (c >= '0' && c <= '9')
+                {
+                    return c - '0';
+                }
+                if (c >= 'a' && c <= 'f')
+                {
+                    return c - 'a' + 10;
+                }
+                if (c >= 'A' && c <= 'F')
+                {
+                    return c - 'A' + 10;
+                }
+                return -1;
+            }
+
+            bool read_hex4(std::uint32_t &value)
+            {
+                if (end - cur < 4)
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                value = 0;
+                for (int i = 0; i < 4; i++, cur++)
+                {
+                    const int digit = hex_value(*cur);
+                    if (digit < 0)
+                    {
+                        return fail(read_errc::invalid_string);
+                    }
+                    value = (value << 4) | static_cast<std::uint32_t>(digit);
+                }
+                return true;
+            }
+
+            template <type_trait::is_output_buffer S>
+            bool read_escape(S &out)
+            {
+                cur++; // the backslash
+                if (cur == end)
+                {
+                    return fail(read_errc::unexpected_end);
+                }
+                switch (*cur++)
+                {
+                case '"':
+                    out.push_back('"');
+                    return true;
+                case '\\':
+                    out.push_back('\\');
+                    return true;
+                case '/':
+                    out.push_back('/');
+                    return true;
+                case 'b':
+                    out.push_back('\b');
+                    return true;
+                case 'f':
+                    out.push_back('\f');
+                    return true;
+                case 'n':
+                    out.push_back('\n');
+                    return true;
+                case 'r':
+                    out.push_back('\r');
+                    return true;
+                case 't':
+                    out.push_back('\t');
+                    return true;
+                case 'u':
+                    break;
+                default:
+                    cur--;
+                    return fail(read_errc::invalid_string);
+                }
+
+                std::uint32_t code_point = 0;
+                if (!read_hex4(code_point))
+                {
+                    return false;
+                }
+                if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+                {
+                    return fail(read_errc::invalid_string);
+                }
+                if (code_point >= 0xD800 && code_point <= 0xDBFF)
+                {
+                    // a high surrogate must be followed by a low surrogate.
+                    std::uint32_t low = 0;
+                    if (end - cur < 2 || cur[0] != '\\' || cur[1] != 'u')
+                    {
+                        return fail(read_errc::invalid_string);
+                    }
+                    cur += 2;
+                    if (!read_hex4(low))
+                    {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF)
+                    {
+                        return fail(read_errc::invalid_string);
+                    }
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+                char buffer[4];
+                out.append(buffer, utf8_encode(code_point, buffer));
+                return true;
+            }
+        };
+
+        /** @brief Check if the arithmetic type T accepts json boolean.
+         *
+         * nlohmann_json converts boolean to arithmetic types, except for the three types it uses
+         * to store numbers, and enums.
+         *
+         */
+        template <typename T>
+        constexpr bool accepts_boolean = !std::is_same_v<T, std::int64_t> && !std::is_same_v<T, std::uint64_t> && !std::is_same_v<T, double>;
+
+        template <typename T>
+        bool read_value(reader &r, T &t);
+
+        template <typename T>
+        void parse_lazy(std::string_view raw, T &value);
+
+        /** @brief Make t use the memory resource of the reader, if it uses `std::pmr::polymorphic_allocator`.
+         *
+         * The allocator of a container can't be changed after construction, and assignment doesn't
+         * propagate it either, so t is rebuilt in place with the allocator. Its content is kept,
+         * but it's almost always empty at this point.
+         *
+         */
+        template <typename T>
+        void use_resource(const reader &r, T &t)
+        {
+            if constexpr (std::uses_allocator_v<T, std::pmr::polymorphic_allocator<>> && requires { t.get_allocator().resource(); })
+            {
+                if (r.resource != nullptr && t.get_allocator().resource() != r.resource)
+                {
+                    T replacement = std::make_obj_using_allocator<T>(std::pmr::polymorphic_allocator<>{r.resource}, std::move(t));
+                    std::destroy_at(&t);
+                    std::construct_at(&t, std::move(replacement));
+                }
+            }
+        }
+
+        /** @brief Whether each member of T is read from json.
+         *
+         * The members that are not Field are not. The Fields hidden by a later one of the same tag are
+         * read from the same key.
+         *
+         */
+        template <typename T>
+        constexpr auto read_members = []
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            std::array<bool, boost::pfr::tuple_size_v<T>> result{};
+            const auto mark = [&](const auto &members)
+            {
+                for (std::size_t i : members)
+                {
+                    result[i] = true;
+                }
+            };
+            [&]<std::size_t... K>(std::index_sequence<K...>)
+            {
+                (mark(fields::template hidden<K>), ...);
+            }(std::make_index_sequence<fields::size>{});
+            mark(fields::index);
+            return result;
+        }();
+
+        template <typename T, std::size_t I>
+        void reset_member(T &t, T &fresh)
+        {
+            if constexpr (!read_members<T>[I])
+            {
+                boost::pfr::get<I>(t) = std::move(boost::pfr::get<I>(fresh));
+            }
+        }
+
+        /** @brief Reset the members of t that are not read from json, as if t were built anew.
+         *
+         * The Fields are left as they are to be read over. Nothing is done for the aggregate of Fields only.
+         *
+         */
+        template <typename T>
+        void reset_unread(T &t)
+        {
+            constexpr std::size_t count = boost::pfr::tuple_size_v<T>;
+            if constexpr (kie::serde::reflection::fields<T>::size < count)
+            {
+                T fresh{};
+                [&]<std::size_t... I>(std::index_sequence<I...>)
+                {
+                    (reset_member<T, I>(t, fresh), ...);
+                }(std::make_index_sequence<count>{});
+            }
+        }
+
+        /** @brief Read the value of the Kth Field of T, the position is known at compile time.
+         *
+         * The same value is read again into each Field that it hides, in the order of declaration, just
+         * like `from_json` gives the value of a key to all the Fields of that tag.
+         *
+         */
+        template <typename T, std::size_t K>
+        bool read_member(reader &r, T &t)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            constexpr auto &hidden = fields::template hidden<K>;
+            if constexpr (hidden.size() == 0)
+            {
+                return read_value(r, boost::pfr::get<fields::index[K]>(t).value);
+            }
+            else
+            {
+                const std::size_t start = r.offset();
+                const bool ok = [&]<std::size_t... J>(std::index_sequence<J...>)
+                {
+                    return ((r.rewind(start), read_value(r, boost::pfr::get<hidden[J]>(t).value)) && ...);
+                }(std::make_index_sequence<hidden.size()>{});
+                return ok && (r.rewind(start), read_value(r, boost::pfr::get<fields::index[K]>(t).value));
+            }
+        }
+
+        /** @brief Read a json object into an aggregate type.
+         *
+         * The value of each member is read into its Field as soon as the key is read. The keys that
+         * are not tag of any Field are skipped. All the Fields must be present, except the optional ones.
+         *
+         */
+        template <typename T>
+        bool read_object(reader &r, T &t)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            static constexpr auto readers = []<std::size_t... K>(std::index_sequence<K...>)
+            {
+                return std::array<bool (*)(reader &, T &), fields::size>{&read_member<T, K>...};
+            }(std::make_index_sequence<fields::size>{});
+
+            std::array<bool, fields::size> seen{};
+            const bool ok = r.read_object([&](std::string_view key)
+                                          {
+                const std::size_t k = fields::find(key);
+                if (k == fields::size)
+                {
+                    return r.skip_unneeded();
+                }
+                seen[k] = true;
+                return readers[k](r, t) || r.fail_in(fields::tags[k]); });
+            if (!ok)
+            {
+                return false;
+            }
+
+            // report the first missing one in the order of declaration, the optional ones get their default value.
+            const std::size_t missing = kie::serde::reflection::find_missing<T>(seen);
+            if (missing != fields::size)
+            {
+                r.error.key = fields::tags[missing];
+                r.fail(read_errc::missing_field);
+                return r.fail_in(fields::tags[missing]);
+            }
+            kie::serde::reflection::reset_missing(t, seen);
+            return true;
+        }
+
+        /** @brief Read a value into T, whatever T is.
+         *
+         * It follows how `from_json` converts a `nlohmann::json` to T:
+         * - Arithmetic types accept number, and boolean for most of them.
+         * - Container accepts array, and becomes empty for other types of value.
+         * - Aggregate with Fields accepts object. Aggregate without Field accepts anything and ignores it.
+         * - Lazy accepts anything, and only keeps its text until it's accessed.
+         * - std::optional accepts null, and whatever its value type accepts.
+         *
+         * Every value is overwritten in place, so the strings and containers that t already holds
+         * keep their memory, and reading into the same t again and again allocates nothing once they
+         * are large enough. The members that are not Field are reset, so t ends up the same as a new one.
+         *
+         */
+        template <typename T>
+        bool read_value(reader &r, T &t)
+        {
+            value_type type = value_type::null;
+            if (!r.next_type(type))
+            {
+                return false;
+            }
+
+            if constexpr (type_trait::is_string<T>)
+            {
+                if (type != value_type::string)
+                {
+                    return r.mismatch(value_type::string, type);
+                }
+                use_resource(r, t);
+                t.clear();
+                return r.read_string(t);
+            }
+            else if constexpr (type_trait::is_string_view<T>)
+            {
+                if (type != value_type::string)
+                {
+                    return r.mismatch(value_type::string, type);
+                }
+                return r.read_string_view(t);
+            }
+            else if constexpr (kie::serde::type_trait::is_lazy<T>::value)
+            {
+                std::string_view raw;
+                if (!r.read_raw(raw))
+                {
+                    return false;
+                }
+                t.assign_raw(raw, &parse_lazy<typename T::Type>);
+                return true;
+            }
+            else if constexpr (type_trait::is_specialization_of<T, std::optional>::value)
+            {
+                if (type == value_type::null)
+                {
+                    t.reset();
+                    return r.read_null();
+                }
+                if (!t)
+                {
+                    t.emplace();
+                }
+                return read_value(r, *t);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                if (type != value_type::boolean)
+                {
+                    return r.mismatch(value_type::boolean, type);
+                }
+                return r.read_boolean(t);
+            }
+            else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            {
+                if (type == value_type::number)
+                {
+                    number n;
+                    if (!r.read_number(n))
+                    {
+                        return false;
+                    }
+                    if constexpr (std::is_enum_v<T>)
+                    {
+                        t = static_cast<T>(n.get<std::underlying_type_t<T>>());
+                    }
+                    else
+                    {
+                        t = n.get<T>();
+                    }
+                    return true;
+                }
+                if constexpr (std::is_arithmetic_v<T> && accepts_boolean<T>)
+                {
+                    if (type == value_type::boolean)
+                    {
+                        bool b;
+                        if (!r.read_boolean(b))
+                        {
+                            return false;
+                        }
+                        t = static_cast<T>(b);
+                        return true;
+                    }
+                }
+                return r.mismatch(value_type::number, type);
+            }
+            else if constexpr (type_trait::is_dynamic_container<T>)
+            {
+                use_resource(r, t);
+                if (type != value_type::array)
+                {
+                    t.clear();
+                    return r.skip_unneeded();
+                }
+                if constexpr (std::is_same_v<typename T::value_type, bool>)
+                {
+                    t.clear();
+                    return r.read_array([&]
+                                        {
+                        bool item = false;
+                        if (!read_value(r, item))
+                        {
+                            return r.fail_in(t.size());
+                        }
+                        t.push_back(item);
+                        return true; });
+                }
+                else
+                {
+                    // the items are read over the existing ones, so the memory they hold is reused.
+                    const std::size_t old_size = t.size();
+                    std::size_t size = 0;
+                    auto it = t.begin();
+                    const bool ok = r.read_array([&]
+                                                 {
+                        const std::size_t i = size++;
+                        return (i < old_size ? read_value(r, *it++) : read_value(r, t.emplace_back())) || r.fail_in(i); });
+                    if (size < old_size)
+                    {
+                        t.erase(it, t.end());
+                    }
+                    return ok;
+                }
+            }
+            else if constexpr (type_trait::is_array_class<T>::value)
+            {
+                if (type != value_type::array)
+                {
+                    t = T{};
+                    return r.skip_unneeded();
+                }
+                std::size_t i = 0;
+                const bool ok = r.read_array([&]
+                                             {
+                    if (i == t.size())
+                    {
+                        return r.skip_unneeded();
+                    }
+                    const std::size_t index = i++;
+                    return read_value(r, t[index]) || r.fail_in(index); });
+                for (; ok && i < t.size(); i++)
+                {
+                    t[i] = typename T::value_type{};
+                }
+                return ok;
+            }
+            else if constexpr (kie::serde::reflection::fields<T>::size == 0)
+            {
+                t = T{};
+                return r.skip_unneeded();
+            }
+            else
+            {
+                if (type != value_type::object)
+                {
+                    return r.mismatch(value_type::object, type);
+                }
+                // the Fields are read over the existing values, and the other members are reset.
+                reset_unread(t);
+                return read_object(r, t);
+            }
+        }
+
+        inline std::string to_string(value_type type)
+        {
+            switch (type)
+            {
+            case value_type::null:
+                return "null";
+            case value_type::boolean:
+                return "boolean";
+            case value_type::number:
+                return "number";
+            case value_type::string:
+                return "string";
+            case value_type::array:
+                return "array";
+            default:
+                return "object";
+            }
+        }
+
+        /** @brief Throw the read error as the same exception that nlohmann_json throws in the same case.
+         *
+         */
+        [[noreturn]] inline void throw_read_error(const read_error &error)
+        {
+            const std::size_t byte = error.position + 1;
+            switch (error.code)
+            {
+            case read_errc::type_mismatch:
+                if (error.expected == value_type::object)
+                {
+                    throw nlohmann::json::type_error::create(304, "cannot use at() with " + to_string(error.actual), nullptr);
+                }
+                throw nlohmann::json::type_error::create(302, "type must be " + to_string(error.expected) + ", but is " + to_string(error.actual), nullptr);
+            case read_errc::missing_field:
+                throw nlohmann::json::out_of_range::create(403, "key '" + std::string{error.key} + "' not found", nullptr);
+            case read_errc::number_overflow:
+                throw nlohmann::json::out_of_range::create(406, "number overflow parsing '" + std::string{error.text} + "'", nullptr);
+            case read_errc::column_length:
+                throw nlohmann::json::other_error::create(502, "column '" + std::string{error.key} + "' at byte " + std::to_string(byte) + " has a different length from the others", nullptr);
+            case read_errc::no_arena:
+                throw nlohmann::json::other_error::create(501, "string with escapes at byte " + std::to_string(byte) + " can't be read as string_view without a memory resource", nullptr);
+            case read_errc::unexpected_end:
+                throw nlohmann::json::parse_error::create(101, byte, "syntax error while parsing value - unexpected end of input", nullptr);
+            case read_errc::invalid_string:
+                throw nlohmann::json::parse_error::create(101, byte, "syntax error while parsing value - invalid string", nullptr);
+            case read_errc::invalid_number:
+                throw nlohmann::json::parse_error::create(101, byte, "syntax error while parsing value - invalid number", nullptr);
+            default:
+                throw nlohmann::json::parse_error::create(101, byte, "syntax error while parsing value - unexpected character", nullptr);
+            }
+        }
+
+        /** @brief Read the whole input of the reader into t.
+         *
+         * @return false if it fails, and the reader holds the error and the path to it.
+         */
+        template <typename T>
+        bool read_document(reader &r, T &t, const read_options &options)
+        {
+            r.resource = options.resource;
+            r.projection = options.projection;
+            if (read_value(r, t) && r.finish())
+            {
+                return true;
+            }
+            r.prefer_syntax_error();
+            return false;
+        }
+
+        /** @brief Read the whole input into t, and throw if it fails.
+         *
+         * @param options The memory resource, and whether the values that are not needed are scanned quickly.
+         */
+        template <typename T>
+        void read_json(std::string_view json_str, T &t, const read_options &options)
+        {
+            reader r{json_str};
+            if (!read_document(r, t, options))
+            {
+                throw_read_error(r.error);
+            }
+        }
+
+        /** @brief Read the whole input into t, and throw if it fails.
+         *
+         * @param resource If it's not null, the strings and containers that use `std::pmr::polymorphic_allocator` are built in it.
+         */
+        template <typename T>
+        void read_json(std::string_view json_str, T &t, std::pmr::memory_resource *resource = nullptr)
+        {
+            read_json(json_str, t, read_options{.resource = resource});
+        }
+
+        /** @brief Parse the raw text kept by `kie::serde::Lazy`.
+         *
+         * The text has been checked when it's read, so it only throws if T doesn't match it. The byte
+         * offsets in the exceptions are counted from the beginning of the text.
+         *
+         */
+        template <typename T>
+        void parse_lazy(std::string_view raw, T &value)
+        {
+            read_json(raw, value);
+        }
+    }
+
+    /** @brief The result of reading json without exceptions, which holds either the value or the error.
+     *
+     * It's like `std::expected<T, read_error>`, with the JSON Pointer to where it fails.
+     *
+     * Usage:
+     * @code
+     * auto request = kie::serde_json::try_from_json<Request>(json_str);
+     * if (!request)
+     * {
+     *     log(request.path(), request.error().position);
+     *     return;
+     * }
+     * handle(*request);
+     * @endcode
+     *
+     * @param T The type of the value.
+     */
+    template <typename T>
+    class read_result
+    {
+        std::optional<T> result;
+        read_error failure;
+        std::string failure_path;
+
+    public:
+        /** @brief Hold the value that is read.
+         *
+         */
+        explicit read_result(T value) : result(std::move(value)) {}
+
+        /** @brief Hold the error, and the JSON Pointer to the value where it happens.
+         *
+         */
+        read_result(const read_error &error, std::string path) : failure(error), failure_path(std::move(path)) {}
+
+        /** @brief Check if the value is read.
+         *
+         */
+        bool has_value() const noexcept
+        {
+            return result.has_value();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return has_value();
+        }
+
+        /** @brief Get the value, or throw what `from_json` throws if there is an error.
+         *
+         */
+        T &value() &
+        {
+            if (!result)
+            {
+                impl::throw_read_error(failure);
+            }
+            return *result;
+        }
+
+        /** @brief Get the value, or throw what `from_json` throws if there is an error.
+         *
+         */
+        const T &value() const &
+        {
+            if (!result)
+            {
+                impl::throw_read_error(failure);
+            }
+            return *result;
+        }
+
+        /** @brief Get the value, or throw what `from_json` throws if there is an error.
+         *
+         */
+        T &&value() &&
+        {
+            return std::move(value());
+        }
+
+        /** @brief Get the value. It must be there.
+         *
+         */
+        T &operator*() noexcept
+        {
+            return *result;
+        }
+
+        const T &operator*() const noexcept
+        {
+            return *result;
+        }
+
+        T *operator->() noexcept
+        {
+            return &*result;
+        }
+
+        const T *operator->() const noexcept
+        {
+            return &*result;
+        }
+
+        /** @brief The error. Its code is `read_errc::none` if the value is read.
+         *
+         * The number text of `number_overflow` points into the input, so it's only valid while the input is.
+         */
+        const read_error &error() const noexcept
+        {
+            return failure;
+        }
+
+        /** @brief The JSON Pointer to the value where reading fails, like `/records/3/name`.
+         *
+         * It's the missing key itself for `missing_field`, and empty if the failure is at the root.
+         */
+        const std::string &path() const noexcept
+        {
+            return failure_path;
+        }
+    };
+
+} // namespace kie::serde_json
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_SIMD_HPP
+#define KIE_TOOLBOX_SERDE_JSON_SIMD_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+#include "utf8.hpp"
+
+
+// Define KIE_TOOLBOX_SERDE_JSON_NO_SIMD to always use the scalar kernels.
+#if !defined(KIE_TOOLBOX_SERDE_JSON_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define KIE_TOOLBOX_SERDE_JSON_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2
+#else
+#define KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief The string kernels used to write and read json strings.
+         *
+         * Every kernel comes in a scalar version, an SSE2 version and an AVX2 version. The widest one
+         * supported by the running CPU is picked at runtime, so the library needs no special compile
+         * flags.
+         *
+         */
+        namespace simd
+        {
+            /** @brief The instruction set a kernel is written with.
+             *
+             */
+            enum class level
+            {
+                scalar,
+                sse2,
+                avx2,
+            };
+
+            /** @brief A set of kernels of the same level.
+             *
+             * `find_escape` returns the index of the first quote, backslash or control character, or
+             * `size` if there is none. `validate_utf8` checks if the whole string is valid UTF-8, in the
+             * same way as `utf8_sequence_length` does. `find_structural` returns the index of the first
+             * quote or bracket, or `size` if there is none.
+             *
+             */
+            struct kernels
+            {
+                simd::level level;
+                std::size_t (*find_escape)(const char *data, std::size_t size) noexcept;
+                bool (*validate_utf8)(const char *data, std::size_t size) noexcept;
+                std::size_t (*find_structural)(const char *data, std::size_t size) noexcept;
+            };
+
+            inline std::size_t find_escape_scalar(const char *data, std::size_t size) noexcept
+            {
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    const auto c = static_cast<unsigned char>(data[i]);
+                    if (c == '"' || c == '\\' || c < 0x20)
+                    {
+                        return i;
+                    }
+                }
+                return size;
+            }
+
+            inline bool validate_utf8_scalar(const char *data, std::size_t size) noexcept
+            {
+                std::size_t bad = 0;
+                return utf8_validate(reinterpret_cast<const unsigned char *>(data), size, bad);
+            }
+
+            inline std::size_t find_structural_scalar(const char *data, std::size_t size) noexcept
+            {
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    const auto c = static_cast<unsigned char>(data[i]);
+                    // the brackets and the braces only differ in bit 0x20.
+                    if (c == '"' || (c | 0x20) == '{' || (c | 0x20) == '}')
+                    {
+                        return i;
+                    }
+                }
+                return size;
+            }
+
+#ifdef KIE_TOOLBOX_SERDE_JSON_SIMD_X86
+            inline std::size_t find_structural_sse2(const char *data, std::size_t size) noexcept
+            {
+                const __m128i quote = _mm_set1_epi8('"');
+                const __m128i lower = _mm_set1_epi8(0x20);
+                const __m128i open = _mm_set1_epi8('{');
+                const __m128i close = _mm_set1_epi8('}');
+                std::size_t i = 0;
+                for (; i + 16 <= size; i += 16)
+                {
+                    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                    const __m128i folded = _mm_or_si128(chunk, lower);
+                    const __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)));
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+                    if (mask != 0)
+                    {
+                        return i + static_cast<std::size_t>(std::countr_zero(mask));
+                    }
+                }
+                return i + find_structural_scalar(data + i, size - i);
+            }
+
+            inline std::size_t find_escape_sse2(const char *data, std::size_t size) noexcept
+            {
+                const __m128i quote = _mm_set1_epi8('"');
+                const __m128i backslash = _mm_set1_epi8('\\');
+                const __m128i control = _mm_set1_epi8(0x1F);
+                std::size_t i = 0;
+                for (; i + 16 <= size; i += 16)
+                {
+                    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                    // c <= 0x1F as unsigned is the same as min(c, 0x1F) == c.
+                    const __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                                       _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+                    if (mask != 0)
+                    {
+                        return i + static_cast<std::size_t>(std::countr_zero(mask));
+                    }
+                }
+                return i + find_escape_scalar(data + i, size - i);
+            }
+
+            /** @brief Skip ASCII 16 bytes at a time, and check the non-ASCII sequences one by one.
+             *
+             * SSE2 has no byte shuffle, so the table lookup used by the AVX2 kernel is not available.
+             *
+             */
+            inline bool validate_utf8_sse2(const char *data, std::size_t size) noexcept
+            {
+                const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+                std::size_t i = 0;
+                while (i + 16 <= size)
+                {
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))));
+                    if (mask == 0)
+                    {
+                        i += 16;
+                        continue;
+                    }
+                    // i is always at the start of a sequence, so the sequences can be checked from here.
+                    i += static_cast<std::size_t>(std::countr_zero(mask));
+                    while (i < size && bytes[i] >= 0x80)
+                    {
+                        std::size_t bad = 0;
+                        const std::size_t length = utf8_sequence_length(bytes, size, i, bad);
+                        if (length == 0)
+                        {
+                            return false;
+                        }
+                        i += length;
+                    }
+                }
+                return validate_utf8_scalar(data + i, size - i);
+            }
+
+            KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 inline std::size_t find_escape_avx2(const char *data, std::size_t size) noexcept
+            {
+                const __m256i quote = _mm256_set1_epi8('"');
+                const __m256i backslash = _mm256_set1_epi8('\\');
+                const __m256i control = _mm256_set1_epi8(0x1F);
+                std::size_t i = 0;
+                for (; i + 32 <= size; i += 32)
+                {
+                    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                    const __m256i found = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                                          _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+                    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+                    if (mask != 0)
+                    {
+                        return i + static_cast<std::size_t>(std::countr_zero(mask));
+                    }
+                }
+                return i + find_escape_sse2(data + i, size - i);
+            }
+
+            KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 inline std::size_t find_structural_avx2(const char *data, std::size_t size) noexcept
+            {
+                const __m256i quote = _mm256_set1_epi8('"');
+                const __m256i lower = _mm256_set1_epi8(0x20);
+                const __m256i open = _mm256_set1_epi8('{');
+                const __m256i close = _mm256_set1_epi8('}');
+                std::size_t i = 0;
+                for (; i + 32 <= size; i += 32)
+                {
+                    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                    const __m256i folded = _mm256_or_si256(chunk, lower);
+                    const __m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)));
+                    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+                    if (mask != 0)
+                    {
+                        return i + static_cast<std::size_t>(std::countr_zero(mask));
+                    }
+                }
+                return i + find_structural_sse2(data + i, size - i);
+            }
+
+            /** @brief The state of the AVX2 UTF-8 validation.
+             *
+             * This is the lookup algorithm from "Validating UTF-8 In Less Than One Instruction Per Byte"
+             * by John Keiser and Daniel Lemire. Each byte is classified by three table lookups on the
+             * nibbles of itself and the previous byte, and the errors of all the blocks are accumulated.
+             *
+             */
+            struct utf8_checker_avx2
+            {
+                __m256i error;
+                __m256i previous;
+                __m256i previous_incomplete;
+
+                static constexpr std::uint8_t too_short = 1 << 0;
+                static constexpr std::uint8_t too_long = 1 << 1;
+                static constexpr std::uint8_t overlong_3 = 1 << 2;
+                static constexpr std::uint8_t too_large = 1 << 3;
+                static constexpr std::uint8_t surrogate = 1 << 4;
+                static constexpr std::uint8_t overlong_2 = 1 << 5;
+                static constexpr std::uint8_t too_large_1000 = 1 << 6;
+                static constexpr std::uint8_t overlong_4 = 1 << 6;
+                static constexpr std::uint8_t two_continuations = 1 << 7;
+                static constexpr std::uint8_t carry = too_short | too_long | two_continuations;
+
+                // indexed by the high nibble of the previous byte.
+                static constexpr std::uint8_t byte_1_high[16] = {
+                    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                    two_continuations, two_continuations, two_continuations, two_continuations,
+                    too_short | overlong_2,
+                    too_short,
+                    too_short | overlong_3 | surrogate,
+                    too_short | too_large | too_large_1000 | overlong_4};
+
+                // indexed by the low nibble of the previous byte.
+                static constexpr std::uint8_t byte_1_low[16] = {
+                    carry | overlong_3 | overlong_2 | overlong_4,
+                    carry | overlong_2,
+                    carry,
+                    carry,
+                    carry | too_large,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000 | surrogate,
+                    carry | too_large | too_large_1000,
+                    carry | too_large | too_large_1000};
+
+                // indexed by the high nibble of the current byte.
+                static constexpr std::uint8_t byte_2_high[16] = {
+                    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                    too_long | overlong_2 | two_continuations | overlong_3 | too_large_1000 | overlong_4,
+                    too_long | overlong_2 | two_continuations | overlong_3 | too_large,
+                    too_long | overlong_2 | two_continuations | surrogate | too_large,
+                    too_long | overlong_2 | two_continuations | surrogate | too_large,
+                    too_short, too_short, too_short, too_short};
+
+                // a block is incomplete if one of its last three bytes starts a sequence longer than what's left.
+                static constexpr std::uint8_t incomplete_limit[32] = {
+                    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+                KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 static __m256i table(const std::uint8_t (&values)[16]) noexcept
+                {
+                    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values)));
+                }
+
+                KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 static __m256i high_nibble(__m256i input) noexcept
+                {
+                    return _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+                }
+
+                KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 void check(__m256i input) noexcept
+                {
+                    if (_mm256_movemask_epi8(input) == 0)
+                    {
+                        // an ASCII block is only wrong if the previous block ends in the middle of a sequence.
+                        error = _mm256_or_si256(error, previous_incomplete);
+                        previous = input;
+                        previous_incomplete = _mm256_setzero_si256();
+                        return;
+                    }
+
+                    // the input shifted right by one to three bytes, with the last bytes of the previous block shifted in.
+                    const __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+                    const __m256i previous_1 = _mm256_alignr_epi8(input, shifted, 15);
+                    const __m256i previous_2 = _mm256_alignr_epi8(input, shifted, 14);
+                    const __m256i previous_3 = _mm256_alignr_epi8(input, shifted, 13);
+
+                    const __m256i special = _mm256_and_si256(
+                        _mm256_and_si256(_mm256_shuffle_epi8(table(byte_1_high), high_nibble(previous_1)),
+                                         _mm256_shuffle_epi8(table(byte_1_low), _mm256_and_si256(previous_1, _mm256_set1_epi8(0x0F)))),
+                        _mm256_shuffle_epi8(table(byte_2_high), high_nibble(input)));
+
+                    // the bytes two or three after a three or four byte leading byte must be continuations.
+                    const __m256i must_be_continuation = _mm256_and_si256(
+                        _mm256_or_si256(_mm256_subs_epu8(previous_2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                                        _mm256_subs_epu8(previous_3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)))),
+                        _mm256_set1_epi8(static_cast<char>(0x80)));
+
+                    error = _mm256_or_si256(error, _mm256_xor_si256(must_be_continuation, special));
+                    previous = input;
+                    previous_incomplete = _mm256_subs_epu8(input, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(incomplete_limit)));
+                }
+            };
+
+            KIE_TOOLBOX_SERDE_JSON_TARGET_AVX2 inline bool validate_utf8_avx2(const char *data, std::size_t size) noexcept
+            {
+                utf8_checker_avx2 checker{_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+                std::size_t i = 0;
+                for (; i + 32 <= size; i += 32)
+                {
+                    checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+                }
+                if (i < size)
+                {
+                    // the tail is padded with ASCII, so a truncated sequence shows up as too short.
+                    char tail[32] = {};
+                    std::memcpy(tail, data + i, size - i);
+                    checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail)));
+                }
+                const __m256i error = _mm256_or_si256(checker.error, checker.previous_incomplete);
+                return _mm256_testz_si256(error, error) != 0;
+            }
+#endif
+
+            /** @brief The widest level supported by both the build and the running CPU.
+             *
+             */
+            inline level supported_level() noexcept
+            {
+#ifdef KIE_TOOLBOX_SERDE_JSON_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+                int info[4];
+                __cpuid(info, 1);
+                // the OS must save the AVX registers, which is what OSXSAVE and XCR0 tell.
+                const bool os_saves_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+                __cpuidex(info, 7, 0);
+                if (os_saves_avx && (info[1] & (1 << 5)) != 0)
+                {
+                    return level::avx2;
+                }
+#else
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2"))
+                {
+                    return level::avx2;
+                }
+#endif
+                return level::sse2;
+#else
+                return level::scalar;
+#endif
+            }
+
+            /** @brief Get the kernels of a level, or of the widest supported level below it.
+             *
+             */
+            inline const kernels &kernels_of(level l) noexcept
+            {
+                static constexpr kernels scalar{level::scalar, &find_escape_scalar, &validate_utf8_scalar, &find_structural_scalar};
+#ifdef KIE_TOOLBOX_SERDE_JSON_SIMD_X86
+                static constexpr kernels sse2{level::sse2, &find_escape_sse2, &validate_utf8_sse2, &find_structural_sse2};
+                static constexpr kernels avx2{level::avx2, &find_escape_avx2, &validate_utf8_avx2, &find_structural_avx2};
+                if (l > supported_level())
+                {
+                    l = supported_level();
+                }
+                switch (l)
+                {
+                case level::avx2:
+                    return avx2;
+                case level::sse2:
+                    return sse2;
+                default:
+                    return scalar;
+                }
+#else
+                (void)l;
+                return scalar;
+#endif
+            }
+
+            /** @brief The kernels picked for the running CPU, which is detected only once.
+             *
+             */
+            inline const kernels &active() noexcept
+            {
+                static const kernels &picked = kernels_of(supported_level());
+                return picked;
+            }
+        }
+    }
+
+} // namespace kie::serde_json
+
+#endif
@@ -0,0 +1,609 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_STREAM_HPP
+#define KIE_TOOLBOX_SERDE_JSON_STREAM_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+
+#include "reader.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief Where the streaming readers get their bytes from.
+     *
+     */
+    class input_source
+    {
+    public:
+        virtual ~input_source() = default;
+
+        /** @brief Read at most size bytes into buffer.
+         *
+         * @return How many bytes are read. 0 means the end of input.
+         */
+        virtual std::size_t read(char *buffer, std::size_t size) = 0;
+    };
+
+    /** @brief Read from a `std::istream`. The stream should live longer than this.
+     *
+     */
+    class istream_source : public input_source
+    {
+        std::istream &in;
+
+    public:
+        explicit istream_source(std::istream &in) : in(in) {}
+
+        std::size_t read(char *buffer, std::size_t size) override
+        {
+            in.read(buffer, static_cast<std::streamsize>(size));
+            return static_cast<std::size_t>(in.gcount());
+        }
+    };
+
+#if __has_include(<unistd.h>)
+    /** @brief Read from a file descriptor. The file descriptor is not closed by this.
+     *
+     */
+    class fd_source : public input_source
+    {
+        int fd;
+
+    public:
+        explicit fd_source(int fd) : fd(fd) {}
+
+        std::size_t read(char *buffer, std::size_t size) override
+        {
+            while (true)
+            {
+                const auto n = ::read(fd, buffer, size);
+                if (n >= 0)
+                {
+                    return static_cast<std::size_t>(n);
+                }
+                if (errno != EINTR)
+                {
+                    throw std::system_error(errno, std::generic_category(), "read");
+                }
+            }
+        }
+    };
+#endif
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief The layout of the records in a stream.
+         *
+         */
+        enum class record_format
+        {
+            /// One json array, each item is a record.
+            array,
+            /// One json value per line.
+            ndjson,
+        };
+
+        /** @brief Cut a stream into records without parsing them.
+         *
+         * Only the bytes of the current record and the unread part of the last chunk are kept in
+         * memory. The record boundary is found by matching brackets and quotes, the record itself is
+         * validated later when it's read.
+         *
+         * When the input is a memory region, the records point into it directly and nothing is copied.
+         *
+         */
+        class record_splitter
+        {
+            std::unique_ptr<input_source> source;
+            record_format format;
+            std::string storage;
+            std::size_t chunk_size;
+
+            const char *data = nullptr;
+            std::size_t size = 0;
+            std::size_t pos = 0;
+            // the offset of data[0] in the whole input.
+            std::size_t offset = 0;
+
+            bool started = false;
+            bool finished = false;
+
+        public:
+            read_error error;
+
+            /** @brief Whether the input is a single value that is not an array.
+             *
+             * Then `next` returns that value once, to be validated but not read, and there is no item.
+             */
+            bool not_array = false;
+
+            record_splitter(std::unique_ptr<input_source> source, record_format format, std::size_t chunk_size)
+                : source(std::move(source)), format(format), chunk_size(chunk_size == 0 ? 1 : chunk_size)
+            {
+            }
+
+            record_splitter(std::string_view region, record_format format)
+                : format(format), chunk_size(0), data(region.data()), size(region.size())
+            {
+            }
+
+            /** @brief The offset of the record last returned by `next` in the whole input.
+             *
+             */
+            std::size_t record_offset = 0;
+
+            /** @brief Get next record.
+             *
+             * @param record Set to the next record. It's valid until next call.
+             *
+             * @return false when there is no more record or it fails. Check `error` to tell them apart.
+             */
+            bool next(std::string_view &record)
+            {
+                if (finished)
+                {
+                    return false;
+                }
+                return format == record_format::array ? next_item(record) : next_line(record);
+            }
+
+        private:
+            bool fail(read_errc code)
+            {
+                finished = true;
+                error.code = code;
+                error.position = offset + pos;
+                return false;
+            }
+
+            /** @brief Read more bytes from source, and drop all the bytes before keep.
+             *
+             * After it returns, the byte that was at keep is at 0.
+             *
+             * @return false if there is nothing more to read.
+             */
+            bool fill(std::size_t keep)
+            {
+                if (source == nullptr)
+                {
+                    return false;
+                }
+                if (keep > 0)
+                {
+                    std::memmove(storage.data(), storage.data() + keep, size - keep);
+                    size -= keep;
+                    pos -= keep;
+                    offset += keep;
+                }
+                if (storage.size() < size + chunk_size)
+                {
+                    // grow geometrically so a big record is not copied again and again.
+                    storage.resize(std::max(size + chunk_size, storage.size() * 2));
+                }
+                const std::size_t n = source->read(storage.data() + size, storage.size() - size);
+                data = storage.data();
+                size += n;
+                return n > 0;
+            }
+
+            static bool is_whitespace(char c)
+            {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+            }
+
+            /** @brief Skip whitespace, and return false if the input ends.
+             *
+             */
+            bool skip_whitespace()
+            {
+                while (true)
+                {
+                    while (pos < size && is_whitespace(data[pos]))
+                    {
+                        pos++;
+                    }
+                    if (pos < size)
+                    {
+                        return true;
+                    }
+                    if (!fill(pos))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            bool next_item(std::string_view &record)
+            {
+                if (!started)
+                {
+                    started = true;
+                    if (!skip_whitespace())
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    if (data[pos] != '[')
+                    {
+                        // it has no item, just like from_json returns empty container, but it's still validated.
+                        not_array = true;
+                        return scan_value(record);
+                    }
+                    pos++;
+                    if (!skip_whitespace())
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    if (data[pos] == ']')
+                    {
+                        pos++;
+                        return finish();
+                    }
+                }
+                else if (not_array)
+                {
+                    return finish();
+                }
+                else
+                {
+                    if (!skip_whitespace())
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                    if (data[pos] == ']')
+                    {
+                        pos++;
+                        return finish();
+                    }
+                    if (data[pos] != ',')
+                    {
+                        return fail(read_errc::syntax_error);
+                    }
+                    pos++;
+                    if (!skip_whitespace())
+                    {
+                        return fail(read_errc::unexpected_end);
+                    }
+                }
+                return scan_value(record);
+            }
+
+            /** @brief Find the end of the value at current position by matching brackets and quotes.
+             *
+             */
+            bool scan_value(std::string_view &record)
+            {
+                std::size_t start = pos;
+                std::size_t depth = 0;
+                bool in_string = false;
+                bool escaped = false;
+                while (true)
+                {
+                    for (; pos < size; pos++)
+                    {
+                        const char c = data[pos];
+                        if (in_string)
+                        {
+                            if (escaped)
+                            {
+                                escaped = false;
+                            }
+                            else if (c == '\\')
+                            {
+                                escaped = true;
+                            }
+                            else if (c == '"')
+                            {
+                                in_string = false;
+                                if (depth == 0)
+                                {
+                                    pos++;
+                                    return take(start, record);
+                                }
+                            }
+                        }
+                        else if (c == '"')
+                        {
+                            in_string = true;
+                        }
+                        else if (c == '{' || c == '[')
+                        {
+                            depth++;
+                        }
+                        else if (c == '}' || c == ']')
+                        {
+                            if (depth == 0)
+                            {
+                                return take(start, record);
+                            }
+                            if (--depth == 0)
+                            {
+                                pos++;
+                                return take(start, record);
+                            }
+                        }
+                        else if (depth == 0 && (c == ',' || is_whitespace(c)))
+                        {
+                            return take(start, record);
+                        }
+                    }
+                    const std::size_t before = offset;
+                    const bool more = fill(start);
+                    start -= offset - before;
+                    if (!more)
+                    {
+                        if (depth == 0 && !in_string)
+                        {
+                            // a scalar at the very end, the missing bracket is reported next time.
+                            return take(start, record);
+                        }
+                        return fail(read_errc::unexpected_end);
+                    }
+                }
+            }
+
+            bool next_line(std::string_view &record)
+            {
+                std::size_t scanned = pos;
+                while (true)
+                {
+                    const void *newline = scanned < size ? std::memchr(data + scanned, '\n', size - scanned) : nullptr;
+                    if (newline == nullptr && !finished)
+                    {
+                        // only a part of the line is there, keep it and read more.
+                        const std::size_t partial = size - pos;
+                        if (fill(pos))
+                        {
+                            scanned = pos + partial;
+                            continue;
+                        }
+                        finished = true;
+                    }
+
+                    std::size_t start = pos;
+                    std::size_t end = newline == nullptr ? size : static_cast<std::size_t>(static_cast<const char *>(newline) - data);
+                    pos = newline == nullptr ? end : end + 1;
+                    while (start < end && is_whitespace(data[start]))
+                    {
+                        start++;
+                    }
+                    while (end > start && is_whitespace(data[end - 1]))
+                    {
+                        end--;
+                    }
+                    if (start < end)
+                    {
+                        record_offset = offset + start;
+                        record = std::string_view{data + start, end - start};
+                        return true;
+                    }
+                    if (newline == nullptr)
+                    {
+                        return false;
+                    }
+                    scanned = pos;
+                }
+            }
+
+            bool take(std::size_t start, std::string_view &record)
+            {
+                record_offset = offset + start;
+                record = std::string_view{data + start, pos - start};
+                return true;
+            }
+
+            /** @brief The array is closed, only whitespace may follow.
+             *
+             */
+            bool finish()
+            {
+                if (skip_whitespace())
+                {
+                    return fail(read_errc::syntax_error);
+                }
+                finished = true;
+                return false;
+            }
+        };
+
+        /** @brief An input range that reads one record of type T at a time.
+         *
+         */
+        template <typename T, record_format format>
+        class record_reader
+        {
+            record_splitter splitter;
+            T current{};
+
+            bool read_next()
+            {
+                std::string_view record;
+                while (splitter.next(record))
+                {
+                    reader r{record};
+                    // the value that is not an array is only validated, so it's reported the same as from_json.
+                    if (splitter.not_array ? !r.skip_value() || !r.finish() : !read_value(r, current) || !r.finish())
+                    {
+                        r.prefer_syntax_error();
+                        r.error.position += splitter.record_offset;
+                        throw_read_error(r.error);
+                    }
+                    if (!splitter.not_array)
+                    {
+                        return true;
+                    }
+                }
+                if (splitter.error)
+                {
+                    throw_read_error(splitter.error);
+                }
+                return false;
+            }
+
+        public:
+            /** @brief Read from a `std::istream`, which should live longer than this.
+             *
+             * @param in The input stream.
+             * @param chunk_size How many bytes are read from the stream at a time.
+             */
+            explicit record_reader(std::istream &in, std::size_t chunk_size = 64 * 1024)
+                : splitter(std::make_unique<istream_source>(in), format, chunk_size)
+            {
+            }
+
+#if __has_include(<unistd.h>)
+            /** @brief Read from a file descriptor, which is not closed by this.
+             *
+             * @param fd The file descriptor.
+             * @param chunk_size How many bytes are read from the file descriptor at a time.
+             */
+            explicit record_reader(int fd, std::size_t chunk_size = 64 * 1024)
+                : splitter(std::make_unique<fd_source>(fd), format, chunk_size)
+            {
+            }
+#endif
+
+            /** @brief Read from any source.
+             *
+             * @param source The source.
+             * @param chunk_size How many bytes are read from the source at a time.
+             */
+            explicit record_reader(std::unique_ptr<input_source> source, std::size_t chunk_size = 64 * 1024)
+                : splitter(std::move(source), format, chunk_size)
+            {
+            }
+
+            /** @brief Read from a memory region, like a mmap'd file. Nothing is copied.
+             *
+             * @param region The memory region, which should live longer than this.
+             */
+            explicit record_reader(std::string_view region)
+                : splitter(region, format)
+            {
+            }
+
+            record_reader(const record_reader &) = delete;
+            record_reader &operator=(const record_reader &) = delete;
+
+            class iterator
+            {
+                record_reader *owner = nullptr;
+
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = T;
+                using reference = T &;
+                using pointer = T *;
+
+                iterator() = default;
+
+                explicit iterator(record_reader *owner) : owner(owner)
+                {
+                    ++*this;
+                }
+
+                T &operator*() const
+                {
+                    return owner->current;
+                }
+
+                T *operator->() const
+                {
+                    return &owner->current;
+                }
+
+                iterator &operator++()
+                {
+                    if (!owner->read_next())
+                    {
+                        owner = nullptr;
+                    }
+                    return *this;
+                }
+
+                void operator++(int)
+                {
+                    ++*this;
+                }
+
+                bool operator==(std::default_sentinel_t) const
+                {
+                    return owner == nullptr;
+                }
+            };
+
+            /** @brief Read the first record. It should be called only once.
+             *
+             */
+            iterator begin()
+            {
+                return iterator{this};
+            }
+
+            std::default_sentinel_t end() const
+            {
+                return {};
+            }
+        };
+    }
+
+    /** @brief Read the items of a huge json array one by one.
+     *
+     * Only one item is kept in memory at a time, so the memory used is proportional to the
+     * biggest item instead of the whole input. The item is reused, move it out if it's needed
+     * after the next one is read.
+     *
+     * Usage:
+     * @code
+     * std::ifstream in{"export.json"};
+     * for (auto &item : kie::serde_json::json_array_reader<A>{in})
+     * {
+     *     // ...
+     * }
+     * @endcode
+     *
+     * If the input is a valid json value that is not an array, there is no item at all, but the value
+     * is kept in memory as a whole to be validated. An empty or malformed input throws the same
+     * `nlohmann::json::parse_error` as `from_json` does.
+     *
+     * @param T The type of item.
+     */
+    template <typename T>
+    using json_array_reader = impl::record_reader<T, impl::record_format::array>;
+
+    /** @brief Read newline delimited json (NDJSON) one line at a time.
+     *
+     * Just like `json_array_reader`, but each non-blank line is a record.
+     *
+     * @param T The type of record.
+     */
+    template <typename T>
+    using ndjson_reader = impl::record_reader<T, impl::record_format::ndjson>;
+
+} // namespace kie::serde_json
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_TYPE_TRAIT_HPP
+#define KIE_TOOLBOX_SERDE_JSON_TYPE_TRAIT_HPP
+
+
+#include "../serde/type_trait.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief This namespace contains some trait used by this library at compile time.
+     *
+     * It help robust this library with some compile time check with concept.
+     * At the same time, it make some overload decision posible or simpler thanks to concept.
+     *
+     */
+    namespace type_trait
+    {
+        // The traits are shared by all the formats, and are kept here for the existing users.
+        using kie::serde::type_trait::not_implemented;
+        using kie::serde::type_trait::is_specialization_of;
+        using kie::serde::type_trait::is_array_class;
+        using kie::serde::type_trait::is_container;
+        using kie::serde::type_trait::is_dynamic_container;
+        using kie::serde::type_trait::is_string;
+        using kie::serde::type_trait::is_string_view;
+        using kie::serde::type_trait::is_output_buffer;
+    }
+
+} // namespace kie::serde_json
+
+#endif
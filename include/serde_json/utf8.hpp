@@ -0,0 +1,129 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_UTF8_HPP
+#define KIE_TOOLBOX_SERDE_JSON_UTF8_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief Check the UTF-8 sequence starting at `pos` and return its length.
+         *
+         * Overlong forms, surrogates and code points beyond U+10FFFF are rejected, just like
+         * nlohmann_json does. It never throws, the caller decides how to report the error.
+         *
+         * @param data The whole string.
+         * @param size The size of the whole string.
+         * @param pos The position of the leading byte, which must be a non-ASCII byte.
+         * @param bad Set to the index of the offending byte when it fails, or `size` if the string ends in the middle of a sequence.
+         *
+         * @return The length of the sequence, or 0 if it's invalid.
+         */
+        inline std::size_t utf8_sequence_length(const unsigned char *data, std::size_t size, std::size_t pos, std::size_t &bad) noexcept
+        {
+            const unsigned char lead = data[pos];
+            if (lead < 0xC2 || lead > 0xF4)
+            {
+                bad = pos;
+                return 0;
+            }
+
+            const std::size_t length = lead < 0xE0 ? 2 : (lead < 0xF0 ? 3 : 4);
+            // the second byte has a narrower range for some leading bytes to reject overlong and surrogate.
+            unsigned char lower = lead == 0xE0 ? 0xA0 : (lead == 0xF0 ? 0x90 : 0x80);
+            unsigned char upper = lead == 0xED ? 0x9F : (lead == 0xF4 ? 0x8F : 0xBF);
+            for (std::size_t i = 1; i < length; i++)
+            {
+                if (pos + i >= size)
+                {
+                    bad = size;
+                    return 0;
+                }
+                const unsigned char byte = data[pos + i];
+                if (byte < lower || byte > upper)
+                {
+                    bad = pos + i;
+                    return 0;
+                }
+                lower = 0x80;
+                upper = 0xBF;
+            }
+            return length;
+        }
+
+        /** @brief Check the whole string byte by byte, and find the first invalid byte.
+         *
+         * This is the slow path of UTF-8 validation, and is used to locate the error after a fast
+         * check fails.
+         *
+         * @param bad Set to the index of the offending byte when it fails, or `size` if the string ends in the middle of a sequence.
+         *
+         * @return true if the string is valid UTF-8.
+         */
+        inline bool utf8_validate(const unsigned char *data, std::size_t size, std::size_t &bad) noexcept
+        {
+            for (std::size_t i = 0; i < size;)
+            {
+                if (data[i] < 0x80)
+                {
+                    i++;
+                    continue;
+                }
+                const std::size_t length = utf8_sequence_length(data, size, i, bad);
+                if (length == 0)
+                {
+                    return false;
+                }
+                i += length;
+            }
+            return true;
+        }
+
+        /** @brief Encode a code point as UTF-8 and return how many bytes are written.
+         *
+         * @param code_point A valid code point, which is not a surrogate.
+         * @param out At least four bytes.
+         */
+        inline std::size_t utf8_encode(std::uint32_t code_point, char *out) noexcept
+        {
+            if (code_point < 0x80)
+            {
+                out[0] = static_cast<char>(code_point);
+                return 1;
+            }
+            if (code_point < 0x800)
+            {
+                out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+                out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+                return 2;
+            }
+            if (code_point < 0x10000)
+            {
+                out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+                out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+                return 3;
+            }
+            out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+            out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 4;
+        }
+    }
+
+} // namespace kie::serde_json
+
+#endif
@@ -0,0 +1,561 @@
+#ifndef KIE_TOOLBOX_SERDE_JSON_WRITER_HPP
+#define KIE_TOOLBOX_SERDE_JSON_WRITER_HPP
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+#include <boost/pfr.hpp>
+#include <nlohmann/json.hpp>
+
+
+#include "../serde/field.hpp"
+#include "../serde/lazy.hpp"
+#include "../serde/reflection.hpp"
+#include "grisu2.hpp"
+#include "simd.hpp"
+#include "type_trait.hpp"
+#include "utf8.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_json
+{
+
+    /** @brief How floating point numbers are written.
+     *
+     */
+    enum class number_format
+    {
+        /** @brief The same text as `nlohmann::json::dump`, e.g. `1.0` and `0.10000000149011612` for `0.1f`.
+         *
+         */
+        compatible,
+        /** @brief The shortest text that reads back to the same value, from `std::to_chars`.
+         *
+         * float is written as float, so `0.1f` is `0.1`, and a whole number has no fraction, e.g. `1`.
+         * It's faster and shorter, but not byte-identical to `nlohmann::json::dump`.
+         */
+        shortest,
+    };
+
+    /** @brief Options of the direct writer.
+     *
+     */
+    struct write_options
+    {
+        number_format numbers = number_format::compatible;
+        /// Write an empty container as `[]` instead of `null`. Both are read back as an empty container.
+        bool empty_as_array = false;
+    };
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        /** @brief Format one byte as two upper case hex digits, the same as nlohmann_json does in its error message.
+         *
+         */
+        inline std::string hex_byte(unsigned char byte)
+        {
+            constexpr const char *digits = "0123456789ABCDEF";
+            return {digits[byte >> 4], digits[byte & 0x0F]};
+        }
+
+        /** @brief Throw the same `nlohmann::json::type_error` as `nlohmann::json::dump` does for invalid UTF-8.
+         *
+         */
+        [[noreturn]] inline void throw_invalid_utf8(const unsigned char *data, std::size_t size, std::size_t bad)
+        {
+            if (bad == size)
+            {
+                throw nlohmann::json::type_error::create(316, "incomplete UTF-8 string; last byte: 0x" + hex_byte(data[size - 1]), nullptr);
+            }
+            throw nlohmann::json::type_error::create(316, "invalid UTF-8 byte at index " + std::to_string(bad) + ": 0x" + hex_byte(data[bad]), nullptr);
+        }
+
+        /** @brief Write a string as a quoted and escaped json string.
+         *
+         * The string is validated as UTF-8 first, then the characters that need no escaping are
+         * found and appended in runs. Both are done by the SIMD kernels picked for the running CPU.
+         *
+         */
+        template <type_trait::is_output_buffer B>
+        void write_string(std::string_view str, B &out)
+        {
+            const auto &kernels = simd::active();
+            const char *data = str.data();
+            const std::size_t size = str.size();
+            if (!kernels.validate_utf8(data, size))
+            {
+                std::size_t bad = 0;
+                utf8_validate(reinterpret_cast<const unsigned char *>(data), size, bad);
+                throw_invalid_utf8(reinterpret_cast<const unsigned char *>(data), size, bad);
+            }
+
+            out.push_back('"');
+            std::size_t run = 0;
+            while (true)
+            {
+                const std::size_t i = run + kernels.find_escape(data + run, size - run);
+                out.append(data + run, i - run);
+                if (i == size)
+                {
+                    break;
+                }
+
+                const auto c = static_cast<unsigned char>(data[i]);
+                switch (c)
+                {
+                case '"':
+                    out.append("\\\"", 2);
+                    break;
+                case '\\':
+                    out.append("\\\\", 2);
+                    break;
+                case '\b':
+                    out.append("\\b", 2);
+                    break;
+                case '\f':
+                    out.append("\\f", 2);
+                    break;
+                case '\n':
+                    out.append("\\n", 2);
+                    break;
+                case '\r':
+                    out.append("\\r", 2);
+                    break;
+                case '\t':
+                    out.append("\\t", 2);
+                    break;
+                default:
+                {
+                    constexpr const char *digits = "0123456789abcdef";
+                    const char escaped[6] = {'\\', 'u', '0', '0', digits[c >> 4], digits[c & 0x0F]};
+                    out.append(escaped, 6);
+                    break;
+                }
+                }
+                run = i + 1;
+            }
+            out.push_back('"');
+        }
+
+        /** @brief Write an integer.
+         *
+         */
+        template <typename T, type_trait::is_output_buffer B>
+        void write_integer(T value, B &out)
+        {
+            char buffer[24];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, static_cast<std::size_t>(end - buffer));
+        }
+
+        /** @brief Write a floating point number.
+         *
+         * nlohmann_json stores all the floating point numbers as double, and dumps them with its own
+         * Grisu2 `to_chars`. A copy of it is used here so the output is exactly the same, unless the
+         * shortest format is asked for.
+         *
+         */
+        template <std::floating_point T, type_trait::is_output_buffer B>
+        void write_float(T value, B &out, const write_options &options)
+        {
+            if (!std::isfinite(value))
+            {
+                out.append("null", 4);
+                return;
+            }
+            char buffer[64];
+            char *end = nullptr;
+            if (options.numbers == number_format::shortest)
+            {
+                if (value == 0 && std::signbit(value))
+                {
+                    // "-0" would be read back as the integer 0, which drops the sign.
+                    out.append("-0.0", 4);
+                    return;
+                }
+                end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+            }
+            else
+            {
+                end = grisu2::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(value));
+            }
+            out.append(buffer, static_cast<std::size_t>(end - buffer));
+        }
+
+        template <typename T, type_trait::is_output_buffer B>
+        void write_value(const T &t, B &out, const write_options &options);
+
+        /** @brief Write a container as json array.
+         *
+         * Empty container is written as `null`, which is what an empty `nlohmann::json` is, unless
+         * `empty_as_array` is set.
+         *
+         */
+        template <type_trait::is_container T, type_trait::is_output_buffer B>
+        void write_container(const T &t, B &out, const write_options &options)
+        {
+            if (std::begin(t) == std::end(t))
+            {
+                if (options.empty_as_array)
+                {
+                    out.append("[]", 2);
+                }
+                else
+                {
+                    out.append("null", 4);
+                }
+                return;
+            }
+            char separator = '[';
+            for (const auto &item : t)
+            {
+                out.push_back(separator);
+                separator = ',';
+                write_value(item, out, options);
+            }
+            out.push_back(']');
+        }
+
+        /** @brief The count of chars that a tag takes once it's quoted and escaped as `write_string` does.
+         *
+         */
+        constexpr std::size_t escaped_key_size(std::string_view tag)
+        {
+            std::size_t size = 2;
+            for (char c : tag)
+            {
+                const auto byte = static_cast<unsigned char>(c);
+                if (byte == '"' || byte == '\\' || byte == '\b' || byte == '\f' || byte == '\n' || byte == '\r' || byte == '\t')
+                {
+                    size += 2;
+                }
+                else if (byte < 0x20)
+                {
+                    size += 6;
+                }
+                else
+                {
+                    size += 1;
+                }
+            }
+            return size;
+        }
+
+        /** @brief Quote and escape a tag as `write_string` does, and return the end of what is written.
+         *
+         */
+        constexpr char *escape_key(std::string_view tag, char *out)
+        {
+            constexpr const char *digits = "0123456789abcdef";
+            *out++ = '"';
+            for (char c : tag)
+            {
+                const auto byte = static_cast<unsigned char>(c);
+                const char short_escape = byte == '"'    ? '"'
+                                          : byte == '\\' ? '\\'
+                                          : byte == '\b'  ? 'b'
+                                          : byte == '\f'  ? 'f'
+                                          : byte == '\n'  ? 'n'
+                                          : byte == '\r'  ? 'r'
+                                          : byte == '\t'  ? 't'
+                                                          : '\0';
+                if (short_escape != '\0')
+                {
+                    *out++ = '\\';
+                    *out++ = short_escape;
+                }
+                else if (byte < 0x20)
+                {
+                    for (char e : {'\\', 'u', '0', '0', digits[byte >> 4], digits[byte & 0x0F]})
+                    {
+                        *out++ = e;
+                    }
+                }
+                else
+                {
+                    *out++ = c;
+                }
+            }
+            *out++ = '"';
+            return out;
+        }
+
+        /** @brief The text of an aggregate type that doesn't depend on the values, built at compile time.
+         *
+         * It's the fragments before the values of the Fields: `{"a":` before the first one, and `,"b":`
+         * before each of the others. The object is then written by copying the
+         * fragments and formatting the values, and no tag is escaped or looked at at runtime.
+         *
+         * The tags that are not ASCII are still written by `write_string`, so that they're checked as
+         * UTF-8 as before. `prebuilt` is false then.
+         */
+        template <typename T>
+        struct object_plan
+        {
+            using fields = kie::serde::reflection::fields<T>;
+
+            static constexpr bool prebuilt = []
+            {
+                for (std::string_view tag : fields::tags)
+                {
+                    for (char c : tag)
+                    {
+                        if (static_cast<unsigned char>(c) >= 0x80)
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }();
+
+            /// The start of each fragment, with the size of the text at the end.
+            static constexpr std::array<std::size_t, fields::size + 1> offsets = []
+            {
+                std::array<std::size_t, fields::size + 1> result{};
+                for (std::size_t k = 0; k < fields::size; k++)
+                {
+                    result[k + 1] = result[k] + 1 + escaped_key_size(fields::tags[k]) + 1;
+                }
+                return result;
+            }();
+
+            static constexpr std::array<char, offsets[fields::size]> text = []
+            {
+                std::array<char, offsets[fields::size]> result{};
+                char *out = result.data();
+                for (std::size_t k = 0; k < fields::size; k++)
+                {
+                    *out++ = k == 0 ? '{' : ',';
+                    out = escape_key(fields::tags[k], out);
+                    *out++ = ':';
+                }
+                return result;
+            }();
+
+            /** @brief The fragment before the value of the Kth Field.
+             *
+             */
+            template <std::size_t K>
+            static constexpr std::string_view fragment = {text.data() + offsets[K], offsets[K + 1] - offsets[K]};
+        };
+
+        /** @brief Write the separator and the key of the Kth Field of T, which are followed by its value.
+         *
+         * @param separator `{` for the first Field and `,` for the others.
+         */
+        template <typename T, std::size_t K, type_trait::is_output_buffer B>
+        void write_key(char separator, B &out)
+        {
+            using plan = object_plan<T>;
+            if constexpr (plan::prebuilt)
+            {
+                constexpr std::string_view fragment = plan::template fragment<K>;
+                if (separator == fragment[0])
+                {
+                    out.append(fragment.data(), fragment.size());
+                }
+                else
+                {
+                    out.push_back(separator);
+                    out.append(fragment.data() + 1, fragment.size() - 1);
+                }
+            }
+            else
+            {
+                out.push_back(separator);
+                write_string(plan::fields::tags[K], out);
+                out.push_back(':');
+            }
+        }
+
+        /** @brief Write an aggregate type as json object.
+         *
+         * The Fields are written in the order of their tags, and other members are ignored. If there
+         * is no Field at all, `null` is written. The keys come from the `object_plan` of T.
+         *
+         */
+        template <typename T, type_trait::is_output_buffer B>
+        void write_object(const T &t, B &out, const write_options &options)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            if constexpr (fields::size == 0)
+            {
+                out.append("null", 4);
+            }
+            else
+            {
+                [&]<std::size_t... K>(std::index_sequence<K...>)
+                {
+                    ((write_key<T, K>(K == 0 ? '{' : ',', out),
+                      write_value(boost::pfr::get<fields::index[K]>(t).value, out, options)),
+                     ...);
+                }(std::make_index_sequence<fields::size>{});
+                out.push_back('}');
+            }
+        }
+
+        /** @brief Write the value held by a Field, or an item of a container.
+         *
+         */
+        template <typename T, type_trait::is_output_buffer B>
+        void write_value(const T &t, B &out, const write_options &options)
+        {
+            if constexpr (type_trait::is_string<T> || type_trait::is_string_view<T>)
+            {
+                write_string(t, out);
+            }
+            else if constexpr (kie::serde::type_trait::is_lazy<T>::value)
+            {
+                if (t.has_raw())
+                {
+                    out.append(t.raw().data(), t.raw().size()); // the text that is read, as it is
+                }
+                else
+                {
+                    write_value(t.get(), out, options);
+                }
+            }
+            else if constexpr (type_trait::is_specialization_of<T, std::optional>::value)
+            {
+                if (t)
+                {
+                    write_value(*t, out, options);
+                }
+                else
+                {
+                    out.append("null", 4);
+                }
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                if (t)
+                {
+                    out.append("true", 4);
+                }
+                else
+                {
+                    out.append("false", 5);
+                }
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                write_float(t, out, options);
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                write_integer(t, out);
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                write_integer(static_cast<std::underlying_type_t<T>>(t), out);
+            }
+            else if constexpr (type_trait::is_container<T>)
+            {
+                write_container(t, out, options);
+            }
+            else
+            {
+                write_object(t, out, options);
+            }
+        }
+    }
+
+    /** @brief Serialize T and append the json text to the buffer.
+     *
+     * It walks the Fields of T just like `to_json`, but writes straight into the buffer without
+     * building a `nlohmann::json` first. With the default options, the output is byte-identical to
+     * `to_json(t).dump()`.
+     *
+     * Usage:
+     * @code
+     * std::string buffer;
+     * kie::serde_json::write_json(a, buffer);
+     * @endcode
+     *
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @param out The buffer that the json text is appended to.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <typename T, type_trait::is_output_buffer B>
+    void write_json(const T &t, B &out, const write_options &options = {})
+    {
+        if constexpr (type_trait::is_container<T>)
+        {
+            impl::write_container(t, out, options);
+        }
+        else if constexpr (std::is_class_v<T> && !type_trait::is_string<T>)
+        {
+            impl::write_object(t, out, options);
+        }
+        else
+        {
+            out.append("null", 4); // return null for the type without wrapping with Field
+        }
+    }
+
+    /** @brief Serialize T to json string.
+     *
+     * This is the same with `to_json(t).dump()`, but much cheaper.
+     *
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <typename T>
+    std::string to_json_string(const T &t, const write_options &options = {})
+    {
+        std::string out;
+        write_json(t, out, options);
+        return out;
+    }
+
+    /** @brief Serialize T and append the json text to a buffer that is reused.
+     *
+     * It's `write_json` with the buffer first. Clear the buffer before each message instead of
+     * making a new one, and its capacity is reused, so a hot loop allocates nothing once the buffer
+     * is large enough.
+     *
+     * Usage:
+     * @code
+     * std::string buffer;
+     * for (const auto &response : responses)
+     * {
+     *     buffer.clear();
+     *     kie::serde_json::to_json_into(buffer, response);
+     *     send(buffer);
+     * }
+     * @endcode
+     *
+     * @param out The buffer that the json text is appended to.
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @param options Choose `number_format::shortest` for faster and shorter floating point numbers.
+     */
+    template <type_trait::is_output_buffer B, typename T>
+    void to_json_into(B &out, const T &t, const write_options &options = {})
+    {
+        write_json(t, out, options);
+    }
+
+} // namespace kie::serde_json
+
+#endif
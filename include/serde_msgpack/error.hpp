@@ -0,0 +1,98 @@
+#ifndef KIE_TOOLBOX_SERDE_MSGPACK_ERROR_HPP
+#define KIE_TOOLBOX_SERDE_MSGPACK_ERROR_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_msgpack
+{
+
+    /** @brief The reason why encoding or decoding MessagePack fails.
+     *
+     */
+    enum class errc
+    {
+        none,
+        unexpected_end,
+        invalid_marker,
+        type_mismatch,
+        number_out_of_range,
+        missing_field,
+        trailing_data,
+        too_long,
+    };
+
+    /** @brief Describe the error code in a few words.
+     *
+     */
+    inline std::string_view to_string(errc code)
+    {
+        switch (code)
+        {
+        case errc::none:
+            return "no error";
+        case errc::unexpected_end:
+            return "unexpected end of input";
+        case errc::invalid_marker:
+            return "invalid marker byte";
+        case errc::type_mismatch:
+            return "type mismatch";
+        case errc::number_out_of_range:
+            return "number out of range";
+        case errc::missing_field:
+            return "missing field";
+        case errc::trailing_data:
+            return "trailing data";
+        default:
+            return "string or container too long";
+        }
+    }
+
+    /** @brief The exception thrown when encoding or decoding MessagePack fails.
+     *
+     * Besides the message, it keeps the error code and the byte offset where it happens, so the
+     * caller doesn't have to parse the message.
+     *
+     */
+    class msgpack_error : public std::runtime_error
+    {
+        errc code_;
+        std::size_t position_;
+
+    public:
+        msgpack_error(errc code, std::size_t position, const std::string &detail = {})
+            : std::runtime_error("[serde_msgpack] " + std::string{to_string(code)} + (detail.empty() ? "" : " " + detail) + " at byte " + std::to_string(position)),
+              code_(code),
+              position_(position)
+        {
+        }
+
+        /** @brief The reason of the error.
+         *
+         */
+        [[nodiscard]] errc code() const noexcept
+        {
+            return code_;
+        }
+
+        /** @brief The byte offset in the input where the error happens, or the output size when encoding.
+         *
+         * If the output buffer has no `size()`, it's the number of bytes written by this serialization.
+         *
+         */
+        [[nodiscard]] std::size_t position() const noexcept
+        {
+            return position_;
+        }
+    };
+
+} // namespace kie::serde_msgpack
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef KIE_TOOLBOX_SERDE_MSGPACK_MSGPACK_HPP
+#define KIE_TOOLBOX_SERDE_MSGPACK_MSGPACK_HPP
+
+/** @brief MessagePack backend of serde.
+ *
+ * It serializes the same `kie::serde::Field` aggregates as serde_json, with the same reflection,
+ * but to the compact binary format of https://msgpack.org. Nothing but Boost.PFR is needed.
+ *
+ * Usage:
+ * @code
+ * std::string bytes = kie::serde_msgpack::to_msgpack(a);
+ * auto b = kie::serde_msgpack::from_msgpack<A>(bytes);
+ * @endcode
+ *
+ */
+
+#include "error.hpp"
+#include "writer.hpp"
+#include "reader.hpp"
+
+#endif
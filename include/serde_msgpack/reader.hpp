@@ -0,0 +1,842 @@
+#ifndef KIE_TOOLBOX_SERDE_MSGPACK_READER_HPP
+#define KIE_TOOLBOX_SERDE_MSGPACK_READER_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+#include <boost/pfr.hpp>
+
+
+#include "../serde/field.hpp"
+#include "../serde/lazy.hpp"
+#include "../serde/reflection.hpp"
+#include "../serde/type_trait.hpp"
+#include "error.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_msgpack
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        namespace type_trait = kie::serde::type_trait;
+
+        /** @brief How many bytes a container reserves at most from the size in its header.
+         *
+         * The size is only bounded by the input that is left, one byte per item, while each item may
+         * take much more in memory. So a few bytes of header can't make a large allocation, and the
+         * larger containers grow as their items are read.
+         */
+        inline constexpr std::size_t max_reserve_bytes = 1 << 16;
+
+        /** @brief The kinds of MessagePack value, grouped by what they can be read into.
+         *
+         */
+        enum class value_kind
+        {
+            nil,
+            boolean,
+            number,
+            string,
+            binary,
+            array,
+            map,
+            extension,
+        };
+
+        /** @brief A number read from the input, before it's converted to the target type.
+         *
+         */
+        struct number
+        {
+            enum class kind
+            {
+                integer,
+                unsigned_integer,
+                floating,
+            };
+
+            kind type = kind::integer;
+            std::int64_t integer = 0;
+            std::uint64_t unsigned_integer = 0;
+            double floating = 0;
+        };
+
+        /** @brief A MessagePack decoder that reads from a byte buffer.
+         *
+         * Just like the json reader, it never throws. It records the first error and returns false,
+         * and the caller throws at the API boundary.
+         *
+         */
+        class decoder
+        {
+            const unsigned char *begin;
+            const unsigned char *cur;
+            const unsigned char *end;
+
+        public:
+            errc error = errc::none;
+            std::size_t position = 0;
+            std::string_view missing_key;
+
+            explicit decoder(std::string_view input)
+                : begin(reinterpret_cast<const unsigned char *>(input.data())),
+                  cur(begin),
+                  end(begin + input.size())
+            {
+            }
+
+            /** @brief Get the current position, counted from the beginning of the input.
+             *
+             */
+            std::size_t offset() const
+            {
+                return static_cast<std::size_t>(cur - begin);
+            }
+
+            /** @brief Go back to a position got from `offset`, so the same value is read again.
+             *
+             */
+            void rewind(std::size_t offset)
+            {
+                cur = begin + offset;
+            }
+
+            /** @brief Record the error at current position.
+             *
+             * @return Always false, so it can be returned directly.
+             */
+            bool fail(errc code)
+            {
+                error = code;
+                position = static_cast<std::size_t>(cur - begin);
+                return false;
+            }
+
+            /** @brief Check that the whole input is consumed.
+             *
+             */
+            bool finish()
+            {
+                return cur == end || fail(errc::trailing_data);
+            }
+
+            /** @brief Peek the kind of the next value without consuming it.
+             *
+             */
+            bool next_kind(value_kind &kind)
+            {
+                if (cur == end)
+                {
+                    return fail(errc::unexpected_end);
+                }
+                const unsigned char marker = *cur;
+                if (marker <= 0x7F || marker >= 0xE0 || (marker >= 0xCA && marker <= 0xD3))
+                {
+                    kind = value_kind::number;
+                }
+                else if (marker <= 0x8F || marker == 0xDE || marker == 0xDF)
+                {
+                    kind = value_kind::map;
+                }
+                else if (marker <= 0x9F || marker == 0xDC || marker == 0xDD)
+                {
+                    kind = value_kind::array;
+                }
+                else if (marker <= 0xBF || (marker >= 0xD9 && marker <= 0xDB))
+                {
+                    kind = value_kind::string;
+                }
+                else if (marker == 0xC0)
+                {
+                    kind = value_kind::nil;
+                }
+                else if (marker == 0xC2 || marker == 0xC3)
+                {
+                    kind = value_kind::boolean;
+                }
+                else if (marker >= 0xC4 && marker <= 0xC6)
+                {
+                    kind = value_kind::binary;
+                }
+                else if ((marker >= 0xC7 && marker <= 0xC9) || (marker >= 0xD4 && marker <= 0xD8))
+                {
+                    kind = value_kind::extension;
+                }
+                else
+                {
+                    return fail(errc::invalid_marker); // 0xC1 is never used
+                }
+                return true;
+            }
+
+            /** @brief Read an unsigned value of U in big endian.
+             *
+             */
+            template <typename U>
+            bool read_big_endian(U &value)
+            {
+                if (static_cast<std::size_t>(end - cur) < sizeof(U))
+                {
+                    return fail(errc::unexpected_end);
+                }
+                value = 0;
+                for (std::size_t i = 0; i < sizeof(U); i++)
+                {
+                    value = static_cast<U>((value << 8) | cur[i]);
+                }
+                cur += sizeof(U);
+                return true;
+            }
+
+            bool read_nil()
+            {
+                cur++;
+                return true;
+            }
+
+            bool read_boolean(bool &value)
+            {
+                value = *cur++ == 0xC3;
+                return true;
+            }
+
+            bool read_number(number &value)
+            {
+                const unsigned char marker = *cur++;
+                if (marker <= 0x7F)
+                {
+                    value.type = number::kind::unsigned_integer;
+                    value.unsigned_integer = marker;
+                    return true;
+                }
+                if (marker >= 0xE0)
+                {
+                    value.type = number::kind::integer;
+                    value.integer = static_cast<std::int8_t>(marker);
+                    return true;
+                }
+                switch (marker)
+                {
+                case 0xCA:
+                {
+                    std::uint32_t bits = 0;
+                    if (!read_big_endian(bits))
+                    {
+                        return false;
+                    }
+                    value.type = number::kind::floating;
+                    value.floating = std::bit_cast<float>(bits);
+                    return true;
+                }
+                case 0xCB:
+                {
+                    std::uint64_t bits = 0;
+                    if (!read_big_endian(bits))
+                    {
+                        return false;
+                    }
+                    value.type = number::kind::floating;
+                    value.floating = std::bit_cast<double>(bits);
+                    return true;
+                }
+                case 0xCC:
+                    return read_unsigned<std::uint8_t>(value);
+                case 0xCD:
+                    return read_unsigned<std::uint16_t>(value);
+                case 0xCE:
+                    return read_unsigned<std::uint32_t>(value);
+                case 0xCF:
+                    return read_unsigned<std::uint64_t>(value);
+                case 0xD0:
+                    return read_signed<std::uint8_t, std::int8_t>(value);
+                case 0xD1:
+                    return read_signed<std::uint16_t, std::int16_t>(value);
+                case 0xD2:
+                    return read_signed<std::uint32_t, std::int32_t>(value);
+                default:
+                    return read_signed<std::uint64_t, std::int64_t>(value);
+                }
+            }
+
+            /** @brief Read a str as a view into the input.
+             *
+             */
+            bool read_string(std::string_view &value)
+            {
+                std::size_t size = 0;
+                if (!read_size(0xA0, 0x1F, 0xD9, size) || !has(size))
+                {
+                    return false;
+                }
+                value = std::string_view{reinterpret_cast<const char *>(cur), size};
+                cur += size;
+                return true;
+            }
+
+            /** @brief Read the header of an array and get the number of items.
+             *
+             */
+            bool read_array_header(std::size_t &size)
+            {
+                // every item takes at least one byte, so a larger size can't be right.
+                return read_size(0x90, 0x0F, 0, size) && (size <= static_cast<std::size_t>(end - cur) || fail(errc::unexpected_end));
+            }
+
+            /** @brief Read the header of a map and get the number of key-value pairs.
+             *
+             */
+            bool read_map_header(std::size_t &size)
+            {
+                return read_size(0x80, 0x0F, 0, size) && (size <= static_cast<std::size_t>(end - cur) / 2 || fail(errc::unexpected_end));
+            }
+
+            /** @brief Skip a value of any kind.
+             *
+             * It's iterative, so deeply nested input can't overflow the stack.
+             *
+             */
+            bool skip_value()
+            {
+                std::size_t pending = 1;
+                while (pending > 0)
+                {
+                    pending--;
+                    value_kind kind = value_kind::nil;
+                    if (!next_kind(kind))
+                    {
+                        return false;
+                    }
+                    std::size_t size = 0;
+                    switch (kind)
+                    {
+                    case value_kind::nil:
+                    case value_kind::boolean:
+                        cur++;
+                        break;
+                    case value_kind::number:
+                    {
+                        number n;
+                        if (!read_number(n))
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                    case value_kind::string:
+                    {
+                        std::string_view s;
+                        if (!read_string(s))
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                    case value_kind::array:
+                        if (!read_array_header(size))
+                        {
+                            return false;
+                        }
+                        pending += size;
+                        break;
+                    case value_kind::map:
+                        if (!read_map_header(size))
+                        {
+                            return false;
+                        }
+                        pending += size * 2;
+                        break;
+                    default:
+                        if (!skip_bytes())
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                }
+                return true;
+            }
+
+        private:
+            bool has(std::size_t size)
+            {
+                return size <= static_cast<std::size_t>(end - cur) || fail(errc::unexpected_end);
+            }
+
+            template <typename U>
+            bool read_unsigned(number &value)
+            {
+                U bits = 0;
+                if (!read_big_endian(bits))
+                {
+                    return false;
+                }
+                value.type = number::kind::unsigned_integer;
+                value.unsigned_integer = bits;
+                return true;
+            }
+
+            template <typename U, typename S>
+            bool read_signed(number &value)
+            {
+                U bits = 0;
+                if (!read_big_endian(bits))
+                {
+                    return false;
+                }
+                value.type = number::kind::integer;
+                value.integer = static_cast<S>(bits);
+                return true;
+            }
+
+            /** @brief Read the size of str, array or map.
+             *
+             * The 16-bit and 32-bit markers follow the 8-bit one, or the fix format if there is no
+             * 8-bit one.
+             *
+             */
+            bool read_size(std::uint8_t fix, std::uint8_t fix_mask, std::uint8_t marker_8, std::size_t &size)
+            {
+                const unsigned char marker = *cur++;
+                if ((marker & ~fix_mask) == fix)
+                {
+                    size = marker & fix_mask;
+                    return true;
+                }
+                const std::uint8_t marker_16 = marker_8 != 0 ? marker_8 + 1 : (fix == 0x90 ? 0xDC : 0xDE);
+                if (marker == marker_8)
+                {
+                    return read_length<std::uint8_t>(size);
+                }
+                if (marker == marker_16)
+                {
+                    return read_length<std::uint16_t>(size);
+                }
+                return read_length<std::uint32_t>(size);
+            }
+
+            template <typename U>
+            bool read_length(std::size_t &size)
+            {
+                U value = 0;
+                if (!read_big_endian(value))
+                {
+                    return false;
+                }
+                size = value;
+                return true;
+            }
+
+            /** @brief Skip a bin or ext value, whose content is never looked into.
+             *
+             */
+            bool skip_bytes()
+            {
+                const unsigned char marker = *cur++;
+                std::size_t size = 0;
+                if (marker >= 0xD4 && marker <= 0xD8)
+                {
+                    size = (std::size_t{1} << (marker - 0xD4)) + 1; // fixext, with the type byte
+                }
+                else
+                {
+                    // bin 8/16/32 are 0xC4 to 0xC6 and ext 8/16/32 are 0xC7 to 0xC9, and ext has a type byte.
+                    const unsigned width = marker <= 0xC6 ? marker - 0xC4 : marker - 0xC7;
+                    const bool ok = width == 0 ? read_length<std::uint8_t>(size) : (width == 1 ? read_length<std::uint16_t>(size) : read_length<std::uint32_t>(size));
+                    if (!ok)
+                    {
+                        return false;
+                    }
+                    size += marker >= 0xC7 ? 1 : 0;
+                }
+                if (!has(size))
+                {
+                    return false;
+                }
+                cur += size;
+                return true;
+            }
+        };
+
+        /** @brief Convert a number to T, and fail if it doesn't fit.
+         *
+         * Integers are converted to floating point numbers, but not the other way around.
+         *
+         */
+        template <typename T>
+        bool convert_number(decoder &d, const number &n, T &t)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                switch (n.type)
+                {
+                case number::kind::integer:
+                    t = static_cast<T>(n.integer);
+                    break;
+                case number::kind::unsigned_integer:
+                    t = static_cast<T>(n.unsigned_integer);
+                    break;
+                default:
+                    t = static_cast<T>(n.floating);
+                    break;
+                }
+                return true;
+            }
+            else
+            {
+                if (n.type == number::kind::floating)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                // std::in_range only takes the standard integer types, so char, wchar_t and char8_t are
+                // checked as the standard one of the same width and signedness.
+                using U = std::conditional_t<std::is_signed_v<T>, std::make_signed_t<T>, std::make_unsigned_t<T>>;
+                if (n.type == number::kind::integer ? !std::in_range<U>(n.integer) : !std::in_range<U>(n.unsigned_integer))
+                {
+                    return d.fail(errc::number_out_of_range);
+                }
+                t = static_cast<T>(n.type == number::kind::integer ? static_cast<U>(n.integer) : static_cast<U>(n.unsigned_integer));
+                return true;
+            }
+        }
+
+        template <typename T>
+        bool read_value(decoder &d, T &t);
+
+        /** @brief Read the value of the Kth Field of T, the position is known at compile time.
+         *
+         * The same value is read again into each Field that it hides, like the json reader does.
+         *
+         */
+        template <typename T, std::size_t K>
+        bool read_member(decoder &d, T &t)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            constexpr auto &hidden = fields::template hidden<K>;
+            if constexpr (hidden.size() == 0)
+            {
+                return read_value(d, boost::pfr::get<fields::index[K]>(t).value);
+            }
+            else
+            {
+                const std::size_t start = d.offset();
+                const bool ok = [&]<std::size_t... J>(std::index_sequence<J...>)
+                {
+                    return ((d.rewind(start), read_value(d, boost::pfr::get<hidden[J]>(t).value)) && ...);
+                }(std::make_index_sequence<hidden.size()>{});
+                return ok && (d.rewind(start), read_value(d, boost::pfr::get<fields::index[K]>(t).value));
+            }
+        }
+
+        /** @brief Read a map into an aggregate type.
+         *
+         * The keys are looked up with the same perfect hash as the json reader. The keys that are not
+         * tag of any Field are skipped. All the Fields must be present, except the optional ones.
+         *
+         */
+        template <typename T>
+        bool read_object(decoder &d, T &t)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            static constexpr auto readers = []<std::size_t... K>(std::index_sequence<K...>)
+            {
+                return std::array<bool (*)(decoder &, T &), fields::size>{&read_member<T, K>...};
+            }(std::make_index_sequence<fields::size>{});
+
+            std::size_t size = 0;
+            if (!d.read_map_header(size))
+            {
+                return false;
+            }
+            std::array<bool, fields::size> seen{};
+            for (std::size_t i = 0; i < size; i++)
+            {
+                value_kind kind = value_kind::nil;
+                if (!d.next_kind(kind))
+                {
+                    return false;
+                }
+                if (kind != value_kind::string)
+                {
+                    // the key is not a str, so it can't be a tag.
+                    if (!d.skip_value() || !d.skip_value())
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                std::string_view key;
+                if (!d.read_string(key))
+                {
+                    return false;
+                }
+                const std::size_t k = fields::find(key);
+                if (k == fields::size)
+                {
+                    if (!d.skip_value())
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                seen[k] = true;
+                if (!readers[k](d, t))
+                {
+                    return false;
+                }
+            }
+
+            // report the first missing one in the order of declaration, the optional ones get their default value.
+            const std::size_t missing = kie::serde::reflection::find_missing<T>(seen);
+            if (missing != fields::size)
+            {
+                d.missing_key = fields::tags[missing];
+                return d.fail(errc::missing_field);
+            }
+            kie::serde::reflection::reset_missing(t, seen);
+            return true;
+        }
+
+        /** @brief Read a value into T, whatever T is.
+         *
+         * - Arithmetic types accept numbers that fit, and bool only accepts boolean.
+         * - String accepts str. `std::string_view` points into the input.
+         * - Container accepts array, and becomes empty for nil.
+         * - `std::optional` becomes `std::nullopt` for nil, and reads the value it holds otherwise.
+         * - `kie::serde::Lazy` reads the value it holds right away, and keeps no raw text.
+         * - Aggregate with Fields accepts map. Aggregate without Field accepts anything and ignores it.
+         *
+         */
+        template <typename T>
+        bool read_value(decoder &d, T &t)
+        {
+            value_kind kind = value_kind::nil;
+            if (!d.next_kind(kind))
+            {
+                return false;
+            }
+
+            if constexpr (type_trait::is_specialization_of<T, std::optional>::value)
+            {
+                if (kind == value_kind::nil)
+                {
+                    t.reset();
+                    return d.read_nil();
+                }
+                return read_value(d, t.emplace());
+            }
+            else if constexpr (type_trait::is_lazy<T>::value)
+            {
+                // read into a new value, so the raw text that t may hold is never parsed.
+                typename T::Type value{};
+                if (!read_value(d, value))
+                {
+                    return false;
+                }
+                t = std::move(value);
+                return true;
+            }
+            else if constexpr (type_trait::is_string<T> || type_trait::is_string_view<T>)
+            {
+                if (kind != value_kind::string)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                std::string_view view;
+                if (!d.read_string(view))
+                {
+                    return false;
+                }
+                if constexpr (type_trait::is_string_view<T>)
+                {
+                    t = view;
+                }
+                else
+                {
+                    t.assign(view.data(), view.size());
+                }
+                return true;
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                if (kind != value_kind::boolean)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                return d.read_boolean(t);
+            }
+            else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            {
+                if (kind != value_kind::number)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                number n;
+                if (!d.read_number(n))
+                {
+                    return false;
+                }
+                if constexpr (std::is_enum_v<T>)
+                {
+                    std::underlying_type_t<T> value{};
+                    if (!convert_number(d, n, value))
+                    {
+                        return false;
+                    }
+                    t = static_cast<T>(value);
+                    return true;
+                }
+                else
+                {
+                    return convert_number(d, n, t);
+                }
+            }
+            else if constexpr (type_trait::is_dynamic_container<T>)
+            {
+                t.clear();
+                if (kind == value_kind::nil)
+                {
+                    return d.read_nil();
+                }
+                if (kind != value_kind::array)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                std::size_t size = 0;
+                if (!d.read_array_header(size))
+                {
+                    return false;
+                }
+                if constexpr (requires { t.reserve(size); })
+                {
+                    t.reserve(std::min(size, max_reserve_bytes / sizeof(typename T::value_type)));
+                }
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    if constexpr (std::is_same_v<typename T::value_type, bool>)
+                    {
+                        bool item = false;
+                        if (!read_value(d, item))
+                        {
+                            return false;
+                        }
+                        t.push_back(item);
+                    }
+                    else if (!read_value(d, t.emplace_back()))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            else if constexpr (type_trait::is_array_class<T>::value)
+            {
+                t = T{};
+                if (kind == value_kind::nil)
+                {
+                    return d.read_nil();
+                }
+                if (kind != value_kind::array)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                std::size_t size = 0;
+                if (!d.read_array_header(size))
+                {
+                    return false;
+                }
+                for (std::size_t i = 0; i < size; i++)
+                {
+                    if (!(i < t.size() ? read_value(d, t[i]) : d.skip_value()))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            else if constexpr (kie::serde::reflection::fields<T>::size == 0)
+            {
+                t = T{};
+                return d.skip_value();
+            }
+            else
+            {
+                // the members that are not Field are reset as well.
+                t = T{};
+                if (kind != value_kind::map)
+                {
+                    return d.fail(errc::type_mismatch);
+                }
+                return read_object(d, t);
+            }
+        }
+
+        /** @brief Read the whole input into t, and throw `msgpack_error` if it fails.
+         *
+         */
+        template <typename T>
+        void read_msgpack(std::string_view bytes, T &t)
+        {
+            decoder d{bytes};
+            if (!read_value(d, t) || !d.finish())
+            {
+                throw msgpack_error(d.error, d.position, d.error == errc::missing_field ? "'" + std::string{d.missing_key} + "'" : std::string{});
+            }
+        }
+    }
+
+    /** @brief Deserialize MessagePack into an aggregate type.
+     *
+     * It's the reverse of `to_msgpack`. The map keys can be in any order, the unknown ones are
+     * skipped, and all the Fields must be present. The Fields of `std::string_view` point into
+     * `bytes`, so the result must not outlive the input.
+     *
+     * @param bytes The MessagePack bytes, e.g. the string returned by `to_msgpack`.
+     * @throw msgpack_error if the input is malformed, a Field is missing or of wrong type.
+     */
+    template <typename T>
+    requires std::is_aggregate_v<T> && std::is_class_v<T>
+        T from_msgpack(std::string_view bytes)
+    {
+        T t{};
+        impl::read_msgpack(bytes, t);
+        return t;
+    }
+
+    /** @brief Deserialize MessagePack into a container type.
+     *
+     * The container is empty if the input is nil.
+     *
+     * @param bytes The MessagePack bytes, e.g. the string returned by `to_msgpack`.
+     * @throw msgpack_error if the input is malformed, or an item is of wrong type.
+     */
+    template <kie::serde::type_trait::is_dynamic_container T>
+    T from_msgpack(std::string_view bytes)
+    {
+        T t;
+        impl::read_msgpack(bytes, t);
+        return t;
+    }
+
+} // namespace kie::serde_msgpack
+
+#endif
@@ -0,0 +1,377 @@
+#ifndef KIE_TOOLBOX_SERDE_MSGPACK_WRITER_HPP
+#define KIE_TOOLBOX_SERDE_MSGPACK_WRITER_HPP
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+#include <boost/pfr.hpp>
+
+
+#include "../serde/field.hpp"
+#include "../serde/lazy.hpp"
+#include "../serde/reflection.hpp"
+#include "../serde/type_trait.hpp"
+#include "error.hpp"
+
+
+/** @brief the main namespace of this library
+ *
+ *
+ */
+namespace kie::serde_msgpack
+{
+
+    /** @brief This namespace contains some function used internally.
+     *
+     * They are all for some overload resolution.
+     *
+     */
+    namespace impl
+    {
+        namespace type_trait = kie::serde::type_trait;
+
+        /** @brief An output buffer that also tells how many bytes it holds.
+         *
+         * The size is the position of `errc::too_long`, which is thrown while writing a header.
+         */
+        template <typename T>
+        concept is_counted_output = type_trait::is_output_buffer<T> && requires(const T &buffer)
+        {
+            {
+                buffer.size()
+            } -> std::convertible_to<std::size_t>;
+        };
+
+        /** @brief Count the bytes appended to an output buffer that has no `size()`.
+         *
+         * The count starts from 0, so it's the number of bytes written by this serialization.
+         */
+        template <type_trait::is_output_buffer B>
+        class output_counter
+        {
+            B &out;
+            std::size_t count = 0;
+
+        public:
+            explicit output_counter(B &buffer) : out(buffer)
+            {
+            }
+
+            void append(const char *data, std::size_t size)
+            {
+                out.append(data, size);
+                count += size;
+            }
+
+            void push_back(char c)
+            {
+                out.push_back(c);
+                count++;
+            }
+
+            std::size_t size() const
+            {
+                return count;
+            }
+        };
+
+        /** @brief Write a marker followed by an unsigned value in big endian.
+         *
+         */
+        template <typename U, type_trait::is_output_buffer B>
+        void write_big_endian(std::uint8_t marker, U value, B &out)
+        {
+            char buffer[1 + sizeof(U)];
+            buffer[0] = static_cast<char>(marker);
+            for (std::size_t i = 0; i < sizeof(U); i++)
+            {
+                buffer[1 + i] = static_cast<char>((value >> (8 * (sizeof(U) - 1 - i))) & 0xFF);
+            }
+            out.append(buffer, sizeof(buffer));
+        }
+
+        template <type_trait::is_output_buffer B>
+        void write_nil(B &out)
+        {
+            out.push_back(static_cast<char>(0xC0));
+        }
+
+        /** @brief Write an unsigned integer in the smallest format that holds it.
+         *
+         */
+        template <type_trait::is_output_buffer B>
+        void write_unsigned(std::uint64_t value, B &out)
+        {
+            if (value <= 0x7F)
+            {
+                out.push_back(static_cast<char>(value)); // positive fixint
+            }
+            else if (value <= 0xFF)
+            {
+                write_big_endian(0xCC, static_cast<std::uint8_t>(value), out);
+            }
+            else if (value <= 0xFFFF)
+            {
+                write_big_endian(0xCD, static_cast<std::uint16_t>(value), out);
+            }
+            else if (value <= 0xFFFFFFFF)
+            {
+                write_big_endian(0xCE, static_cast<std::uint32_t>(value), out);
+            }
+            else
+            {
+                write_big_endian(0xCF, value, out);
+            }
+        }
+
+        /** @brief Write a signed integer in the smallest format that holds it.
+         *
+         * The non-negative ones are written as unsigned, as the specification suggests.
+         *
+         */
+        template <type_trait::is_output_buffer B>
+        void write_signed(std::int64_t value, B &out)
+        {
+            if (value >= 0)
+            {
+                write_unsigned(static_cast<std::uint64_t>(value), out);
+            }
+            else if (value >= -32)
+            {
+                out.push_back(static_cast<char>(value)); // negative fixint
+            }
+            else if (value >= std::numeric_limits<std::int8_t>::min())
+            {
+                write_big_endian(0xD0, static_cast<std::uint8_t>(value), out);
+            }
+            else if (value >= std::numeric_limits<std::int16_t>::min())
+            {
+                write_big_endian(0xD1, static_cast<std::uint16_t>(value), out);
+            }
+            else if (value >= std::numeric_limits<std::int32_t>::min())
+            {
+                write_big_endian(0xD2, static_cast<std::uint32_t>(value), out);
+            }
+            else
+            {
+                write_big_endian(0xD3, static_cast<std::uint64_t>(value), out);
+            }
+        }
+
+        /** @brief Write a header of str, array or map, which only differs in the markers.
+         *
+         * @param fix The marker of the fix format, which holds the size in its low bits.
+         * @param fix_limit The size limit of the fix format.
+         * @param marker_8 The marker of the format with 8-bit size, or 0 if there is none.
+         */
+        template <is_counted_output B>
+        void write_header(std::size_t size, std::uint8_t fix, std::size_t fix_limit, std::uint8_t marker_8, std::uint8_t marker_16, std::uint8_t marker_32, B &out)
+        {
+            if (size < fix_limit)
+            {
+                out.push_back(static_cast<char>(fix | size));
+            }
+            else if (marker_8 != 0 && size <= 0xFF)
+            {
+                write_big_endian(marker_8, static_cast<std::uint8_t>(size), out);
+            }
+            else if (size <= 0xFFFF)
+            {
+                write_big_endian(marker_16, static_cast<std::uint16_t>(size), out);
+            }
+            else if (size <= 0xFFFFFFFF)
+            {
+                write_big_endian(marker_32, static_cast<std::uint32_t>(size), out);
+            }
+            else
+            {
+                throw msgpack_error(errc::too_long, out.size(), "(length " + std::to_string(size) + ")");
+            }
+        }
+
+        template <is_counted_output B>
+        void write_string(std::string_view str, B &out)
+        {
+            write_header(str.size(), 0xA0, 32, 0xD9, 0xDA, 0xDB, out);
+            out.append(str.data(), str.size());
+        }
+
+        template <is_counted_output B>
+        void write_array_header(std::size_t size, B &out)
+        {
+            write_header(size, 0x90, 16, 0, 0xDC, 0xDD, out);
+        }
+
+        template <is_counted_output B>
+        void write_map_header(std::size_t size, B &out)
+        {
+            write_header(size, 0x80, 16, 0, 0xDE, 0xDF, out);
+        }
+
+        template <typename T, is_counted_output B>
+        void write_value(const T &t, B &out);
+
+        /** @brief Write a container as array.
+         *
+         * Unlike json, an empty container is an empty array instead of nil.
+         *
+         */
+        template <type_trait::is_container T, is_counted_output B>
+        void write_container(const T &t, B &out)
+        {
+            write_array_header(static_cast<std::size_t>(std::distance(std::begin(t), std::end(t))), out);
+            for (const auto &item : t)
+            {
+                write_value(item, out);
+            }
+        }
+
+        /** @brief Write an aggregate type as map.
+         *
+         * The Fields are written in the order of their tags with the tags as keys, and other members
+         * are ignored. If there is no Field at all, nil is written.
+         *
+         */
+        template <typename T, is_counted_output B>
+        void write_object(const T &t, B &out)
+        {
+            using fields = kie::serde::reflection::fields<T>;
+            if constexpr (fields::size == 0)
+            {
+                write_nil(out);
+            }
+            else
+            {
+                write_map_header(fields::size, out);
+                [&]<std::size_t... K>(std::index_sequence<K...>)
+                {
+                    ((write_string(fields::tags[K], out),
+                      write_value(boost::pfr::get<fields::index[K]>(t).value, out)),
+                     ...);
+                }(std::make_index_sequence<fields::size>{});
+            }
+        }
+
+        /** @brief Write the value held by a Field, or an item of a container.
+         *
+         */
+        template <typename T, is_counted_output B>
+        void write_value(const T &t, B &out)
+        {
+            if constexpr (type_trait::is_string<T> || type_trait::is_string_view<T>)
+            {
+                write_string(t, out);
+            }
+            else if constexpr (type_trait::is_lazy<T>::value)
+            {
+                write_value(t.get(), out); // the raw text is json, so the value is written
+            }
+            else if constexpr (type_trait::is_specialization_of<T, std::optional>::value)
+            {
+                if (t)
+                {
+                    write_value(*t, out);
+                }
+                else
+                {
+                    write_nil(out);
+                }
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                out.push_back(static_cast<char>(t ? 0xC3 : 0xC2));
+            }
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                write_big_endian(0xCA, std::bit_cast<std::uint32_t>(t), out);
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                write_big_endian(0xCB, std::bit_cast<std::uint64_t>(static_cast<double>(t)), out);
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                write_signed(t, out);
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                write_unsigned(t, out);
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                write_value(static_cast<std::underlying_type_t<T>>(t), out);
+            }
+            else if constexpr (type_trait::is_container<T>)
+            {
+                write_container(t, out);
+            }
+            else
+            {
+                write_object(t, out);
+            }
+        }
+    }
+
+    /** @brief Serialize T as MessagePack and append the bytes to the buffer.
+     *
+     * It walks the Fields of T in the same way as `kie::serde_json::write_json`. An aggregate becomes
+     * a map from tags to values, a container becomes an array, and float and double keep their
+     * precision.
+     *
+     * Usage:
+     * @code
+     * std::string buffer;
+     * kie::serde_msgpack::write_msgpack(a, buffer);
+     * @endcode
+     *
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @param out The buffer that the bytes are appended to.
+     */
+    template <typename T, kie::serde::type_trait::is_output_buffer B>
+    void write_msgpack(const T &t, B &out)
+    {
+        if constexpr (!impl::is_counted_output<B>)
+        {
+            impl::output_counter<B> counted{out};
+            write_msgpack(t, counted);
+        }
+        else if constexpr (kie::serde::type_trait::is_container<T>)
+        {
+            impl::write_container(t, out);
+        }
+        else if constexpr (std::is_class_v<T> && !kie::serde::type_trait::is_string<T> && !kie::serde::type_trait::is_string_view<T>)
+        {
+            impl::write_object(t, out);
+        }
+        else
+        {
+            impl::write_nil(out); // nil for the type without wrapping with Field
+        }
+    }
+
+    /** @brief Serialize T as MessagePack.
+     *
+     * @param t The value to serialize. It should be of aggregate type or container.
+     * @return The bytes held by a string.
+     */
+    template <typename T>
+    std::string to_msgpack(const T &t)
+    {
+        std::string out;
+        write_msgpack(t, out);
+        return out;
+    }
+
+} // namespace kie::serde_msgpack
+
+#endif
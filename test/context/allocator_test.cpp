@@ -0,0 +1,186 @@
+#include <context/context.hpp>
+#include <context/work_stealing.hpp>
+#include <atomic>
+#include <coroutine>
+#include <cstdlib>
+#include <iostream>
+
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size){
+    allocations++;
+    if(void* p = std::malloc(size == 0 ? 1 : size)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+int failed = 0;
+
+void check(bool ok, const char* what){
+    if(!ok){
+        std::cout<<"[KIE] check failed: "<<what<<std::endl;
+        failed++;
+    }
+}
+
+void pool(){
+    using pool = kie::impl::recycling_pool;
+    check(pool::size_class(1) == 0 && pool::size_class(16) == 0 && pool::size_class(17) == 1 && pool::size_class(4096) == 8, "size classes");
+
+    kie::recycling_allocator<char> allocator;
+    char* first = allocator.allocate(100);
+    allocator.deallocate(first, 100);
+    check(pool::local()->cached(pool::size_class(100)) == 1, "the block is kept");
+    char* second = allocator.allocate(120);
+    check(first == second, "the block is reused for the same size class");
+    allocator.deallocate(second, 120);
+
+    //a block freed on another thread is kept there
+    char* moved = allocator.allocate(100);
+    std::thread([&]{
+        kie::recycling_allocator<char>{}.deallocate(moved, 100);
+        check(pool::local()->cached(pool::size_class(100)) == 1, "the block is kept by the other thread");
+    }).join();
+
+    //the large blocks are not kept
+    char* large = allocator.allocate(10000);
+    allocator.deallocate(large, 10000);
+    check(kie::recycling_allocator<int>{} == kie::recycling_allocator<double>{}, "the allocators are equal");
+}
+
+void handlers(){
+    boost::asio::io_context io;
+    int count = 0;
+    auto post_all = [&]{
+        for(int i = 0; i < 100; i++){
+            boost::asio::post(io, kie::bind_recycling_allocator([&count, padding = std::array<char, 64>{}]{ count += 1 + padding[0]; }));
+        }
+        io.restart();
+        io.run();
+    };
+
+    //after the first round, the handlers are allocated from the free lists
+    post_all();
+    const std::size_t before = allocations;
+    for(int round = 0; round < 10; round++){
+        post_all();
+    }
+    check(count == 1100, "all the handlers run");
+    check(allocations == before, "the posted handlers do not allocate in the steady state");
+
+    //the operations of sockets too, with the executor type that is not erased
+    using socket = boost::asio::basic_stream_socket<boost::asio::local::stream_protocol, boost::asio::io_context::executor_type>;
+    socket reader(io), writer(io);
+    boost::asio::local::connect_pair(reader, writer);
+    char buffer[4];
+    auto read_write = [&]{
+        boost::asio::async_read(reader, boost::asio::buffer(buffer), kie::bind_recycling_allocator([&](boost::system::error_code ec, std::size_t){
+            check(!ec, "read");
+            count++;
+        }));
+        boost::asio::async_write(writer, boost::asio::buffer("ping", 4), kie::bind_recycling_allocator([&](boost::system::error_code ec, std::size_t){
+            check(!ec, "write");
+            count++;
+        }));
+        io.restart();
+        io.run();
+    };
+    read_write();
+    const std::size_t after_warm_up = allocations;
+    for(int round = 0; round < 10; round++){
+        read_write();
+    }
+    check(count == 1122, "all the reads and writes complete");
+    check(allocations == after_warm_up, "the socket operations do not allocate in the steady state");
+
+    //the other associated characteristics of the handler are kept
+    boost::asio::cancellation_signal signal;
+    auto bound = kie::bind_recycling_allocator(boost::asio::bind_cancellation_slot(signal.slot(), boost::asio::bind_executor(io, []{})));
+    check(boost::asio::get_associated_cancellation_slot(bound) == signal.slot(), "the cancellation slot is kept");
+    check(boost::asio::get_associated_executor(bound) == io.get_executor(), "the executor is kept");
+    check(boost::asio::get_associated_allocator(bound) == kie::recycling_allocator<void>{}, "the allocator is attached");
+}
+
+struct task{
+    struct promise_type : kie::recycling_new{
+        task get_return_object(){ return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void(){}
+        void unhandled_exception(){ std::terminate(); }
+    };
+};
+
+task add(int& count){
+    count++;
+    co_return;
+}
+
+void frames(){
+    int count = 0;
+    add(count);
+    const std::size_t before = allocations;
+    for(int i = 0; i < 100; i++){
+        add(count);
+    }
+    check(count == 101, "the coroutines run");
+    check(allocations == before, "the coroutine frames are reused");
+}
+
+void executor(){
+    kie::context ctx(2);
+    auto& io = std::get<0>(ctx.get(0));
+    kie::context::counting_executor ex{ctx, 0};
+    check(boost::asio::query(ex, boost::asio::execution::allocator) == kie::recycling_allocator<void>{}, "the executor gives the recycling allocator");
+    int count = 0;
+    auto post_all = [&]{
+        for(int i = 0; i < 100; i++){
+            boost::asio::post(ex, [&count, padding = std::array<char, 64>{}]{ count += 1 + padding[0]; });
+        }
+        io.poll();
+    };
+
+    //the functions submitted through the executor are allocated from the free lists
+    post_all();
+    const std::size_t before = allocations;
+    for(int round = 0; round < 10; round++){
+        post_all();
+    }
+    check(count == 1100, "all the functions run");
+    check(allocations == before, "the executor does not allocate in the steady state");
+}
+
+void work_stealing(){
+    kie::context ctx(2);
+    kie::work_stealing_executor cpu(ctx);
+    check(ctx.get_allocator() == kie::recycling_allocator<int>{}, "the context gives the recycling allocator");
+    std::atomic<int> count{0};
+    for(int i = 0; i < 100; i++){
+        cpu.post([&]{ count++; });
+    }
+    std::thread runner([&]{ ctx.run(); });
+    while(count != 100){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ctx.stop();
+    runner.join();
+}
+
+int main(){
+    pool();
+    handlers();
+    frames();
+    executor();
+    work_stealing();
+    std::cout<<"[KIE] allocator checked"<<std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include <context/context.hpp>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <system_error>
+
+//the addresses allocated while it's set, to find the io_contexts of a context that fails to construct
+std::atomic<bool> recording{false};
+std::array<std::atomic<void*>, 4096> recorded{};
+std::atomic<std::size_t> recorded_count{0};
+
+void* operator new(std::size_t size){
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if(p == nullptr){
+        throw std::bad_alloc();
+    }
+    if(recording){
+        const std::size_t idx = recorded_count++;
+        if(idx < recorded.size()){
+            recorded[idx] = p;
+        }
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+int failed = 0;
+
+void check(bool ok, const char* what){
+    if(!ok){
+        std::cout<<"[KIE] check failed: "<<what<<std::endl;
+        failed++;
+    }
+}
+
+void handlers(){
+    static_assert(kie::context_metrics::enabled);
+    kie::context ctx(2);
+    auto& first = std::get<0>(ctx.get(0));
+
+    //a slow handler holds up ten quick ones
+    std::atomic<int> done{0};
+    boost::asio::post(first, [&]{
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        done++;
+    });
+    for(int i = 0; i < 10; i++){
+        boost::asio::post(first, [&]{ done++; });
+    }
+    check(ctx.metrics(0).queued == 11, "the posted handlers are queued");
+
+    //a read is queued once the data has come
+    boost::asio::local::stream_protocol::socket reader(first), writer(first);
+    boost::asio::local::connect_pair(reader, writer);
+    char buffer[4];
+    reader.async_read_some(boost::asio::buffer(buffer), [&](boost::system::error_code ec, std::size_t){
+        check(!ec, "read");
+        done++;
+    });
+    check(ctx.metrics(0).queued == 11, "the read is not queued before the data comes");
+    boost::asio::write(writer, boost::asio::buffer("ping", 4));
+
+    std::thread runner([&]{ ctx.run(); });
+    while(done != 12){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    auto m = ctx.metrics(0);
+    check(m.handlers == 12, "all the handlers are counted");
+    check(m.queued == 0, "no handler is left in the queue");
+    check(m.busy >= std::chrono::milliseconds(20), "the slow handler is busy time");
+    check(m.idle >= std::chrono::milliseconds(10), "the time with no handler is idle time");
+    check(m.wait >= std::chrono::milliseconds(200), "the quick handlers wait behind the slow one");
+    check(m.busy_ratio() > 0.0 && m.busy_ratio() < 1.0, "busy ratio");
+
+    std::uint64_t runs = 0, waits = 0, slow = 0;
+    for(std::size_t k = 0; k < kie::context_metrics::buckets; k++){
+        runs += m.run_histogram[k];
+        waits += m.wait_histogram[k];
+        if(kie::context_metrics::bucket_bound(k) > std::chrono::milliseconds(20) && (k == 0 || kie::context_metrics::bucket_bound(k - 1) <= std::chrono::milliseconds(20))){
+            slow = m.run_histogram[k];
+        }
+    }
+    check(runs == 12 && waits == 12, "each handler is in the histograms");
+    check(slow == 1, "the slow handler is in its bucket");
+    check(ctx.metrics(1).handlers == 0 && ctx.metrics(1).idle > std::chrono::nanoseconds{0}, "the other context is idle");
+
+    ctx.stop();
+    runner.join();
+}
+
+void load(){
+    kie::context ctx(4);
+
+    //the handlers posted to the io_context directly are the load as well
+    for(int i = 0; i < 3; i++){
+        boost::asio::post(std::get<0>(ctx.get(1)), []{});
+    }
+    boost::asio::post(kie::context::counting_executor{ctx, 2}, []{});
+    check(ctx.load(1) == 3 && ctx.load(2) == 1, "the queued handlers are the load");
+    for(int i = 0; i < 8; i++){
+        auto& one = ctx.get_one(kie::context::pick::least_loaded);
+        check(&one == &std::get<0>(ctx.get(0)) || &one == &std::get<0>(ctx.get(3)), "least_loaded avoids the busy contexts");
+    }
+    for(std::size_t idx = 0; idx < 4; idx++){
+        std::get<0>(ctx.get(idx)).poll();
+        check(ctx.load(idx) == 0, "the handlers that have run are not load");
+    }
+}
+
+void many(){
+    //more io_contexts than the registry holds, each wrapped by a context for a short time
+    std::vector<std::unique_ptr<boost::asio::io_context>> all;
+    for(int i = 0; i < 1100; i++){
+        all.push_back(std::make_unique<boost::asio::io_context>(1));
+        kie::context ctx(*all.back());
+        check(ctx.metrics(0).tracked, "the removed contexts leave room for the new ones");
+    }
+
+    kie::context ctx(*all.front());
+    for(int i = 0; i < 10; i++){
+        boost::asio::post(*all.front(), []{});
+    }
+    //it was stopped when the work guard of the first context was gone
+    all.front()->restart();
+    all.front()->poll();
+    auto m = ctx.metrics(0);
+    check(m.tracked && m.handlers == 10, "a context is still counted after many are gone");
+}
+
+void partial(){
+    //the io_contexts of a context that fails to construct are removed from the registry
+    auto allowed = kie::impl::allowed_cpus();
+    bool thrown = false;
+    recording = true;
+    try{
+        kie::context ctx(2, kie::placement::cpus({allowed[0], -1}));
+    }catch(const std::system_error&){
+        thrown = true;
+    }
+    recording = false;
+    check(thrown && recorded_count > 0, "the context fails to construct");
+    bool found = false;
+    for(std::size_t i = 0; i < std::min(recorded_count.load(), recorded.size()); i++){
+        found = found || kie::impl::metrics_registry::find(recorded[i]) != nullptr;
+    }
+    check(!found, "nothing is left in the registry");
+}
+
+int main(){
+    handlers();
+    load();
+    many();
+    partial();
+    std::cout<<"[KIE] metrics checked"<<std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -1,10 +1,36 @@
 #include <context/context.hpp>
+#include <context/work_stealing.hpp>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <system_error>
 
 int now(){
     return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
+int failed = 0;
+
+void check(bool ok, const char* what){
+    if(!ok){
+        std::cout<<"[KIE] "<<now()<<" check failed: "<<what<<std::endl;
+        failed++;
+    }
+}
+
+template<typename E, typename F>
+void check_throw(F f, const char* what){
+    bool thrown = false;
+    try{
+        f();
+    }catch(const E&){
+        thrown = true;
+    }
+    check(thrown, what);
+}
+
 void run_as_daemon(){
     //run with specified concurrent
     kie::context ctx1(10);
@@ -64,17 +90,221 @@ void run(){
     std::cout<<"[KIE] "<<now()<<" ctx3 run stopped"<<std::endl;
 }
 
+void work_stealing(){
+    kie::context ctx(4);
+    kie::work_stealing_executor cpu(ctx);
+    std::thread runner([&]{ ctx.run(); });
+
+    //hold up the first io_context with a slow handler
+    std::atomic<bool> slow_started{false};
+    std::atomic<bool> slow_done{false};
+    boost::asio::post(std::get<0>(ctx.get(0)), [&]{
+        slow_started = true;
+        std::this_thread::sleep_for(std::chrono::seconds(3));
+        slow_done = true;
+    });
+    while(!slow_started){
+        std::this_thread::yield();
+    }
+
+    //the tasks queued on the first io_context are stolen by the others, and the tasks may be move-only
+    std::atomic<int> count{0};
+    for(int i = 0; i < 100; i++){
+        cpu.post([&count, one = std::make_unique<int>(1)]{ count += *one; });
+    }
+    cpu.post([&]{
+        cpu.post([&]{ count++; });
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(count != 101 && std::chrono::steady_clock::now() < deadline){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(count == 101, "all the tasks run while one io_context is busy");
+    check(!slow_done, "the tasks do not wait for the slow handler");
+    check(cpu.queued() == 0, "no task is left in the queues");
+
+    ctx.stop();
+    runner.join();
+    std::cout<<"[KIE] "<<now()<<" work stealing stopped"<<std::endl;
+}
+
+void selection(){
+    kie::context ctx(4);
+
+    //each thread takes all the contexts in turn, even when many threads pick at the same time
+    std::atomic<int> complete_rounds{0};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; t++){
+        threads.emplace_back([&]{
+            for(int round = 0; round < 1000; round++){
+                bool seen[4] = {};
+                for(int i = 0; i < 4; i++){
+                    auto& one = ctx.get_one();
+                    for(std::size_t idx = 0; idx < 4; idx++){
+                        if(&std::get<0>(ctx.get(idx)) == &one){
+                            seen[idx] = true;
+                        }
+                    }
+                }
+                if(seen[0] && seen[1] && seen[2] && seen[3]){
+                    complete_rounds++;
+                }
+            }
+        });
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+    check(complete_rounds == 8000, "get_one takes all the contexts in turn");
+
+    //the leases spread evenly
+    std::vector<kie::context::lease> leases;
+    for(int i = 0; i < 8; i++){
+        leases.push_back(ctx.acquire(kie::context::pick::least_loaded));
+    }
+    for(std::size_t idx = 0; idx < 4; idx++){
+        check(ctx.load(idx) == 2, "least_loaded spreads the leases evenly");
+    }
+    check(&leases[0].get() == &std::get<0>(ctx.get(leases[0].index())), "a lease gets its io_context");
+
+    for(int i = 0; i < 400; i++){
+        leases.push_back(ctx.acquire());
+    }
+    std::size_t total = 0;
+    for(std::size_t idx = 0; idx < 4; idx++){
+        total += ctx.load(idx);
+        check(ctx.load(idx) > 60, "two_choices spreads the leases");
+    }
+    check(total == 408, "each lease is counted once");
+
+    //two_choices always compares two different contexts, so a pair of them stays even
+    kie::context pair(2);
+    std::vector<kie::context::lease> pair_leases;
+    bool even = true;
+    for(int i = 0; i < 100; i++){
+        pair_leases.push_back(pair.acquire());
+        even = even && std::max(pair.load(0), pair.load(1)) - std::min(pair.load(0), pair.load(1)) <= 1;
+    }
+    check(even, "two_choices keeps a pair of contexts even");
+
+    //moving a lease keeps it, and dropping it releases the load
+    kie::context::lease moved = std::move(leases[0]);
+    check(!leases[0] && moved, "a lease is moved");
+    leases.clear();
+    check(ctx.load(moved.index()) == 1, "the leases are released");
+    moved.release();
+    check(ctx.load(0) + ctx.load(1) + ctx.load(2) + ctx.load(3) == 0, "a lease is released once");
+
+    //the work posted through a counting_executor is load until it's finished
+    std::atomic<int> ran{0};
+    for(int i = 0; i < 8; i++){
+        boost::asio::post(ctx.get_executor(kie::context::pick::least_loaded), [&]{ ran++; });
+    }
+    for(std::size_t idx = 0; idx < 4; idx++){
+        check(ctx.load(idx) == 2, "least_loaded spreads the work evenly");
+    }
+    boost::asio::post(kie::context::counting_executor{ctx, 0}, [&]{ ran++; });
+    for(int i = 0; i < 8; i++){
+        check(&ctx.get_one(kie::context::pick::least_loaded) != &std::get<0>(ctx.get(0)), "get_one avoids the busy context");
+    }
+    for(std::size_t idx = 0; idx < 4; idx++){
+        std::get<0>(ctx.get(idx)).poll();
+        check(ctx.load(idx) == 0, "the work that is finished is not load");
+    }
+    check(ran == 9, "the work runs on the context");
+    {
+        //the work destroyed with its context drops the load as well
+        kie::context pending(1);
+        boost::asio::post(pending.get_executor(), [&]{ ran++; });
+        check(pending.load(0) == 1, "the work is load before it runs");
+    }
+    std::cout<<"[KIE] "<<now()<<" selection checked"<<std::endl;
+
+    //nothing is gathered without the handler tracking
+    static_assert(!kie::context_metrics::enabled);
+    check(ctx.metrics(0).handlers == 0 && ctx.metrics(0).busy_ratio() == 0.0, "no metrics without the handler tracking");
+}
+
+void placement(){
+    auto list = kie::impl::parse_cpu_list("8,0-3,10-11\n");
+    check(list == std::vector<int>{0, 1, 2, 3, 8, 10, 11}, "parse a list of CPU");
+    check(kie::impl::parse_cpu_list("").empty(), "parse an empty list of CPU");
+
+    check(kie::placement{}.assign(4).empty(), "no CPU by default");
+    check(kie::placement::cpus({}).assign(4).empty(), "no CPU for an empty list");
+    check(kie::placement::cpus({3, 5}).assign(3) == std::vector<int>{3, 5, 3}, "the CPUs are taken from the list in turn");
+
+    auto allowed = kie::impl::allowed_cpus();
+    check(!allowed.empty(), "the allowed CPUs are found");
+    for(auto where : {kie::placement::per_core(), kie::placement::spread(), kie::placement::compact()}){
+        auto cpus = where.assign(allowed.size());
+        std::sort(cpus.begin(), cpus.end());
+        check(cpus == allowed, "each allowed CPU gets one thread");
+    }
+
+    //the threads run on the CPU they are pinned to
+    kie::context ctx(2);
+    std::atomic<int> on_cpu{0};
+    for(std::size_t i = 0; i < 2; i++){
+        boost::asio::post(std::get<0>(ctx.get(i)), [&]{
+            if(sched_getcpu() == allowed[0]){
+                on_cpu++;
+            }
+        });
+    }
+    ctx.release_guard();
+    ctx.run(0, kie::placement::cpus({allowed[0]}));
+    check(on_cpu == 2, "the threads are pinned");
+
+    //the threads run where the io_contexts are constructed by default
+    kie::context placed(2, kie::placement::cpus({allowed[0]}));
+    for(std::size_t i = 0; i < 2; i++){
+        boost::asio::post(std::get<0>(placed.get(i)), [&]{
+            if(sched_getcpu() == allowed[0]){
+                on_cpu++;
+            }
+        });
+    }
+    placed.release_guard();
+    placed.run();
+    check(on_cpu == 4, "the threads are pinned like the io_contexts");
+
+    //a thread that can't be pinned is reported, and nothing runs
+    bool ran = false;
+    boost::asio::post(std::get<0>(ctx.get(0)), [&]{ ran = true; });
+    std::get<0>(ctx.get(0)).restart();
+    check_throw<std::system_error>([&]{ ctx.run(0, kie::placement::cpus({allowed[0], -1})); }, "run throws if a thread can't be pinned");
+    check_throw<std::system_error>([&]{ ctx.run_as_daemon(0, kie::placement::cpus({-1})); }, "run_as_daemon throws if a thread can't be pinned");
+    check(!ran, "no thread runs if one can't be pinned");
+    check_throw<std::system_error>([]{ kie::context unplaced(1, kie::placement::cpus({-1})); }, "the constructor throws if a thread can't be pinned");
+
+    //the NUMA nodes that are online may not be numbered one after another
+    const auto root = std::filesystem::temp_directory_path() / "kie_context_nodes";
+    std::filesystem::create_directories(root / "node0");
+    std::filesystem::create_directories(root / "node2");
+    std::ofstream(root / "online") << "0,2\n";
+    std::ofstream(root / "node0" / "cpulist") << allowed.front() << "\n";
+    std::ofstream(root / "node2" / "cpulist") << allowed.back() << "\n";
+    auto nodes = kie::impl::numa_nodes(root.string());
+    check(nodes.size() == 2 && nodes[0] == std::vector<int>{allowed.front()} && nodes[1] == std::vector<int>{allowed.back()}, "the sparse nodes are found");
+    std::filesystem::remove_all(root);
+    std::cout<<"[KIE] "<<now()<<" placement checked"<<std::endl;
+}
 
 void all_test(){
     std::cout<<"[KIE] "<<now()<<" start test"<<std::endl;
+    selection();
+    placement();
     run();
     std::cout<<"[KIE] "<<now()<<" finish run and start run as daemon"<<std::endl;
     run_as_daemon();
     std::cout<<"[KIE] "<<now()<<" finish run as daemon"<<std::endl;
+    work_stealing();
+    std::cout<<"[KIE] "<<now()<<" finish work stealing"<<std::endl;
 }
 
 
 int main(){
     all_test();
-    return 0;
+    return failed == 0 ? 0 : 1;
 }
\ No newline at end of file
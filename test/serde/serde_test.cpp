@@ -1,4 +1,5 @@
 #include <serde/field.hpp>
+#include <serde/reflection.hpp>
 #include <iostream>
 #include <gtest/gtest.h>
 
@@ -8,8 +9,57 @@ TEST(FieldTest, StructComplex)
   
 }
 
+// Demonstrate some basic assertions.
+TEST(ReflectionTest, Fields)
+{
+  struct A
+  {
+    kie::serde::Field<int, "b"> b;
+    int not_field;
+    kie::serde::Field<int, "a"> a;
+    kie::serde::Field<int, "c"> c;
+    kie::serde::Field<int, "a"> a_again;
+  };
+
+  using fields = kie::serde::reflection::fields<A>;
+  static_assert(fields::size == 3);
+  static_assert(fields::tags == std::array<std::string_view, 3>{"a", "b", "c"});
+  static_assert(fields::index == std::array<std::size_t, 3>{4, 0, 3});
+  static_assert(fields::hidden<0> == std::array<std::size_t, 1>{2});
+  static_assert(fields::hidden<1>.empty() && fields::hidden<2>.empty());
+
+  static_assert(fields::find("a") == 0);
+  static_assert(fields::find("b") == 1);
+  static_assert(fields::find("c") == 2);
+  static_assert(fields::find("d") == 3);
+  static_assert(fields::find("") == 3);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReflectionTest, PerfectHash)
+{
+  constexpr std::array<std::string_view, 12> keys{"", "id", "name", "user_id", "user_ix", "aXbcd", "aYbcd", "x", "y", "z", "timestamp", "a very long key that is longer than the others"};
+  constexpr kie::serde::reflection::perfect_hash<12> table{keys};
+  static_assert(table.valid);
+
+  for (std::size_t i = 0; i < keys.size(); i++)
+  {
+    EXPECT_EQ(table.find(keys[i]), i);
+  }
+  for (std::string_view key : {"user_iy", "aZbcd", "names", "nam", "Id", "timestamp "})
+  {
+    EXPECT_EQ(table.find(key), keys.size());
+  }
+
+  constexpr kie::serde::reflection::perfect_hash<0> empty{{}};
+  EXPECT_EQ(empty.find("any"), 0u);
+
+  constexpr kie::serde::reflection::perfect_hash<2> duplicated{{"a", "a"}};
+  static_assert(!duplicated.valid);
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
@@ -0,0 +1,241 @@
+#include <serde_json/json.hpp>
+#include <serde_json/async.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read.hpp>
+#include <functional>
+#include <iostream>
+#include <gtest/gtest.h>
+
+namespace
+{
+  using kie::serde::Field;
+
+  struct Record
+  {
+    Field<int, "id"> id;
+    Field<std::string, "name"> name;
+    Field<std::vector<double>, "values"> values;
+  };
+
+  struct Batch
+  {
+    Field<std::string, "cursor"> cursor;
+    Field<std::vector<Record>, "records"> records;
+    Field<std::list<int>, "list"> list;
+    Field<std::vector<int>, "empty"> empty;
+  };
+
+  struct Items
+  {
+    Field<std::vector<int>, "items"> items;
+    Field<std::optional<std::vector<Record>>, "records"> records;
+  };
+
+  struct Envelope
+  {
+    Field<int, "code"> code;
+    Field<Items, "result"> result;
+  };
+
+  Batch make(int size)
+  {
+    Batch batch{.cursor = std::string{"next"}, .list = std::list<int>{1, 2}};
+    for (int i = 0; i < size; i++)
+    {
+      batch.records.value.push_back(Record{.id = i, .name = "record " + std::to_string(i), .values = std::vector<double>(static_cast<std::size_t>(i % 4), 0.5)});
+    }
+    return batch;
+  }
+
+  // A stream that keeps what is written, and at most `limit` bytes for each write_some.
+  class recording_stream
+  {
+  public:
+    using executor_type = boost::asio::io_context::executor_type;
+
+    explicit recording_stream(boost::asio::io_context &io) : io(io) {}
+
+    executor_type get_executor() { return io.get_executor(); }
+
+    template <typename Buffers, typename Handler>
+    void async_write_some(const Buffers &buffers, Handler &&handler)
+    {
+      std::size_t written = 0;
+      std::size_t count = 0;
+      boost::system::error_code ec;
+      for (auto it = boost::asio::buffer_sequence_begin(buffers); it != boost::asio::buffer_sequence_end(buffers); ++it)
+      {
+        const boost::asio::const_buffer buffer = *it;
+        const std::size_t size = std::min(buffer.size(), limit - written);
+        if (text.size() + size > fail_after)
+        {
+          ec = boost::asio::error::broken_pipe;
+          break;
+        }
+        text.append(static_cast<const char *>(buffer.data()), size);
+        largest = std::max(largest, buffer.size());
+        written += size;
+        count += buffer.size() == 0 ? 0 : 1;
+      }
+      writes.push_back(count);
+      boost::asio::post(io, [handler = std::move(handler), ec, written]() mutable
+                        { handler(ec, written); });
+    }
+
+    boost::asio::io_context &io;
+    std::string text;
+    std::vector<std::size_t> writes;
+    std::size_t largest = 0;
+    std::size_t limit = 1 << 20;
+    std::size_t fail_after = std::string::npos;
+  };
+}
+
+// Demonstrate some basic assertions.
+TEST(AsyncWriteJson, SameAsWriteJson)
+{
+  using namespace kie::serde_json;
+
+  for (int size : {0, 1, 10, 2000})
+  {
+    for (std::size_t buffer_size : {std::size_t{1}, std::size_t{64}, std::size_t{16 * 1024}})
+    {
+      const Batch batch = make(size);
+      boost::asio::io_context io;
+      recording_stream stream{io};
+      stream.limit = 1000;
+      boost::system::error_code result = boost::asio::error::fault;
+      std::size_t sent = 0;
+      async_write_json(stream, batch, {.buffer_size = buffer_size, .buffer_count = 3}, {.numbers = number_format::shortest}, [&](boost::system::error_code ec, std::size_t n)
+                       { result = ec; sent = n; });
+      // only the first buffer is written before the context runs.
+      EXPECT_TRUE(stream.text.empty() || stream.writes.size() == 1);
+      io.run();
+      EXPECT_FALSE(result) << size;
+      EXPECT_EQ(stream.text, to_json_string(batch, {.numbers = number_format::shortest})) << size;
+      EXPECT_EQ(sent, stream.text.size()) << size;
+      // at most 3 buffers are gathered in a write.
+      for (std::size_t count : stream.writes)
+      {
+        EXPECT_LE(count, 3u);
+      }
+    }
+  }
+
+  // the containers and the values that are not aggregates.
+  boost::asio::io_context io;
+  recording_stream stream{io};
+  const std::vector<Record> records = make(100).records.value;
+  async_write_json(stream, records, {.buffer_size = 100}, {}, [](boost::system::error_code, std::size_t) {});
+  io.run();
+  EXPECT_EQ(stream.text, to_json_string(records));
+  EXPECT_GT(stream.writes.size(), 2u);
+  EXPECT_EQ(stream.writes.front(), 1u);
+  EXPECT_EQ(stream.writes.back(), 4u);
+
+  for (const auto &check : std::vector<std::function<std::string(recording_stream &)>>{
+           [](recording_stream &s)
+           { static const std::vector<int> empty; async_write_json(s, empty, [](auto, auto) {}); return to_json_string(empty); },
+           [](recording_stream &s)
+           { static const int one = 1; async_write_json(s, one, [](auto, auto) {}); return to_json_string(one); },
+           [](recording_stream &s)
+           { static const std::list<int> list{1, 2}; async_write_json(s, list, [](auto, auto) {}); return to_json_string(list); },
+       })
+  {
+    io.restart();
+    recording_stream s{io};
+    const std::string expected = check(s);
+    io.run();
+    EXPECT_EQ(s.text, expected);
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(AsyncWriteJson, NestedEnvelope)
+{
+  using namespace kie::serde_json;
+
+  // the items deep in the envelope are split into buffers as well, instead of being written in one.
+  Envelope envelope{.code = 200};
+  envelope.result.value.items.value.resize(1000000, 123456);
+  envelope.result.value.records = std::optional<std::vector<Record>>{make(100).records.value};
+
+  boost::asio::io_context io;
+  recording_stream stream{io};
+  boost::system::error_code result = boost::asio::error::fault;
+  async_write_json(stream, envelope, {.buffer_size = 1024}, {}, [&](boost::system::error_code ec, std::size_t)
+                   { result = ec; });
+  io.run();
+  EXPECT_FALSE(result);
+  EXPECT_EQ(stream.text, to_json_string(envelope));
+  EXPECT_LE(stream.largest, 1024u + 64u);
+  EXPECT_GT(stream.writes.size(), 1000u);
+
+  // every place to resume from gives the same text.
+  envelope.result.value.items.value.resize(10);
+  for (std::size_t buffer_size = 1; buffer_size < 200; buffer_size++)
+  {
+    io.restart();
+    recording_stream s{io};
+    async_write_json(s, envelope, {.buffer_size = buffer_size, .buffer_count = 2}, {}, [](boost::system::error_code, std::size_t) {});
+    io.run();
+    EXPECT_EQ(s.text, to_json_string(envelope)) << buffer_size;
+  }
+
+  envelope.result.value.records.value.reset();
+  envelope.result.value.items.value.clear();
+  io.restart();
+  recording_stream empty{io};
+  async_write_json(empty, envelope, {.buffer_size = 1}, {}, [](boost::system::error_code, std::size_t) {});
+  io.run();
+  EXPECT_EQ(empty.text, to_json_string(envelope));
+}
+
+// Demonstrate some basic assertions.
+TEST(AsyncWriteJson, Error)
+{
+  using namespace kie::serde_json;
+
+  const Batch batch = make(1000);
+  boost::asio::io_context io;
+  recording_stream stream{io};
+  stream.fail_after = 5000;
+  boost::system::error_code result;
+  std::size_t sent = 0;
+  async_write_json(stream, batch, {.buffer_size = 1024}, {}, [&](boost::system::error_code ec, std::size_t n)
+                   { result = ec; sent = n; });
+  io.run();
+  EXPECT_EQ(result, boost::asio::error::broken_pipe);
+  EXPECT_EQ(sent, stream.text.size());
+  EXPECT_LE(sent, 5000u);
+  EXPECT_EQ(stream.text, to_json_string(batch).substr(0, sent));
+}
+
+// Demonstrate some basic assertions.
+TEST(AsyncWriteJson, Socket)
+{
+  using namespace kie::serde_json;
+
+  const Batch batch = make(5000);
+  boost::asio::io_context io;
+  boost::asio::local::stream_protocol::socket writer{io};
+  boost::asio::local::stream_protocol::socket reader{io};
+  boost::asio::local::connect_pair(writer, reader);
+
+  std::string received;
+  boost::asio::async_read(reader, boost::asio::dynamic_buffer(received), [](boost::system::error_code, std::size_t) {});
+  async_write_json(writer, batch, [&](boost::system::error_code ec, std::size_t)
+                   { EXPECT_FALSE(ec); writer.close(); });
+  io.run();
+  EXPECT_EQ(received, to_json_string(batch));
+  EXPECT_EQ(from_json<Batch>(received).records.value.size(), 5000u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,134 @@
+#include <serde_json/json.hpp>
+#include <iostream>
+#include <gtest/gtest.h>
+
+namespace
+{
+  using kie::serde::Field;
+
+  struct Inner
+  {
+    Field<int, "i"> i;
+  };
+
+  struct Record
+  {
+    Field<std::string, "name"> name;
+    Field<int, "id"> id;
+    Field<double, "score"> score;
+    Field<std::vector<int>, "tags"> tags;
+    Field<Inner, "inner"> inner;
+    int not_field = 0;
+  };
+
+  bool operator==(const Record &l, const Record &r)
+  {
+    return l.name.value == r.name.value && l.id.value == r.id.value && l.score.value == r.score.value &&
+           l.tags.value == r.tags.value && l.inner.value.i.value == r.inner.value.i.value && l.not_field == r.not_field;
+  }
+
+  std::vector<Record> make(int size)
+  {
+    std::vector<Record> result;
+    for (int i = 0; i < size; i++)
+    {
+      result.push_back(Record{.name = "r\"" + std::to_string(i), .id = i, .score = i * 0.25, .tags = std::vector<int>(static_cast<std::size_t>(i % 3), i), .inner = Inner{.i = -i}});
+    }
+    return result;
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(Columnar, Write)
+{
+  using namespace kie::serde_json;
+
+  EXPECT_EQ(to_json_columnar(make(2)), R"({"id":[0,1],"inner":[{"i":0},{"i":-1}],"name":["r\"0","r\"1"],"score":[0.0,0.25],"tags":[null,[1]]})");
+  EXPECT_EQ(to_json_columnar(make(0)), R"({"id":[],"inner":[],"name":[],"score":[],"tags":[]})");
+
+  const std::list<Inner> list{Inner{.i = 1}, Inner{.i = 2}};
+  EXPECT_EQ(to_json_columnar(list), R"({"i":[1,2]})");
+  const std::array<Inner, 1> array{Inner{.i = 3}};
+  std::string buffer = "x";
+  write_json_columnar(array, buffer, {.numbers = number_format::shortest});
+  EXPECT_EQ(buffer, R"(x{"i":[3]})");
+
+  // each key is written once.
+  const auto rows = make(100);
+  EXPECT_LT(to_json_columnar(rows).size(), to_json_string(rows).size() * 3 / 4);
+}
+
+// Demonstrate some basic assertions.
+TEST(Columnar, Read)
+{
+  using namespace kie::serde_json;
+
+  for (int size : {0, 1, 2, 100})
+  {
+    const auto expected = make(size);
+    EXPECT_EQ(from_json_columnar<std::vector<Record>>(to_json_columnar(expected)), expected) << size;
+  }
+
+  // the keys can be in any order, and the unknown ones are skipped.
+  const auto rows = from_json_columnar<std::vector<Record>>(R"( {"tags":[[9],[9,9]], "score":[1,2], "x":{"y":[1]}, "name":["a","b"],"id":[3,4],"inner":[{"i":5},{"i":6}],"tags":[[1],[]]} )");
+  ASSERT_EQ(rows.size(), 2u);
+  EXPECT_EQ(rows[1], (Record{.name = std::string{"b"}, .id = 4, .score = 2.0, .tags = std::vector<int>{}, .inner = Inner{.i = 6}}));
+  EXPECT_EQ(rows[0].tags.value, std::vector<int>{1});
+
+  // the rows are read over the existing ones, and the extra ones are removed.
+  auto target = make(10);
+  target[0].not_field = 1;
+  const std::string *first = &target[0].name.value;
+  from_json_columnar_into(target, to_json_columnar(make(3)), {.projection = true});
+  EXPECT_EQ(target, make(3));
+  EXPECT_EQ(&target[0].name.value, first);
+
+  std::pmr::monotonic_buffer_resource arena;
+  struct Pmr
+  {
+    Field<std::pmr::string, "s"> s;
+  };
+  auto pmr = from_json_columnar<std::pmr::vector<Pmr>>(R"({"s":["a very long string that is not in place"]})", {.resource = &arena});
+  EXPECT_EQ(pmr.get_allocator().resource(), &arena);
+  EXPECT_EQ(pmr[0].s.value.get_allocator().resource(), &arena);
+}
+
+// Demonstrate some basic assertions.
+TEST(Columnar, Error)
+{
+  using namespace kie::serde_json;
+
+  EXPECT_THROW(from_json_columnar<std::vector<Inner>>(R"([{"i":1}])"), nlohmann::json::type_error);
+  EXPECT_THROW(from_json_columnar<std::vector<Inner>>(R"({"i":[1,"2"]})"), nlohmann::json::type_error);
+  EXPECT_THROW(from_json_columnar<std::vector<Inner>>(R"({"i":[1,2})"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json_columnar<std::vector<Inner>>(R"({"i":[1]} 1)"), nlohmann::json::parse_error);
+  try
+  {
+    from_json_columnar<std::vector<Record>>(R"({"id":[1],"name":["a"],"score":[1],"tags":[null]})");
+    FAIL();
+  }
+  catch (const nlohmann::json::out_of_range &e)
+  {
+    EXPECT_EQ(std::string{e.what()}, "[json.exception.out_of_range.403] key 'inner' not found");
+  }
+
+  for (const char *broken : {R"({"id":[1,2],"name":["a"]})", R"({"id":[1],"name":["a","b"]})", R"({"id":[1],"name":null})"})
+  {
+    EXPECT_THROW(from_json_columnar<std::vector<Record>>(broken), nlohmann::json::other_error) << broken;
+  }
+  try
+  {
+    from_json_columnar<std::vector<Record>>(R"({"id":[1,2],"name":["a"]})");
+    FAIL();
+  }
+  catch (const nlohmann::json::other_error &e)
+  {
+    EXPECT_EQ(std::string{e.what()}, "[json.exception.other_error.502] column 'name' at byte 25 has a different length from the others");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+#include <serde_json/json.hpp>
+#include <iostream>
+#include <gtest/gtest.h>
+
+namespace
+{
+  using kie::serde::Field;
+  using kie::serde::TrackedField;
+
+  struct Player
+  {
+    TrackedField<std::string, "name"> name;
+    TrackedField<int, "score"> score;
+  };
+
+  struct Session
+  {
+    Field<std::string, "id"> id;
+    TrackedField<double, "clock"> clock;
+    Field<Player, "host"> host;
+    TrackedField<Player, "guest"> guest;
+    TrackedField<std::vector<int>, "moves"> moves;
+    TrackedField<bool, "a/b~c"> escaped;
+    int not_field;
+  };
+}
+
+// Demonstrate some basic assertions.
+TEST(Delta, MergePatch)
+{
+  using namespace kie::serde_json;
+
+  const std::string json_str = R"({"a/b~c":false,"clock":1.5,"guest":{"name":"g","score":2},"host":{"name":"h","score":1},"id":"s","moves":[1]})";
+  Session session = from_json<Session>(json_str);
+  EXPECT_EQ(to_json_string(session), json_str);
+
+  // nothing is dirty after reading.
+  EXPECT_FALSE(session.clock.dirty());
+  EXPECT_EQ(to_json_delta(session), "{}");
+
+  session.clock = 2.5;
+  session.moves.modify().push_back(2);
+  EXPECT_TRUE(session.clock.dirty());
+  EXPECT_EQ(to_json_delta(session), R"({"clock":2.5,"moves":[1,2]})");
+  EXPECT_FALSE(session.clock.dirty());
+  EXPECT_EQ(to_json_delta(session), "{}");
+
+  // the objects that hold a dirty TrackedField are written partly, and a dirty one as a whole.
+  session.host.value.score = 3;
+  session.guest.value.name = std::string{"x"};
+  EXPECT_EQ(to_json_delta(session), R"({"guest":{"name":"x"},"host":{"score":3}})");
+  session.guest = Player{.name = std::string{"y"}, .score = 4};
+  session.guest.value.score = 5;
+  EXPECT_EQ(to_json_delta(session), R"({"guest":{"name":"y","score":5}})");
+  EXPECT_FALSE(session.guest.value.score.dirty());
+
+  // the changes that are not made by assignment are not seen until marked.
+  session.moves.value.clear();
+  session.id = std::string{"t"};
+  EXPECT_EQ(to_json_delta(session), "{}");
+  session.moves.mark_dirty();
+  std::string buffer = "x";
+  write_json_delta(session, buffer, {.numbers = number_format::shortest});
+  EXPECT_EQ(buffer, R"(x{"moves":[]})");
+
+  // a copy keeps the flags.
+  session.escaped = true;
+  Session copy = session;
+  EXPECT_EQ(to_json_delta(session), R"({"a/b~c":true})");
+  EXPECT_EQ(to_json_delta(copy), R"({"a/b~c":true})");
+  EXPECT_EQ(to_json_string(copy), R"({"a/b~c":true,"clock":2.5,"guest":{"name":"y","score":5},"host":{"name":"h","score":3},"id":"t","moves":null})");
+  EXPECT_EQ(to_json(copy).dump(), to_json_string(copy));
+
+  // reading over it leaves the flags as they are.
+  copy.clock = 0.0;
+  from_json_into(copy, json_str);
+  EXPECT_EQ(to_json_delta(copy), R"({"clock":1.5})");
+  from_json_into(copy, json_str);
+  EXPECT_EQ(to_json_delta(copy), "{}");
+
+  // assigning a whole object marks everything in it.
+  copy.host = Player{};
+  EXPECT_EQ(to_json_delta(copy), R"({"host":{"name":"","score":0}})");
+}
+
+// Demonstrate some basic assertions.
+TEST(Delta, JsonPatch)
+{
+  using namespace kie::serde_json;
+
+  Session session{};
+  EXPECT_EQ(to_json_patch(session), "[]");
+
+  session.clock = 1.0;
+  session.host.value.name = std::string{"h\""};
+  session.guest.value.score = 7;
+  session.escaped = true;
+  EXPECT_EQ(to_json_patch(session),
+            R"([{"op":"replace","path":"/a~1b~0c","value":true},)"
+            R"({"op":"replace","path":"/clock","value":1.0},)"
+            R"({"op":"replace","path":"/guest/score","value":7},)"
+            R"({"op":"replace","path":"/host/name","value":"h\""}])");
+  EXPECT_EQ(to_json_patch(session), "[]");
+  EXPECT_EQ(to_json_delta(session), "{}");
+
+  // the patch applies to the last state.
+  nlohmann::json state = to_json(session);
+  session.guest = Player{.name = std::string{"p"}, .score = 1};
+  session.host.value.score = 2;
+  state = state.patch(nlohmann::json::parse(to_json_patch(session)));
+  EXPECT_EQ(state.dump(), to_json_string(session));
+
+  // and so does the merge patch.
+  state = to_json(session);
+  session.clock = 3.0;
+  session.guest.value.name = std::string{"q"};
+  state.merge_patch(nlohmann::json::parse(to_json_delta(session)));
+  EXPECT_EQ(state.dump(), to_json_string(session));
+}
+
+// Demonstrate some basic assertions.
+TEST(Delta, MergePatchRoundTrip)
+{
+  using namespace kie::serde_json;
+
+  struct Box
+  {
+    TrackedField<std::vector<int>, "v"> v;
+    TrackedField<std::optional<int>, "o"> o;
+  };
+
+  struct State
+  {
+    Field<int, "id"> id;
+    TrackedField<Box, "box"> box;
+    TrackedField<std::vector<int>, "moves"> moves;
+  };
+
+  State state{.id = 1, .box = Box{.v = std::vector{1}, .o = std::optional<int>{2}}, .moves = std::vector{1}};
+  to_json_delta(state);
+  nlohmann::json last = nlohmann::json::parse(to_json_string(state));
+
+  // an emptied container is written as [], since null would remove the key from the last state.
+  state.moves = std::vector<int>{};
+  state.box.value.v = std::vector<int>{};
+  EXPECT_EQ(to_json_delta(state), R"({"box":{"v":[]},"moves":[]})");
+  last.merge_patch(nlohmann::json::parse(R"({"box":{"v":[]},"moves":[]})"));
+  State read = from_json<State>(last.dump());
+  EXPECT_EQ(to_json_string(read), to_json_string(state));
+  EXPECT_EQ(try_from_json<State>(last.dump())->moves.value.size(), 0u);
+
+  // and so is one inside a whole object, while std::nullopt removes the key.
+  state.box = Box{.v = std::vector<int>{}, .o = std::optional<int>{}};
+  const std::string delta = to_json_delta(state);
+  EXPECT_EQ(delta, R"({"box":{"o":null,"v":[]}})");
+  last.merge_patch(nlohmann::json::parse(delta));
+  EXPECT_FALSE(last["box"].contains("o"));
+  read = from_json<State>(last.dump());
+  EXPECT_FALSE(read.box.value.o.value.has_value());
+  EXPECT_EQ(to_json_string(read), to_json_string(state));
+  EXPECT_EQ(to_json_string(try_from_json<State>(last.dump()).value()), to_json_string(state));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
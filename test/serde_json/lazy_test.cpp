@@ -0,0 +1,134 @@
+#include <serde_json/json.hpp>
+#include <iostream>
+#include <gtest/gtest.h>
+
+namespace
+{
+  using kie::serde::Field;
+  using kie::serde::Lazy;
+
+  struct Payload
+  {
+    Field<int, "i"> i;
+    Field<std::vector<std::string>, "names"> names;
+  };
+
+  struct Message
+  {
+    Field<std::string, "route"> route;
+    Field<Lazy<Payload>, "payload"> payload;
+    Field<Lazy<std::vector<int>>, "numbers"> numbers;
+  };
+
+  bool operator==(const Payload &l, const Payload &r)
+  {
+    return l.i.value == r.i.value && l.names.value == r.names.value;
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(Lazy, ReadAndWrite)
+{
+  using namespace kie::serde_json;
+
+  const std::string json_str = R"({"numbers":[1, 2,3],"payload":{ "names" : ["x","y\n"], "unknown":{"deep":[1,2]}, "i":7 },"route":"a.b"})";
+  Message message = from_json<Message>(json_str);
+  EXPECT_EQ(message.route.value, "a.b");
+  EXPECT_FALSE(message.payload.value.parsed());
+  EXPECT_EQ(message.payload.value.raw(), R"({ "names" : ["x","y\n"], "unknown":{"deep":[1,2]}, "i":7 })");
+
+  // the untouched values are written back as they are.
+  EXPECT_EQ(to_json_string(message), json_str);
+
+  // the first access parses, and reading doesn't drop the raw text.
+  const Message &view = message;
+  EXPECT_EQ(view.payload.value->i.value, 7);
+  EXPECT_TRUE(message.payload.value.parsed());
+  EXPECT_EQ(*view.payload.value, (Payload{.i = 7, .names = std::vector<std::string>{"x", "y\n"}}));
+  EXPECT_EQ(to_json_string(message), json_str);
+  const int i = message.payload.value->i.value;
+  const Payload &payload = *message.payload.value;
+  EXPECT_EQ(payload.i.value, i);
+  EXPECT_TRUE(message.payload.value.has_raw());
+  EXPECT_EQ(to_json_string(message), json_str);
+
+  // the modified value is written instead.
+  message.payload.value.modify().i = 8;
+  EXPECT_FALSE(message.payload.value.has_raw());
+  EXPECT_EQ(to_json_string(message), R"({"numbers":[1, 2,3],"payload":{"i":8,"names":["x","y\n"]},"route":"a.b"})");
+  message.numbers.value = std::vector<int>{4};
+  EXPECT_EQ(to_json_string(message), R"({"numbers":[4],"payload":{"i":8,"names":["x","y\n"]},"route":"a.b"})");
+  EXPECT_EQ(to_json(message).dump(), to_json_string(message));
+
+  // a copy keeps the state.
+  Message copy = from_json<Message>(json_str);
+  const Message other = copy;
+  EXPECT_EQ(other.payload.value->names.value.size(), 2u);
+  EXPECT_FALSE(copy.payload.value.parsed());
+  EXPECT_EQ(to_json_string(other), json_str);
+
+  // the DOM keeps the members that are not known as well.
+  EXPECT_EQ(to_json(copy)["payload"]["unknown"]["deep"][1], 2);
+
+  // from the DOM, the value is built at once.
+  Message dom = impl::from_json<Message>(nlohmann::json::parse(json_str));
+  EXPECT_TRUE(dom.payload.value.parsed());
+  EXPECT_EQ(dom.payload.value->i.value, 7);
+
+  // reading into the same message reuses the raw text.
+  from_json_into(copy, R"({"route":"c","payload":{"i":1,"names":[]},"numbers":null})");
+  EXPECT_EQ(copy.payload.value->i.value, 1);
+  EXPECT_TRUE(copy.numbers.value->empty());
+}
+
+// Demonstrate some basic assertions.
+TEST(Lazy, Projection)
+{
+  using namespace kie::serde_json;
+
+  // the raw text is written back as it is, so it's fully checked even under projection.
+  EXPECT_THROW(from_json<Message>(R"({"numbers":[1],"payload":{"i":1,"names":[],"x":tru},"route":""})", {.projection = true}), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Message>(R"({"numbers":[1],"payload":{"i":1,"names":[],"x":[}},"route":""})", {.projection = true}), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Message>("{\"numbers\":[1],\"payload\":{\"i\":1,\"names\":[\"\xff\"]},\"route\":\"\"}", {.projection = true}), nlohmann::json::parse_error);
+
+  // the values that are not modeled are still only skipped by their structure.
+  const std::string json_str = R"({"numbers":[1],"payload":{"i":1,"names":[]},"route":"","x":tru})";
+  Message message = from_json<Message>(json_str, {.projection = true});
+  EXPECT_EQ(message.payload.value.raw(), R"({"i":1,"names":[]})");
+  EXPECT_EQ(to_json_string(message), R"({"numbers":[1],"payload":{"i":1,"names":[]},"route":""})");
+  EXPECT_EQ(message.numbers.value->size(), 1u);
+}
+
+// Demonstrate some basic assertions.
+TEST(Lazy, Error)
+{
+  using namespace kie::serde_json;
+
+  // the syntax is still checked when reading.
+  EXPECT_THROW(from_json<Message>(R"({"route":"","payload":{"i":1,},"numbers":[]})"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Message>(R"({"route":"","payload":{"i":1})"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Message>(R"({"route":"","numbers":[]})"), nlohmann::json::out_of_range);
+
+  // but the types are checked on first access.
+  Message message = from_json<Message>(R"({"route":"","payload":{"i":"1","names":[]},"numbers":[]})");
+  EXPECT_THROW(message.payload.value.get(), nlohmann::json::type_error);
+  EXPECT_FALSE(message.payload.value.parsed());
+  EXPECT_THROW(message.payload.value.get(), nlohmann::json::type_error);
+
+  message = from_json<Message>(R"({"route":"","payload":{"names":[]},"numbers":[]})");
+  try
+  {
+    message.payload.value.get();
+    FAIL();
+  }
+  catch (const nlohmann::json::out_of_range &e)
+  {
+    EXPECT_EQ(std::string{e.what()}, "[json.exception.out_of_range.403] key 'i' not found");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,197 @@
+#include <serde_json/json.hpp>
+#include <serde_json/parallel.hpp>
+#include <context/context.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <future>
+#include <iostream>
+#include <gtest/gtest.h>
+
+namespace
+{
+  struct Inner
+  {
+    kie::serde::Field<int, "i"> i;
+    kie::serde::Field<std::vector<int>, "v"> v;
+  };
+
+  struct A
+  {
+    kie::serde::Field<std::string, "s"> s;
+    kie::serde::Field<double, "d"> d;
+    kie::serde::Field<Inner, "inner"> inner;
+    kie::serde::Field<std::vector<Inner>, "inner_vec"> inner_vec;
+  };
+
+  bool operator==(const Inner &l, const Inner &r)
+  {
+    return l.i.value == r.i.value && l.v.value == r.v.value;
+  }
+
+  bool operator==(const A &l, const A &r)
+  {
+    return l.s.value == r.s.value && l.d.value == r.d.value && l.inner.value == r.inner.value && l.inner_vec.value == r.inner_vec.value;
+  }
+
+  std::vector<A> make(int size)
+  {
+    std::vector<A> result;
+    for (int i = 0; i < size; i++)
+    {
+      A a{.s = "item [" + std::to_string(i) + "], {\"quoted\\\"}", .d = i * 0.5};
+      a.inner = Inner{.i = i, .v = std::vector<int>(static_cast<std::size_t>(i % 5), i)};
+      a.inner_vec = std::vector<Inner>(static_cast<std::size_t>(i % 3), a.inner.value);
+      result.push_back(a);
+    }
+    return result;
+  }
+
+  // The message of the exception thrown by f, or empty if nothing is thrown.
+  template <typename F>
+  std::string what_of(F &&f)
+  {
+    try
+    {
+      f();
+    }
+    catch (const std::exception &e)
+    {
+      return e.what();
+    }
+    return "";
+  }
+
+  const kie::serde_json::parallel_options small_chunks{.concurrency = 4, .chunk_size = 256};
+}
+
+// Demonstrate some basic assertions.
+TEST(ParallelJson, SameAsSequential)
+{
+  using namespace kie::serde_json;
+
+  boost::asio::thread_pool pool{4};
+  for (int size : {0, 1, 2, 10, 1000, 20000})
+  {
+    const auto expected = make(size);
+    const std::string json_str = to_json_string(expected);
+    EXPECT_EQ(from_json_parallel<std::vector<A>>(json_str, pool, small_chunks), expected) << size;
+    EXPECT_EQ(from_json_parallel<std::vector<A>>(json_str, pool), expected) << size;
+  }
+
+  // whitespace around the items and the brackets, and values that are not objects.
+  const std::string spaced = " \n[ 1 ,2,\t3 , 4 , 5 , 6 , 7 , 8 , 9 , 10 ] \n";
+  EXPECT_EQ(from_json_parallel<std::vector<int>>(spaced, pool, {.concurrency = 2, .chunk_size = 1}), from_json<std::vector<int>>(spaced));
+  EXPECT_EQ(from_json_parallel<std::vector<std::string>>(R"(["a,]","b\\","c\"]",""])", pool, {.concurrency = 2, .chunk_size = 1}),
+            (std::vector<std::string>{"a,]", "b\\", "c\"]", ""}));
+  EXPECT_TRUE(from_json_parallel<std::vector<int>>("{\"a\":[1,2]}", pool, small_chunks).empty());
+  EXPECT_TRUE(from_json_parallel<std::vector<int>>(" [ ] ", pool, small_chunks).empty());
+  pool.join();
+}
+
+// Demonstrate some basic assertions.
+TEST(ParallelJson, Context)
+{
+  using namespace kie::serde_json;
+
+  const auto expected = make(5000);
+  const std::string json_str = to_json_string(expected);
+
+  // the caller does all the work if the context is not running yet.
+  kie::context idle{2};
+  EXPECT_EQ(from_json_parallel<std::vector<A>>(json_str, idle, small_chunks), expected);
+
+  kie::context ctx{3};
+  ctx.run_as_daemon();
+  EXPECT_EQ(from_json_parallel<std::vector<A>>(json_str, ctx, small_chunks), expected);
+  EXPECT_EQ(from_json_parallel<std::vector<A>>(json_str, ctx, {.chunk_size = 1024}), expected);
+
+  // it's fine to call it on a thread of the context.
+  std::promise<std::vector<A>> result;
+  boost::asio::post(ctx.get_one(), [&]
+                    { result.set_value(from_json_parallel<std::vector<A>>(json_str, ctx, small_chunks)); });
+  EXPECT_EQ(result.get_future().get(), expected);
+  ctx.stop();
+  idle.stop();
+}
+
+// Demonstrate some basic assertions.
+TEST(ParallelJson, Error)
+{
+  using namespace kie::serde_json;
+
+  boost::asio::thread_pool pool{4};
+  const std::string json_str = to_json_string(make(2000));
+  const std::size_t middle = json_str.find("{\"d\"", json_str.size() / 2);
+
+  std::vector<std::string> broken{
+      json_str.substr(0, json_str.size() - 1),
+      json_str.substr(0, json_str.size() - 1) + "}",
+      json_str + " x",
+      json_str.substr(0, middle) + "," + json_str.substr(middle),
+      json_str.substr(0, middle) + "{\"s\":1}," + json_str.substr(middle),
+      json_str.substr(0, middle) + "{\"s\":\"\",\"d\":1,\"inner\":{\"i\":1,\"v\":[]}}," + json_str.substr(middle),
+      json_str.substr(0, middle) + "\"\\q\"," + json_str.substr(middle),
+      json_str.substr(0, middle) + "1 2," + json_str.substr(middle),
+      json_str.substr(0, middle) + "[}," + json_str.substr(middle),
+      json_str.substr(0, middle - 1) + json_str.substr(middle),
+  };
+  // two errors, the first one is reported.
+  broken.push_back(json_str.substr(0, middle) + "null," + json_str.substr(middle, 1000) + "," + json_str.substr(middle));
+  // a Field of wrong type in the first chunk, but the syntax error in the last one is reported like the DOM does.
+  broken.push_back("[{\"s\":1}," + json_str.substr(1) + " x");
+  for (std::size_t i = 0; i < broken.size(); i++)
+  {
+    const std::string expected = what_of([&]
+                                         { from_json<std::vector<A>>(broken[i]); });
+    EXPECT_FALSE(expected.empty()) << i;
+    EXPECT_EQ(what_of([&]
+                      { from_json_parallel<std::vector<A>>(broken[i], pool, small_chunks); }),
+              expected)
+        << i;
+  }
+  pool.join();
+}
+
+// Demonstrate some basic assertions.
+TEST(ParallelJson, Write)
+{
+  using namespace kie::serde_json;
+
+  boost::asio::thread_pool pool{4};
+  for (int size : {0, 1, 2, 10, 1000, 20000})
+  {
+    const auto value = make(size);
+    const std::string expected = to_json_string(value);
+    EXPECT_EQ(to_json_string(value, pool, small_chunks), expected) << size;
+    EXPECT_EQ(to_json_string(value, pool), expected) << size;
+
+    const auto buffers = to_json_buffers(value, pool, small_chunks);
+    std::string joined;
+    for (const auto &buffer : buffers)
+    {
+      EXPECT_FALSE(buffer.empty());
+      joined += buffer;
+    }
+    EXPECT_EQ(joined, expected) << size;
+    EXPECT_EQ(buffers.size() > 1, size >= 10) << size;
+  }
+
+  const std::vector<double> numbers(10000, 0.1);
+  EXPECT_EQ(to_json_string(numbers, pool, small_chunks, {.numbers = number_format::shortest}), to_json_string(numbers, {.numbers = number_format::shortest}));
+  const std::vector<bool> flags(10000, true);
+  EXPECT_EQ(to_json_string(flags, pool, small_chunks), to_json_string(flags));
+  const std::array<int, 3> array{1, 2, 3};
+  EXPECT_EQ(to_json_string(array, pool, {.concurrency = 2, .chunk_size = 1}), "[1,2,3]");
+
+  kie::context ctx{3};
+  ctx.run_as_daemon();
+  const auto value = make(5000);
+  EXPECT_EQ(to_json_string(value, ctx, small_chunks), to_json_string(value));
+  ctx.stop();
+  pool.join();
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,520 @@
+#include <serde_json/json.hpp>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <gtest/gtest.h>
+
+namespace
+{
+  struct Inner
+  {
+    kie::serde::Field<int, "i"> i;
+    kie::serde::Field<std::vector<int>, "v"> v;
+  };
+
+  struct A
+  {
+    kie::serde::Field<std::string, "s"> s;
+    kie::serde::Field<double, "d"> d;
+    kie::serde::Field<bool, "b"> b;
+    kie::serde::Field<Inner, "inner"> inner;
+    kie::serde::Field<std::vector<Inner>, "inner_vec"> inner_vec;
+    kie::serde::Field<std::vector<std::string>, "strings"> strings;
+  };
+
+  bool operator==(const Inner &l, const Inner &r)
+  {
+    return l.i.value == r.i.value && l.v.value == r.v.value;
+  }
+
+  bool operator==(const A &l, const A &r)
+  {
+    return l.s.value == r.s.value && l.d.value == r.d.value && l.b.value == r.b.value && l.inner.value == r.inner.value &&
+           l.inner_vec.value == r.inner_vec.value && l.strings.value == r.strings.value;
+  }
+
+  template <typename T>
+  T from_dom(std::string_view json_str)
+  {
+    return kie::serde_json::impl::from_json<T>(nlohmann::json::parse(json_str));
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, SameAsDom)
+{
+  using namespace kie::serde_json;
+
+  for (std::string_view json_str : {
+           R"({"s":"hello","d":1.5,"b":true,"inner":{"i":1,"v":[1,2]},"inner_vec":[{"i":2,"v":null}],"strings":["a","b"]})",
+           R"( { "strings" : [ ] , "inner_vec" : null , "inner" : { "v" : 1 , "i" : -3 } , "b" : false , "d" : 1e3 , "s" : "" } )",
+           R"({"s":"\"\\\/\b\f\n\r\t\u0041\u00e9\u4e2d\ud83d\ude00","d":-0.0,"b":true,"inner":{"i":1,"v":[]},"inner_vec":[],"strings":"x"})",
+           R"({"unknown":{"a":[1,{"b":"}"}],"c":null},"s":"中文","d":123456789012,"b":true,"inner":{"i":true,"v":[1]},"inner_vec":{},"strings":[""]})",
+           R"({"s":"first","s":"last","d":1,"b":false,"inner":{"i":1.9,"v":[1]},"inner_vec":[],"strings":[]})",
+       })
+  {
+    EXPECT_EQ(from_json<A>(json_str), from_dom<A>(json_str)) << json_str;
+  }
+
+  EXPECT_EQ(from_json<std::vector<A>>("[]"), from_dom<std::vector<A>>("[]"));
+  EXPECT_EQ(from_json<std::vector<std::uint64_t>>("[18446744073709551615, 0]"), (std::vector<std::uint64_t>{18446744073709551615ull, 0}));
+  EXPECT_EQ(from_json<std::vector<std::int64_t>>("[-9223372036854775808]"), (std::vector<std::int64_t>{-9223372036854775807ll - 1}));
+  EXPECT_EQ(from_json<std::vector<double>>("[1.7976931348623157e308, 5e-324, 1e-400]"), from_dom<std::vector<double>>("[1.7976931348623157e308, 5e-324, 1e-400]"));
+  EXPECT_THROW(from_json<std::vector<double>>("[1e400]"), nlohmann::json::out_of_range);
+  // the numbers out of range overflow or underflow by their magnitude, whatever the locale is.
+  for (std::string_view out_of_range : {"[-1e400]", "[10000e305]", "[0.001e312]", "[123.4e99999999999999999999]", "[-0.1e310]"})
+  {
+    EXPECT_THROW(from_json<std::vector<double>>(out_of_range), nlohmann::json::out_of_range) << out_of_range;
+  }
+  for (std::string_view tiny : {"[-1e-400]", "[123456e-330]", "[0.0001e-321]", "[1000.5e-99999999999999999999]", "[0.00000e1, -0.0e999999]"})
+  {
+    const auto values = from_json<std::vector<double>>(tiny);
+    const auto dom = from_dom<std::vector<double>>(tiny);
+    ASSERT_EQ(values.size(), dom.size()) << tiny;
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+      EXPECT_EQ(values[i], dom[i]) << tiny;
+      EXPECT_EQ(std::signbit(values[i]), std::signbit(dom[i])) << tiny;
+    }
+  }
+  EXPECT_EQ(from_json<std::vector<bool>>("[true,false]"), (std::vector<bool>{true, false}));
+  EXPECT_EQ(from_json<std::vector<std::vector<int>>>("[[1],null,[2,3]]"), (std::vector<std::vector<int>>{{1}, {}, {2, 3}}));
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, DuplicatedTag)
+{
+  using namespace kie::serde_json;
+
+  // every Field of the same tag gets the value of the key, just like from the DOM.
+  struct A
+  {
+    kie::serde::Field<int, "a"> a;
+    kie::serde::Field<double, "a"> a2;
+    kie::serde::OptionalField<std::vector<int>, "b"> b = std::vector<int>{1};
+    kie::serde::Field<std::vector<int>, "b"> b2;
+    int not_a_field = 7;
+  };
+  for (std::string_view json_str : {R"({"a":5,"b":[2,3]})", R"({"b":null,"a" : 1.5 })"})
+  {
+    const A a = from_json<A>(json_str);
+    const A dom = from_dom<A>(json_str);
+    EXPECT_EQ(a.a.value, dom.a.value) << json_str;
+    EXPECT_EQ(a.a2.value, dom.a2.value) << json_str;
+    EXPECT_EQ(a.b.value, dom.b.value) << json_str;
+    EXPECT_EQ(a.b2.value, dom.b2.value) << json_str;
+  }
+  EXPECT_EQ(from_json<A>(R"({"a":5,"b":[]})").a.value, 5);
+  EXPECT_EQ(from_json<A>(R"({"a":5,"b":[]})").a2.value, 5.0);
+
+  // the key is required if any of the Fields is.
+  EXPECT_THROW(from_json<A>(R"({"a":5})"), nlohmann::json::out_of_range);
+  EXPECT_THROW(from_json<A>(R"({"a":"x","b":[]})"), nlohmann::json::type_error);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, RoundTrip)
+{
+  using namespace kie::serde_json;
+
+  A a{.s = std::string{"a \"quoted\" \x01 string"}, .d = 0.1, .b = true, .inner = Inner{.i = 1, .v = std::vector{1, 2, 3}}};
+  a.inner_vec = std::vector<Inner>(3, a.inner.value);
+  a.strings = std::vector<std::string>{"x", "y\n"};
+  EXPECT_EQ(from_json<A>(to_json_string(a)), a);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, Error)
+{
+  using namespace kie::serde_json;
+
+  struct B
+  {
+    kie::serde::Field<int, "i"> i;
+    kie::serde::Field<Inner, "inner"> inner;
+  };
+
+  EXPECT_THROW(from_json<B>(""), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":01}"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,\"inner\":{\"i\":1,\"v\":[]}} x"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,\"inner\":{\"i\":1,\"v\":[]},\"x\":\"\\q\"}"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,\"inner\":{\"i\":1,\"v\":[]},\"x\":\"\xFF\"}"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,\"inner\":{\"i\":1,\"v\":[]},\"x\":\"\\ud800\"}"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,\"inner\":{\"i\":1,\"v\":[]},\"x\":[1,}"), nlohmann::json::parse_error);
+
+  EXPECT_THROW(from_json<B>("{\"i\":\"1\",\"inner\":{\"i\":1,\"v\":[]}}"), nlohmann::json::type_error);
+  EXPECT_THROW(from_json<B>("{\"i\":1,\"inner\":null}"), nlohmann::json::type_error);
+  EXPECT_THROW(from_json<B>("null"), nlohmann::json::type_error);
+
+  // the syntax error is reported even if a Field of wrong type or a missing one comes first, like the DOM does.
+  for (std::string_view json_str : {
+           "{\"i\":\"x\",\"inner\":{\"i\":1,\"v\":[]},\"x\":\"\\q\"}",
+           "{\"i\":1,\"inner\":{\"v\":[]},\"x\":[1,}",
+           "{\"i\":1,\"inner\":null} x",
+           "{\"inner\":{\"i\":1,\"v\":[]}",
+       })
+  {
+    EXPECT_THROW(from_dom<B>(json_str), nlohmann::json::parse_error) << json_str;
+    EXPECT_THROW(from_json<B>(json_str), nlohmann::json::parse_error) << json_str;
+  }
+  EXPECT_THROW(from_json<B>("{\"i\":\"x\",\"inner\":{\"i\":1,\"v\":[]},\"x\":1e999}"), nlohmann::json::out_of_range);
+  EXPECT_THROW(from_json<std::vector<B>>("[{\"i\":\"x\"},{\"i\":1,]"), nlohmann::json::parse_error);
+
+  // every value of a duplicated key is read, so the one of wrong type fails even if it's not the last one.
+  EXPECT_EQ(from_json<B>("{\"i\":1,\"inner\":{\"i\":1,\"v\":[]},\"i\":2}").i.value, 2);
+  EXPECT_EQ(from_dom<B>("{\"i\":\"x\",\"inner\":{\"i\":1,\"v\":[]},\"i\":2}").i.value, 2);
+  EXPECT_THROW(from_json<B>("{\"i\":\"x\",\"inner\":{\"i\":1,\"v\":[]},\"i\":2}"), nlohmann::json::type_error);
+
+  try
+  {
+    from_json<B>("{\"i\":1,\"inner\":{\"v\":[]}}");
+    FAIL();
+  }
+  catch (const nlohmann::json::out_of_range &e)
+  {
+    EXPECT_EQ(std::string{e.what()}, "[json.exception.out_of_range.403] key 'i' not found");
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, TryFromJson)
+{
+  using namespace kie::serde_json;
+
+  const auto ok = try_from_json<A>(R"({"s":"x","d":1,"b":true,"inner":{"i":1,"v":[2]},"inner_vec":null,"strings":["y"]})");
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(ok->s.value, "x");
+  EXPECT_EQ((*ok).inner.value.v.value, std::vector<int>{2});
+  EXPECT_EQ(ok.error().code, read_errc::none);
+
+  // the error, and the path to where it happens.
+  auto expect_error = [](std::string_view json_str, read_errc code, std::string_view path)
+  {
+    const auto result = try_from_json<A>(json_str);
+    EXPECT_FALSE(result.has_value()) << json_str;
+    EXPECT_EQ(result.error().code, code) << json_str;
+    EXPECT_EQ(result.path(), path) << json_str;
+
+    // the value throws what from_json throws.
+    std::string expected;
+    try
+    {
+      from_json<A>(json_str);
+    }
+    catch (const std::exception &e)
+    {
+      expected = e.what();
+    }
+    try
+    {
+      result.value();
+      FAIL() << json_str;
+    }
+    catch (const std::exception &e)
+    {
+      EXPECT_EQ(e.what(), expected) << json_str;
+    }
+  };
+  const std::string valid_rest = R"("d":1,"b":true,"inner_vec":[],"strings":[])";
+  expect_error("", read_errc::unexpected_end, "");
+  expect_error("[]", read_errc::type_mismatch, "");
+  expect_error(R"({"s":1,)" + valid_rest + "}", read_errc::type_mismatch, "/s");
+  expect_error(R"({"s":"","inner":{"i":1,"v":[1,"2"]},)" + valid_rest + "}", read_errc::type_mismatch, "/inner/v/1");
+  expect_error(R"({"s":"","inner":{"v":[]},)" + valid_rest + "}", read_errc::missing_field, "/inner/i");
+  expect_error(R"({"s":"","inner":{"i":1,"v":[]},"d":1,"b":true,"inner_vec":[{"i":1,"v":[]},{"i":1e999,"v":[]}],"strings":[]})", read_errc::number_overflow, "/inner_vec/1/i");
+  expect_error(R"({"s":"","inner":{"i":1,"v":[]},"d":1,"b":true,"inner_vec":[],"strings":["\q"]})", read_errc::invalid_string, "/strings/0");
+  expect_error(R"({"s":"","inner":{"i":1,"v":[]},)" + valid_rest + "} x", read_errc::syntax_error, "");
+  expect_error(R"({"s":1,)" + valid_rest + "} x", read_errc::syntax_error, "");
+
+  // the keys in the path are escaped as JSON Pointer.
+  struct Escaped
+  {
+    kie::serde::Field<std::array<int, 2>, "a/b~c"> a;
+  };
+  const auto escaped = try_from_json<Escaped>(R"({"a/b~c":[1,"x"]})");
+  EXPECT_EQ(escaped.path(), "/a~1b~0c/1");
+
+  const auto container = try_from_json<std::vector<Inner>>(R"([{"i":1,"v":[]},{"i":1}])");
+  EXPECT_EQ(container.error().code, read_errc::missing_field);
+  EXPECT_EQ(container.error().key, "v");
+  EXPECT_EQ(container.path(), "/1/v");
+  EXPECT_EQ(try_from_json<std::vector<Inner>>(R"([{"i":1,"v":[]}])").value().size(), 1u);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, Optional)
+{
+  using namespace kie::serde_json;
+
+  struct Config
+  {
+    kie::serde::Field<std::string, "host"> host;
+    kie::serde::OptionalField<int, "port"> port = 8080;
+    kie::serde::OptionalField<std::vector<int>, "ids"> ids = std::vector<int>{1};
+    kie::serde::Field<std::optional<int>, "timeout"> timeout;
+    kie::serde::Field<std::optional<Inner>, "inner"> inner;
+  };
+
+  // a missing key is not an error, and keeps the default value.
+  Config config = from_json<Config>(R"({"host":"h"})");
+  EXPECT_EQ(config.port.value, 8080);
+  EXPECT_EQ(config.ids.value, std::vector<int>{1});
+  EXPECT_FALSE(config.timeout.value.has_value());
+  EXPECT_FALSE(config.inner.value.has_value());
+  EXPECT_TRUE(try_from_json<Config>(R"({"host":"h"})"));
+  EXPECT_EQ(try_from_json<Config>(R"({"port":1})").path(), "/host");
+
+  config = from_json<Config>(R"({"host":"h","port":1,"ids":[],"timeout":3,"inner":{"i":1,"v":[2]}})");
+  EXPECT_EQ(config.port.value, 1);
+  EXPECT_TRUE(config.ids.value.empty());
+  EXPECT_EQ(config.timeout.value, 3);
+  EXPECT_EQ(config.inner.value->v.value, std::vector<int>{2});
+  EXPECT_EQ(to_json_string(config), R"({"host":"h","ids":null,"inner":{"i":1,"v":[2]},"port":1,"timeout":3})");
+  EXPECT_EQ(to_json(config).dump(), to_json_string(config));
+
+  // null is std::nullopt, and the value of another type is still an error.
+  config = from_json<Config>(R"({"host":"h","timeout":null,"inner":null})");
+  EXPECT_FALSE(config.timeout.value.has_value());
+  EXPECT_EQ(to_json_string(config), R"({"host":"h","ids":[1],"inner":null,"port":8080,"timeout":null})");
+  EXPECT_EQ(to_json(config).dump(), to_json_string(config));
+  EXPECT_EQ(try_from_json<Config>(R"({"host":"h","timeout":"1"})").path(), "/timeout");
+  EXPECT_EQ(try_from_json<Config>(R"({"host":"h","inner":{"i":1}})").path(), "/inner/v");
+
+  // reading in place gives the missing ones their default value again.
+  Config target = from_json<Config>(R"({"host":"h","port":1,"ids":[5,6],"timeout":3,"inner":{"i":1,"v":[2]}})");
+  from_json_into(target, R"({"host":"x"})");
+  EXPECT_EQ(to_json_string(target), to_json_string(from_json<Config>(R"({"host":"x"})")));
+
+  // the same from the DOM.
+  const Config dom = from_dom<Config>(R"({"host":"h","timeout":null,"inner":{"i":1,"v":[2]}})");
+  EXPECT_EQ(dom.port.value, 8080);
+  EXPECT_FALSE(dom.timeout.value.has_value());
+  EXPECT_EQ(dom.inner.value->i.value, 1);
+
+  // and in columns.
+  const auto rows = from_json_columnar<std::vector<Config>>(R"({"host":["a","b"],"port":[1,2]})");
+  ASSERT_EQ(rows.size(), 2u);
+  EXPECT_EQ(rows[1].port.value, 2);
+  EXPECT_EQ(rows[1].ids.value, std::vector<int>{1});
+  EXPECT_TRUE(from_json_columnar<std::vector<Config>>(R"({"host":[]})").empty());
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, DeepNesting)
+{
+  using namespace kie::serde_json;
+
+  struct B
+  {
+    kie::serde::Field<int, "i"> i;
+  };
+
+  std::string deep = "{\"skipped\":" + std::string(1000, '[') + std::string(1000, ']') + ",\"i\":1}";
+  EXPECT_EQ(from_json<B>(deep).i.value, 1);
+  std::string broken = "{\"skipped\":" + std::string(1000, '[') + std::string(999, ']') + ",\"i\":1}";
+  EXPECT_THROW(from_json<B>(broken), nlohmann::json::parse_error);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, MemoryResource)
+{
+  using namespace kie::serde_json;
+
+  struct Item
+  {
+    kie::serde::Field<std::pmr::string, "name"> name;
+    kie::serde::Field<std::pmr::vector<std::pmr::string>, "tags"> tags;
+  };
+
+  struct Request
+  {
+    kie::serde::Field<std::pmr::string, "id"> id;
+    kie::serde::Field<std::pmr::vector<Item>, "items"> items;
+    kie::serde::Field<std::array<std::pmr::string, 2>, "pair"> pair;
+    kie::serde::Field<int, "n"> n;
+  };
+
+  const std::string json_str = R"({"id":"a long id that does not fit in the small buffer","items":[{"name":"first item with a long name","tags":["x","a long tag that does not fit either"]},{"name":"","tags":null}],"pair":["a long string in the array of strings","b"],"n":1})";
+
+  // nothing is allocated from the default resource, so all the strings and vectors live in the arena.
+  std::pmr::monotonic_buffer_resource arena;
+  std::pmr::memory_resource *previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  std::optional<Request> result;
+  EXPECT_NO_THROW(result.emplace(from_json<Request>(json_str, &arena)));
+  std::pmr::set_default_resource(previous);
+  ASSERT_TRUE(result.has_value());
+  Request &request = *result;
+
+  EXPECT_EQ(request.id.value, "a long id that does not fit in the small buffer");
+  EXPECT_EQ(request.id.value.get_allocator().resource(), &arena);
+  ASSERT_EQ(request.items.value.size(), 2u);
+  EXPECT_EQ(request.items.value.get_allocator().resource(), &arena);
+  EXPECT_EQ(request.items.value[0].name.value, "first item with a long name");
+  EXPECT_EQ(request.items.value[0].name.value.get_allocator().resource(), &arena);
+  EXPECT_EQ(request.items.value[0].tags.value[1], "a long tag that does not fit either");
+  EXPECT_EQ(request.items.value[0].tags.value[1].get_allocator().resource(), &arena);
+  EXPECT_TRUE(request.items.value[1].tags.value.empty());
+  EXPECT_EQ(request.pair.value[0].get_allocator().resource(), &arena);
+  EXPECT_EQ(request.n.value, 1);
+
+  auto items = from_json<std::pmr::vector<Item>>(to_json_string(request.items.value), &arena);
+  EXPECT_EQ(items.get_allocator().resource(), &arena);
+  ASSERT_EQ(items.size(), 2u);
+  EXPECT_EQ(items[0].tags.value[0].get_allocator().resource(), &arena);
+
+  // without a resource, the default one is used as before.
+  EXPECT_EQ(from_json<Request>(json_str).id.value.get_allocator().resource(), std::pmr::get_default_resource());
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, StringView)
+{
+  using namespace kie::serde_json;
+
+  struct Message
+  {
+    kie::serde::Field<std::string_view, "name"> name;
+    kie::serde::Field<std::vector<std::string_view>, "tags"> tags;
+  };
+
+  const std::string plain = R"({"name":"中文 name","tags":["a","",  "c"]})";
+  Message message = from_json<Message>(plain);
+  EXPECT_EQ(message.name.value, "中文 name");
+  EXPECT_EQ(message.tags.value, (std::vector<std::string_view>{"a", "", "c"}));
+  // the views point into the input.
+  EXPECT_EQ(message.name.value.data(), plain.data() + plain.find("中文"));
+  EXPECT_EQ(message.tags.value[2].data(), plain.data() + plain.rfind('c'));
+  EXPECT_EQ(to_json_string(message), to_json(message).dump());
+
+  const std::string escaped = R"({"name":"a\"b\u00e9","tags":["x\ny","z"]})";
+  try
+  {
+    from_json<Message>(escaped);
+    FAIL();
+  }
+  catch (const nlohmann::json::other_error &e)
+  {
+    EXPECT_EQ(std::string{e.what()}, "[json.exception.other_error.501] string with escapes at byte 9 can't be read as string_view without a memory resource");
+  }
+
+  std::pmr::monotonic_buffer_resource arena;
+  message = from_json<Message>(escaped, &arena);
+  EXPECT_EQ(message.name.value, "a\"bé");
+  EXPECT_EQ(message.tags.value, (std::vector<std::string_view>{"x\ny", "z"}));
+  EXPECT_EQ(message.tags.value[1].data(), escaped.data() + escaped.rfind('z'));
+
+  // the errors in the strings are still reported as parse errors.
+  EXPECT_THROW(from_json<Message>(R"({"name":"\q","tags":[]})", &arena), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Message>("{\"name\":\"\xFF\",\"tags\":[]}"), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Message>(R"({"name":1,"tags":[]})"), nlohmann::json::type_error);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, Into)
+{
+  using namespace kie::serde_json;
+
+  struct B
+  {
+    kie::serde::Field<std::string, "s"> s;
+    kie::serde::Field<std::vector<Inner>, "items"> items;
+    kie::serde::Field<std::array<std::string, 2>, "pair"> pair;
+    kie::serde::Field<std::list<std::string>, "names"> names;
+    int not_a_field = 0;
+  };
+
+  const std::string large = R"({"s":"a long string that is not in the small string buffer","items":[{"i":1,"v":[1,2,3,4,5,6,7,8]},{"i":2,"v":[9]},{"i":3,"v":[]}],"pair":["x","y"],"names":["a","b","c"]})";
+  const std::string small = R"({"names":["d"],"items":[{"i":4,"v":[1]}],"s":"short","pair":["z"]})";
+
+  B b;
+  from_json_into(b, large);
+  b.not_a_field = 7;
+  const char *s_data = b.s.value.data();
+  const Inner *items_data = b.items.value.data();
+  const int *v_data = b.items.value[0].v.value.data();
+
+  from_json_into(b, small);
+  EXPECT_EQ(b.s.value, "short");
+  EXPECT_EQ(b.items.value, (std::vector<Inner>{Inner{.i = 4, .v = std::vector<int>{1}}}));
+  EXPECT_EQ(b.pair.value, (std::array<std::string, 2>{"z", ""}));
+  EXPECT_EQ(b.names.value, (std::list<std::string>{"d"}));
+  EXPECT_EQ(b.not_a_field, 0);
+  // the memory of the strings and the vectors is kept.
+  EXPECT_EQ(b.s.value.data(), s_data);
+  EXPECT_EQ(b.items.value.data(), items_data);
+  EXPECT_EQ(b.items.value[0].v.value.data(), v_data);
+
+  from_json_into(b, large);
+  EXPECT_EQ(b.items.value.size(), 3u);
+  EXPECT_EQ(b.items.value[1].v.value, (std::vector<int>{9}));
+  EXPECT_EQ(b.names.value, (std::list<std::string>{"a", "b", "c"}));
+  EXPECT_EQ(b.s.value.data(), s_data);
+  EXPECT_EQ(b.items.value.data(), items_data);
+
+  // the same as reading a new one.
+  for (std::string_view json_str : {std::string_view{large}, std::string_view{small}})
+  {
+    B fresh = from_json<B>(json_str);
+    from_json_into(b, json_str);
+    EXPECT_EQ(to_json_string(b), to_json_string(fresh));
+  }
+
+  std::vector<Inner> vec{Inner{.i = 1}, Inner{.i = 2}};
+  from_json_into(vec, R"([{"i":3,"v":[3]}])");
+  EXPECT_EQ(vec, (std::vector<Inner>{Inner{.i = 3, .v = std::vector<int>{3}}}));
+  from_json_into(vec, "null");
+  EXPECT_TRUE(vec.empty());
+
+  EXPECT_THROW(from_json_into(b, R"({"s":"x"})"), nlohmann::json::out_of_range);
+}
+
+// Demonstrate some basic assertions.
+TEST(ReadJson, Projection)
+{
+  using namespace kie::serde_json;
+
+  struct Summary
+  {
+    kie::serde::Field<int, "id"> id;
+    kie::serde::Field<Inner, "inner"> inner;
+    kie::serde::Field<std::vector<int>, "v"> v;
+  };
+
+  const read_options projection{.projection = true};
+  for (std::string_view json_str : {
+           R"({"id":1,"inner":{"i":2,"v":[3]},"v":[4]})",
+           R"({"a":{"b":[1,{"c":"}]\"{["}],"d":null},"id":1,"e":"x\\","inner":{"x":[[[]]],"i":2,"v":[3],"y":true},"v":[4],"f":-1.5e3})",
+           R"( { "a" : [ ] , "id" : 1 , "inner" : { "i" : 2 , "v" : [ 3 ] , "z" : "\u00e9" } , "b" : 7 , "v" : [ 4 ] , "c" : false } )",
+           R"({"id":1,"inner":{"i":2,"v":[3]},"v":[4],"n":{"deep":[{"deeper":[[{"x":"]"}]]}]}})",
+       })
+  {
+    EXPECT_EQ(to_json_string(from_json<Summary>(json_str, projection)), to_json_string(from_json<Summary>(json_str))) << json_str;
+  }
+
+  // the errors in the values that are not read are not reported, but the others still are.
+  const std::string sloppy = R"({"a":{"b":tru, "c":"\q", "d":01}, "id":1,"inner":{"i":2,"v":[3],"x":[1,,2]},"v":[4]})";
+  EXPECT_THROW(from_json<Summary>(sloppy), nlohmann::json::parse_error);
+  EXPECT_EQ(from_json<Summary>(sloppy, projection).inner.value.i.value, 2);
+  EXPECT_EQ(from_json<Summary>(R"({"a":nul,"id":1,"inner":{"i":2,"v":[]},"v":[]})", projection).id.value, 1);
+
+  EXPECT_THROW(from_json<Summary>(R"({"a":{"b":[1,2},"id":1,"inner":{"i":2,"v":[3]},"v":[4]})", projection), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Summary>(R"({"a":"x,"id":1,"inner":{"i":2,"v":[3]},"v":[4]})", projection), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Summary>(R"({"a":1,"id":"1","inner":{"i":2,"v":[3]},"v":[4]})", projection), nlohmann::json::type_error);
+  EXPECT_THROW(from_json<Summary>(R"({"a":1,"inner":{"i":2,"v":[3]},"v":[4]})", projection), nlohmann::json::out_of_range);
+  EXPECT_THROW(from_json<Summary>(R"({"a":[1,2,)", projection), nlohmann::json::parse_error);
+  EXPECT_THROW(from_json<Summary>(R"({"a":"\)", projection), nlohmann::json::parse_error);
+
+  // the values of a container that are not array are skipped in the same way.
+  EXPECT_TRUE(from_json<std::vector<int>>(R"({"a":[1,}})", projection).empty());
+
+  Summary summary;
+  from_json_into(summary, R"({"x":{"y":[]},"id":3,"inner":{"i":2,"v":[3]},"v":[4]})", projection);
+  EXPECT_EQ(summary.id.value, 3);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
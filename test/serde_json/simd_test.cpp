@@ -0,0 +1,132 @@
+#include <serde_json/json.hpp>
+#include <serde_json/simd.hpp>
+#include <iostream>
+#include <random>
+#include <gtest/gtest.h>
+
+namespace
+{
+  using kie::serde_json::impl::simd::level;
+
+  std::vector<level> levels()
+  {
+    std::vector<level> result{level::scalar};
+    for (level l : {level::sse2, level::avx2})
+    {
+      if (kie::serde_json::impl::simd::kernels_of(l).level == l)
+      {
+        result.push_back(l);
+      }
+    }
+    return result;
+  }
+
+  // Pieces that cover all the branches of the UTF-8 validation, valid or not.
+  const std::vector<std::string> &pieces()
+  {
+    static const std::vector<std::string> result{
+        "a", "\"", "\\", "\n", "\x1F", " ", "\x7F", "[", "]", "{", "}", "\x5C", "\x5F", "\xFB", "\xFD",
+        "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF", "\xEF\xBF\xBF",
+        "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF0\x8F\xBF\xBF",
+        "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF", "\xC3", "\xE4\xB8", "\xF0\x9F\x98", "\xC3\xA9\xA9"};
+    return result;
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(SimdKernels, SameAsScalar)
+{
+  using namespace kie::serde_json::impl;
+
+  std::mt19937 random{42};
+  const auto &scalar = simd::kernels_of(level::scalar);
+  for (level l : levels())
+  {
+    const auto &kernels = simd::kernels_of(l);
+    for (int round = 0; round < 20000; round++)
+    {
+      // mostly ASCII, with a few special pieces at random places, so that the blocks are of all kinds.
+      std::string str;
+      const std::size_t length = random() % 100;
+      while (str.size() < length)
+      {
+        if (random() % 8 == 0)
+        {
+          str += pieces()[random() % pieces().size()];
+        }
+        else
+        {
+          str += static_cast<char>('a' + random() % 26);
+        }
+      }
+
+      EXPECT_EQ(kernels.find_escape(str.data(), str.size()), scalar.find_escape(str.data(), str.size())) << static_cast<int>(l) << " " << str;
+      EXPECT_EQ(kernels.validate_utf8(str.data(), str.size()), scalar.validate_utf8(str.data(), str.size())) << static_cast<int>(l) << " " << str;
+      EXPECT_EQ(kernels.find_structural(str.data(), str.size()), scalar.find_structural(str.data(), str.size())) << static_cast<int>(l) << " " << str;
+    }
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(SimdKernels, BlockBoundary)
+{
+  using namespace kie::serde_json::impl;
+
+  for (level l : levels())
+  {
+    const auto &kernels = simd::kernels_of(l);
+    for (const auto &piece : pieces())
+    {
+      std::size_t bad = 0;
+      const bool valid = utf8_validate(reinterpret_cast<const unsigned char *>(piece.data()), piece.size(), bad);
+      for (std::size_t offset = 0; offset < 70; offset++)
+      {
+        std::string str = std::string(offset, 'x') + piece + std::string(40, 'y');
+        EXPECT_EQ(kernels.validate_utf8(str.data(), str.size()), valid) << static_cast<int>(l) << " " << offset << " " << piece;
+        str.resize(offset + piece.size());
+        EXPECT_EQ(kernels.validate_utf8(str.data(), str.size()), valid) << static_cast<int>(l) << " " << offset << " " << piece;
+      }
+    }
+
+    for (std::size_t offset = 0; offset < 70; offset++)
+    {
+      std::string str = std::string(offset, 'x') + "\x01" + std::string(40, '"');
+      EXPECT_EQ(kernels.find_escape(str.data(), str.size()), offset);
+      EXPECT_EQ(kernels.find_escape(str.data(), offset), offset);
+      EXPECT_EQ(kernels.find_structural(str.data(), str.size()), offset + 1);
+    }
+
+    for (char c : std::string{"\"[]{}"})
+    {
+      for (std::size_t offset = 0; offset < 70; offset++)
+      {
+        std::string str = std::string(offset, 'x') + "\\\x01:,;=" + c + std::string(40, c);
+        EXPECT_EQ(kernels.find_structural(str.data(), str.size()), offset + 6) << c;
+      }
+    }
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(SimdKernels, WriteAndRead)
+{
+  using namespace kie::serde_json;
+
+  for (std::size_t offset = 0; offset < 70; offset++)
+  {
+    std::vector<std::string> strings{std::string(offset, 'x') + "\"\\\n\x01中文😀" + std::string(offset, '\t')};
+    const std::string json_str = to_json_string(strings);
+    EXPECT_EQ(json_str, nlohmann::json(strings).dump());
+    EXPECT_EQ(from_json<std::vector<std::string>>(json_str), strings);
+
+    strings[0] += "\xE4\xB8";
+    EXPECT_THROW(to_json_string(strings), nlohmann::json::type_error);
+    EXPECT_THROW(from_json<std::vector<std::string>>("[\"" + std::string(offset, 'x') + "\xE4\xB8\"]"), nlohmann::json::parse_error);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,186 @@
+#include <serde_json/json.hpp>
+#include <serde_json/stream.hpp>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <gtest/gtest.h>
+
+namespace
+{
+  struct Item
+  {
+    kie::serde::Field<int, "id"> id;
+    kie::serde::Field<std::string, "name"> name;
+    kie::serde::Field<std::vector<int>, "values"> values;
+  };
+
+  std::vector<Item> make_items(int count)
+  {
+    std::vector<Item> items;
+    for (int i = 0; i < count; i++)
+    {
+      items.push_back(Item{.id = i, .name = std::string(static_cast<std::size_t>(i % 7), 'x') + "[\"]}" + std::to_string(i), .values = std::vector<int>(static_cast<std::size_t>(i % 5), i)});
+    }
+    return items;
+  }
+
+  template <typename Reader>
+  void expect_items(Reader &&reader, const std::vector<Item> &expected)
+  {
+    std::size_t i = 0;
+    for (auto &item : reader)
+    {
+      ASSERT_LT(i, expected.size());
+      EXPECT_EQ(item.id.value, expected[i].id.value);
+      EXPECT_EQ(item.name.value, expected[i].name.value);
+      EXPECT_EQ(item.values.value, expected[i].values.value);
+      i++;
+    }
+    EXPECT_EQ(i, expected.size());
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(JsonArrayReader, Stream)
+{
+  using namespace kie::serde_json;
+
+  for (int count : {0, 1, 2, 100})
+  {
+    auto items = make_items(count);
+    std::string json_str = to_json_string(items);
+    if (items.empty())
+    {
+      json_str = " [ ] ";
+    }
+
+    for (std::size_t chunk_size : {1, 3, 16, 64 * 1024})
+    {
+      std::istringstream in{json_str};
+      expect_items(json_array_reader<Item>{in, chunk_size}, items);
+    }
+    expect_items(json_array_reader<Item>{std::string_view{json_str}}, items);
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(JsonArrayReader, Scalar)
+{
+  using namespace kie::serde_json;
+
+  for (std::size_t chunk_size : {1, 2, 1024})
+  {
+    std::istringstream in{"[1, -2 ,3.5e1,\"4\"]"};
+    std::vector<double> numbers;
+    EXPECT_THROW(
+        {
+          for (double d : json_array_reader<double>{in, chunk_size})
+          {
+            numbers.push_back(d);
+          }
+        },
+        nlohmann::json::type_error);
+    EXPECT_EQ(numbers, (std::vector<double>{1, -2, 35}));
+  }
+
+  std::vector<std::string> strings;
+  for (auto &s : json_array_reader<std::string>{std::string_view{"[\"a\",\"b\\\"]\"]"}})
+  {
+    strings.push_back(s);
+  }
+  EXPECT_EQ(strings, (std::vector<std::string>{"a", "b\"]"}));
+
+  int count = 0;
+  for ([[maybe_unused]] auto &i : json_array_reader<int>{std::string_view{"null"}})
+  {
+    count++;
+  }
+  EXPECT_EQ(count, 0);
+}
+
+// Demonstrate some basic assertions.
+TEST(JsonArrayReader, Error)
+{
+  using namespace kie::serde_json;
+
+  auto read_all = [](std::string_view json_str)
+  {
+    std::istringstream in{std::string{json_str}};
+    for ([[maybe_unused]] auto &item : json_array_reader<std::vector<int>>{in, 2})
+    {
+    }
+  };
+
+  EXPECT_NO_THROW(read_all("[[1],[2]]"));
+  EXPECT_THROW(read_all("[[1],[2]"), nlohmann::json::parse_error);
+  EXPECT_THROW(read_all("[[1] [2]]"), nlohmann::json::parse_error);
+  EXPECT_THROW(read_all("[[1],[2}]"), nlohmann::json::parse_error);
+  EXPECT_THROW(read_all("[[1],[2]] x"), nlohmann::json::parse_error);
+  EXPECT_THROW(read_all("[[1],]"), nlohmann::json::parse_error);
+
+  // the input that is not an array has no item, but it's still validated like from_json does.
+  EXPECT_NO_THROW(read_all(" {\"a\": [1, {}]} "));
+  EXPECT_NO_THROW(read_all("\"x\""));
+  for (std::string_view bad : {"", "   ", "garbage", "{\"a\":1", "nul", "\"[1]", "{\"a\":1} x", "1 2"})
+  {
+    EXPECT_THROW(read_all(bad), nlohmann::json::parse_error) << bad;
+    EXPECT_THROW(from_json<std::vector<std::vector<int>>>(std::string{bad}), nlohmann::json::parse_error) << bad;
+  }
+
+  try
+  {
+    read_all("[[1],[1,x]]");
+    FAIL();
+  }
+  catch (const nlohmann::json::parse_error &e)
+  {
+    EXPECT_EQ(e.byte, 9u);
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(NdjsonReader, Stream)
+{
+  using namespace kie::serde_json;
+
+  auto items = make_items(50);
+  std::string json_str = "\n";
+  for (const auto &item : items)
+  {
+    json_str += to_json_string(item) + (item.id.value % 2 == 0 ? "\r\n" : "\n  \n");
+  }
+  json_str.pop_back();
+
+  for (std::size_t chunk_size : {1, 7, 64 * 1024})
+  {
+    std::istringstream in{json_str};
+    expect_items(ndjson_reader<Item>{in, chunk_size}, items);
+  }
+  expect_items(ndjson_reader<Item>{std::string_view{json_str}}, items);
+
+  std::FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  std::fwrite(json_str.data(), 1, json_str.size(), file);
+  std::fflush(file);
+  std::rewind(file);
+  expect_items(ndjson_reader<Item>{fileno(file), 16}, items);
+  std::fclose(file);
+
+  std::istringstream broken{"{\"id\":1,\"name\":\"\",\"values\":[]}\n{\"id\":2}\n"};
+  int count = 0;
+  EXPECT_THROW(
+      {
+        for ([[maybe_unused]] auto &item : ndjson_reader<Item>{broken})
+        {
+          count++;
+        }
+      },
+      nlohmann::json::out_of_range);
+  EXPECT_EQ(count, 1);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
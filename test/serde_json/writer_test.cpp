@@ -0,0 +1,250 @@
+#include <serde_json/json.hpp>
+#include <bit>
+#include <iostream>
+#include <random>
+#include <gtest/gtest.h>
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, NotRecognized)
+{
+  using namespace kie::serde_json;
+  EXPECT_EQ(to_json_string(1), to_json(1).dump());
+  EXPECT_EQ(to_json_string('a'), to_json('a').dump());
+  EXPECT_EQ(to_json_string(std::string{"hello"}), to_json(std::string{"hello"}).dump());
+  EXPECT_EQ(to_json_string(true), to_json(true).dump());
+  EXPECT_EQ(to_json_string(1.1), to_json(1.1).dump());
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, Container)
+{
+  using namespace kie::serde_json;
+  EXPECT_EQ(to_json_string(std::vector{1, 2, 3}), to_json(std::vector{1, 2, 3}).dump());
+  EXPECT_EQ(to_json_string(std::vector<int>{}), to_json(std::vector<int>{}).dump());
+  EXPECT_EQ(to_json_string(std::vector{1.1, 1.0, -0.0, 1e100, 3.14159e-10}), to_json(std::vector{1.1, 1.0, -0.0, 1e100, 3.14159e-10}).dump());
+  EXPECT_EQ(to_json_string(std::vector{1.1f, 2.5f}), to_json(std::vector{1.1f, 2.5f}).dump());
+  EXPECT_EQ(to_json_string(std::list{true, false}), to_json(std::list{true, false}).dump());
+  EXPECT_EQ(to_json_string(std::array<int, 10>{}), to_json(std::array<int, 10>{}).dump());
+  EXPECT_EQ(to_json_string(std::vector<std::string>{"a", "b"}), to_json(std::vector<std::string>{"a", "b"}).dump());
+  EXPECT_EQ(to_json_string(std::vector<std::vector<int>>{{1}, {}, {2, 3}}), to_json(std::vector<std::vector<int>>{{1}, {}, {2, 3}}).dump());
+  EXPECT_EQ(to_json_string(std::vector<std::uint64_t>{18446744073709551615ull}), "[18446744073709551615]");
+  EXPECT_EQ(to_json_string(std::vector<std::int64_t>{-9223372036854775807ll - 1}), "[-9223372036854775808]");
+  EXPECT_EQ(to_json_string(std::vector<double>{std::numeric_limits<double>::infinity()}), "[null]");
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, NumberFormat)
+{
+  using namespace kie::serde_json;
+
+  // the compatible format is pinned, so a change of nlohmann_json that breaks it is noticed.
+  const std::vector<double> numbers{1.1, 1.0, -0.0, 0.0, 1e100, 3.14159e-10, 123456.789, 0.1f, 1e15, 1e16, 5e-324, 1.7976931348623157e308};
+  EXPECT_EQ(to_json_string(numbers), "[1.1,1.0,-0.0,0.0,1e+100,3.14159e-10,123456.789,0.10000000149011612,1e+15,1e+16,5e-324,1.7976931348623157e+308]");
+  EXPECT_EQ(to_json_string(numbers), to_json(numbers).dump());
+
+  const write_options shortest{.numbers = number_format::shortest};
+  EXPECT_EQ(to_json_string(std::vector{1.1, 1.0, -0.0, 0.0, 1e100, 3.14159e-10, 123456.789}, shortest), "[1.1,1,-0.0,0,1e+100,3.14159e-10,123456.789]");
+  EXPECT_EQ(to_json_string(std::vector{0.1f, 2.5f, 16777216.0f}, shortest), "[0.1,2.5,16777216]");
+  EXPECT_EQ(to_json_string(std::vector{std::numeric_limits<double>::quiet_NaN()}, shortest), "[null]");
+  EXPECT_EQ(to_json_string(std::vector{1, -2}, shortest), "[1,-2]");
+
+  struct A
+  {
+    kie::serde::Field<double, "d"> d;
+    kie::serde::Field<float, "f"> f;
+    kie::serde::Field<std::vector<double>, "v"> v;
+  };
+
+  // the shortest text reads back to the same value.
+  std::mt19937_64 random{42};
+  for (int i = 0; i < 1000; i++)
+  {
+    A a{.d = std::bit_cast<double>(random()), .f = std::bit_cast<float>(static_cast<std::uint32_t>(random())), .v = std::vector{-0.0, std::bit_cast<double>(random())}};
+    if (!std::isfinite(a.d.value) || !std::isfinite(a.f.value) || !std::isfinite(a.v.value[1]))
+    {
+      continue;
+    }
+    A b = from_json<A>(to_json_string(a, shortest));
+    EXPECT_EQ(std::bit_cast<std::uint64_t>(b.d.value), std::bit_cast<std::uint64_t>(a.d.value));
+    EXPECT_EQ(std::bit_cast<std::uint32_t>(b.f.value), std::bit_cast<std::uint32_t>(a.f.value));
+    EXPECT_EQ(std::bit_cast<std::uint64_t>(b.v.value[0]), std::bit_cast<std::uint64_t>(-0.0));
+    EXPECT_EQ(std::bit_cast<std::uint64_t>(b.v.value[1]), std::bit_cast<std::uint64_t>(a.v.value[1]));
+    EXPECT_EQ(to_json_string(a), to_json(a).dump());
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, String)
+{
+  using namespace kie::serde_json;
+
+  struct A
+  {
+    kie::serde::Field<std::string, "s"> s;
+  };
+
+  for (const std::string &s : std::vector<std::string>{"", "plain", "quote\"backslash\\", "\b\f\n\r\t", std::string{"\x01\x1f\x7f", 3}, std::string{"\0", 1}, "中文", "\xF0\x9F\x98\x80"})
+  {
+    A a{.s = s};
+    EXPECT_EQ(to_json_string(a), to_json(a).dump());
+  }
+
+  for (const std::string &s : std::vector<std::string>{"\xFF", "a\xC3\x28", "\xE0\x80\x80", "\xED\xA0\x80", "abc\xE4\xB8"})
+  {
+    A a{.s = s};
+    std::string expected;
+    try
+    {
+      to_json(a).dump();
+    }
+    catch (const nlohmann::json::type_error &e)
+    {
+      expected = e.what();
+    }
+    EXPECT_FALSE(expected.empty());
+    EXPECT_THROW(
+        {
+          try
+          {
+            to_json_string(a);
+          }
+          catch (const nlohmann::json::type_error &e)
+          {
+            EXPECT_EQ(std::string{e.what()}, expected);
+            throw;
+          }
+        },
+        nlohmann::json::type_error);
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, StructComplex)
+{
+  using namespace kie::serde_json;
+
+  enum class Color
+  {
+    red = 1,
+    blue = 2,
+  };
+
+  struct Empty
+  {
+    int i;
+  };
+
+  struct Inner
+  {
+    kie::serde::Field<int, "i"> i = 10;
+    kie::serde::Field<std::vector<int>, "v"> v = std::vector{1, 2, 3, 4, 5};
+    kie::serde::Field<Color, "color"> color = Color::blue;
+  };
+
+  struct A
+  {
+    kie::serde::Field<std::vector<int>, "z"> z = std::vector{1, 2, 3, 4, 5};
+    bool b;
+    kie::serde::Field<Inner, "inner"> inner;
+    kie::serde::Field<Empty, "empty"> empty;
+    kie::serde::Field<std::array<Inner, 3>, "inner_array"> inner_array;
+    kie::serde::Field<std::vector<Inner>, "inner_vec"> inner_vec;
+    kie::serde::Field<std::string, "a key with \"quote\""> s = std::string{"value"};
+    kie::serde::Field<double, "d"> d = 0.1;
+    kie::serde::Field<char, "c"> c = 'c';
+    kie::serde::Field<bool, "bool"> flag = true;
+  };
+
+  A a{};
+  EXPECT_EQ(to_json_string(a), to_json(a).dump());
+
+  a.inner_vec = std::vector<Inner>(2);
+  EXPECT_EQ(to_json_string(a), to_json(a).dump());
+
+  std::vector<A> vec(3);
+  EXPECT_EQ(to_json_string(vec), to_json(vec).dump());
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, DuplicatedTag)
+{
+  using namespace kie::serde_json;
+
+  struct A
+  {
+    kie::serde::Field<int, "i"> first = 1;
+    kie::serde::Field<int, "i"> second = 2;
+  };
+
+  EXPECT_EQ(to_json_string(A{}), to_json(A{}).dump());
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, KeyPlan)
+{
+  using namespace kie::serde_json;
+
+  struct A
+  {
+    kie::serde::Field<int, "b"> b = 2;
+    kie::serde::Field<int, "a"> a = 1;
+    kie::serde::Field<int, "q\"\\/\t\x01"> escaped = 3;
+  };
+
+  // the keys are built at compile time, in the order of the tags.
+  using plan = impl::object_plan<A>;
+  static_assert(plan::prebuilt);
+  static_assert(plan::fragment<0> == "{\"a\":");
+  static_assert(plan::fragment<1> == ",\"b\":");
+  static_assert(plan::fragment<2> == ",\"q\\\"\\\\/\\t\\u0001\":");
+  EXPECT_EQ(to_json_string(A{}), to_json(A{}).dump());
+
+  // the tags that are not ASCII are written at runtime.
+  struct B
+  {
+    kie::serde::Field<int, "ключ"> key = 1;
+    kie::serde::Field<int, "a"> a = 2;
+  };
+  static_assert(!impl::object_plan<B>::prebuilt);
+  EXPECT_EQ(to_json_string(B{}), to_json(B{}).dump());
+
+  struct C
+  {
+    kie::serde::Field<int, "\xff"> bad = 1;
+  };
+  EXPECT_THROW(to_json_string(C{}), nlohmann::json::type_error);
+}
+
+// Demonstrate some basic assertions.
+TEST(WriteJson, Append)
+{
+  using namespace kie::serde_json;
+
+  struct A
+  {
+    kie::serde::Field<int, "i"> i = 1;
+  };
+
+  std::string buffer = "prefix:";
+  write_json(A{}, buffer);
+  EXPECT_EQ(buffer, "prefix:{\"i\":1}");
+
+  to_json_into(buffer, A{.i = 2});
+  EXPECT_EQ(buffer, "prefix:{\"i\":1}{\"i\":2}");
+
+  // the capacity is reused after clear.
+  const char *data = buffer.data();
+  for (int i = 0; i < 100; i++)
+  {
+    buffer.clear();
+    to_json_into(buffer, A{.i = i});
+    EXPECT_EQ(buffer, "{\"i\":" + std::to_string(i) + "}");
+    EXPECT_EQ(buffer.data(), data);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,365 @@
+#include <serde_msgpack/msgpack.hpp>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <gtest/gtest.h>
+
+namespace
+{
+  struct Inner
+  {
+    kie::serde::Field<int, "i"> i;
+    kie::serde::Field<std::vector<int>, "v"> v;
+  };
+
+  enum class Color : std::uint8_t
+  {
+    red,
+    green = 200,
+  };
+
+  struct A
+  {
+    kie::serde::Field<std::string, "s"> s;
+    kie::serde::Field<double, "d"> d;
+    kie::serde::Field<float, "f"> f;
+    kie::serde::Field<bool, "b"> b;
+    kie::serde::Field<std::int64_t, "n"> n;
+    kie::serde::Field<std::uint64_t, "u"> u;
+    kie::serde::Field<Color, "color"> color;
+    kie::serde::Field<Inner, "inner"> inner;
+    kie::serde::Field<std::vector<Inner>, "inner_vec"> inner_vec;
+    kie::serde::Field<std::list<std::string>, "strings"> strings;
+    kie::serde::Field<std::array<bool, 3>, "flags"> flags;
+    int not_a_field = 7;
+  };
+
+  bool operator==(const Inner &l, const Inner &r)
+  {
+    return l.i.value == r.i.value && l.v.value == r.v.value;
+  }
+
+  bool operator==(const A &l, const A &r)
+  {
+    return l.s.value == r.s.value && l.d.value == r.d.value && l.f.value == r.f.value && l.b.value == r.b.value && l.n.value == r.n.value &&
+           l.u.value == r.u.value && l.color.value == r.color.value && l.inner.value == r.inner.value && l.inner_vec.value == r.inner_vec.value &&
+           l.strings.value == r.strings.value && l.flags.value == r.flags.value;
+  }
+
+  /// The largest allocation of recording_allocator, to check what a container reserves.
+  std::size_t largest_allocation = 0;
+
+  template <typename T>
+  struct recording_allocator
+  {
+    using value_type = T;
+
+    recording_allocator() = default;
+
+    template <typename U>
+    recording_allocator(const recording_allocator<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+      largest_allocation = std::max(largest_allocation, n * sizeof(T));
+      return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+      std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const recording_allocator<U> &) const
+    {
+      return true;
+    }
+  };
+
+  std::string bytes(std::initializer_list<int> values)
+  {
+    std::string result;
+    for (int value : values)
+    {
+      result.push_back(static_cast<char>(value));
+    }
+    return result;
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(Msgpack, Encode)
+{
+  using namespace kie::serde_msgpack;
+
+  EXPECT_EQ(to_msgpack(std::vector<int>{0, 127, 128, 255, 256, 65535, 65536}),
+            bytes({0x97, 0x00, 0x7F, 0xCC, 0x80, 0xCC, 0xFF, 0xCD, 0x01, 0x00, 0xCD, 0xFF, 0xFF, 0xCE, 0x00, 0x01, 0x00, 0x00}));
+  EXPECT_EQ(to_msgpack(std::vector<std::int64_t>{-1, -32, -33, -128, -129, -32768, -32769, std::numeric_limits<std::int64_t>::min()}),
+            bytes({0x98, 0xFF, 0xE0, 0xD0, 0xDF, 0xD0, 0x80, 0xD1, 0xFF, 0x7F, 0xD1, 0x80, 0x00, 0xD2, 0xFF, 0xFF, 0x7F, 0xFF, 0xD3, 0x80, 0, 0, 0, 0, 0, 0, 0}));
+  EXPECT_EQ(to_msgpack(std::vector<std::uint64_t>{4294967296ull}), bytes({0x91, 0xCF, 0, 0, 0, 1, 0, 0, 0, 0}));
+  EXPECT_EQ(to_msgpack(std::vector<double>{1.5}), bytes({0x91, 0xCB, 0x3F, 0xF8, 0, 0, 0, 0, 0, 0}));
+  EXPECT_EQ(to_msgpack(std::vector<float>{1.5f}), bytes({0x91, 0xCA, 0x3F, 0xC0, 0, 0}));
+  EXPECT_EQ(to_msgpack(std::vector<bool>{true, false}), bytes({0x92, 0xC3, 0xC2}));
+  EXPECT_EQ(to_msgpack(std::vector<int>{}), bytes({0x90}));
+  EXPECT_EQ(to_msgpack(std::vector<std::string>{"", "abc"}), bytes({0x92, 0xA0, 0xA3, 'a', 'b', 'c'}));
+  EXPECT_EQ(to_msgpack(1), bytes({0xC0}));
+
+  // the headers switch to wider formats at the limits.
+  EXPECT_EQ(to_msgpack(std::vector<std::string>{std::string(31, 'x')}).substr(0, 2), bytes({0x91, 0xBF}));
+  EXPECT_EQ(to_msgpack(std::vector<std::string>{std::string(32, 'x')}).substr(0, 3), bytes({0x91, 0xD9, 32}));
+  EXPECT_EQ(to_msgpack(std::vector<std::string>{std::string(256, 'x')}).substr(0, 4), bytes({0x91, 0xDA, 0x01, 0x00}));
+  EXPECT_EQ(to_msgpack(std::vector<std::string>{std::string(65536, 'x')}).substr(0, 6), bytes({0x91, 0xDB, 0, 1, 0, 0}));
+  EXPECT_EQ(to_msgpack(std::vector<int>(15)).substr(0, 1), bytes({0x9F}));
+  EXPECT_EQ(to_msgpack(std::vector<int>(16)).substr(0, 3), bytes({0xDC, 0, 16}));
+  EXPECT_EQ(to_msgpack(std::vector<int>(65536)).substr(0, 5), bytes({0xDD, 0, 1, 0, 0}));
+
+  // the keys are in the order of tags.
+  Inner inner{.i = 1, .v = std::vector{2}};
+  EXPECT_EQ(to_msgpack(inner), bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'v', 0x91, 0x02}));
+
+  struct Empty
+  {
+    int a;
+  };
+  EXPECT_EQ(to_msgpack(Empty{}), bytes({0xC0}));
+
+  // the length that does not fit is in the message, and the position is where the output ends.
+  std::string out = bytes({0x91});
+  try
+  {
+    impl::write_array_header(std::size_t{1} << 32, out);
+    FAIL() << "no error";
+  }
+  catch (const msgpack_error &e)
+  {
+    EXPECT_EQ(e.code(), errc::too_long);
+    EXPECT_EQ(e.position(), 1u);
+    EXPECT_EQ(std::string{e.what()}, "[serde_msgpack] string or container too long (length 4294967296) at byte 1");
+  }
+
+  // a buffer without size() is enough, and the bytes written to it are counted.
+  struct Appender
+  {
+    std::string bytes;
+
+    void append(const char *data, std::size_t size)
+    {
+      bytes.append(data, size);
+    }
+
+    void push_back(char c)
+    {
+      bytes.push_back(c);
+    }
+  };
+  Appender appender{bytes({0x91})};
+  write_msgpack(inner, appender);
+  EXPECT_EQ(appender.bytes, bytes({0x91}) + to_msgpack(inner));
+  impl::output_counter<Appender> counted{appender};
+  counted.push_back(static_cast<char>(0x91));
+  try
+  {
+    impl::write_array_header(std::size_t{1} << 32, counted);
+    FAIL() << "no error";
+  }
+  catch (const msgpack_error &e)
+  {
+    EXPECT_EQ(e.position(), 1u);
+  }
+}
+
+// Demonstrate some basic assertions.
+TEST(Msgpack, RoundTrip)
+{
+  using namespace kie::serde_msgpack;
+
+  A a{.s = std::string{"hello 中文"}, .d = 0.1, .f = 0.1f, .b = true, .n = -1234567890123, .u = std::numeric_limits<std::uint64_t>::max(), .color = Color::green};
+  a.inner = Inner{.i = -5, .v = std::vector{1, 2, 3}};
+  a.inner_vec = std::vector<Inner>(20, a.inner.value);
+  a.strings = std::list<std::string>{"x", std::string(300, 'y')};
+  a.flags = std::array<bool, 3>{true, false, true};
+  a.not_a_field = 8;
+
+  const std::string encoded = to_msgpack(a);
+  A b = from_msgpack<A>(encoded);
+  EXPECT_EQ(b, a);
+  EXPECT_EQ(b.not_a_field, 7);
+
+  auto vec = from_msgpack<std::vector<A>>(to_msgpack(std::vector<A>{a, b}));
+  EXPECT_EQ(vec, (std::vector<A>{a, a}));
+  EXPECT_TRUE(from_msgpack<std::vector<int>>(bytes({0xC0})).empty());
+
+  struct View
+  {
+    kie::serde::Field<std::string_view, "s"> s;
+  };
+  const std::string view_bytes = to_msgpack(View{.s = std::string_view{"abc"}});
+  View view = from_msgpack<View>(view_bytes);
+  EXPECT_EQ(view.s.value, "abc");
+  EXPECT_EQ(view.s.value.data(), view_bytes.data() + 4);
+
+  // a Lazy Field is written and read as the value it holds.
+  struct Eager
+  {
+    kie::serde::Field<std::string, "route"> route;
+    kie::serde::Field<Inner, "payload"> payload;
+  };
+  struct WithLazy
+  {
+    kie::serde::Field<std::string, "route"> route;
+    kie::serde::Field<kie::serde::Lazy<Inner>, "payload"> payload;
+  };
+  const Inner payload{.i = 3, .v = std::vector{4, 5}};
+  WithLazy with_lazy{.route = std::string{"r"}, .payload = kie::serde::Lazy<Inner>{payload}};
+  const std::string lazy_bytes = to_msgpack(with_lazy);
+  EXPECT_EQ(lazy_bytes, to_msgpack(Eager{.route = std::string{"r"}, .payload = payload}));
+  WithLazy lazy_back = from_msgpack<WithLazy>(lazy_bytes);
+  EXPECT_EQ(lazy_back.route.value, "r");
+  EXPECT_TRUE(lazy_back.payload.value.parsed());
+  EXPECT_FALSE(lazy_back.payload.value.has_raw());
+  EXPECT_EQ(*lazy_back.payload.value, payload);
+
+  // the raw text is not msgpack, so the value parsed from it is written.
+  with_lazy.payload.value.assign_raw("raw", [](std::string_view, Inner &value)
+                                     { value = Inner{.i = 3, .v = std::vector{4, 5}}; });
+  EXPECT_EQ(to_msgpack(with_lazy), lazy_bytes);
+  EXPECT_TRUE(with_lazy.payload.value.has_raw());
+}
+
+// Demonstrate some basic assertions.
+TEST(Msgpack, Decode)
+{
+  using namespace kie::serde_msgpack;
+
+  // the keys can be in any order, and the unknown ones of any kind are skipped.
+  const std::string unordered = bytes({0x87,
+                                       0xA1, 'v', 0xDC, 0x00, 0x02, 0x01, 0xCD, 0x01, 0x00,
+                                       0xA1, 'x', 0x92, 0x81, 0xA1, 'y', 0xC0, 0xC4, 0x02, 0x01, 0x02,
+                                       0x01, 0xD6, 0x01, 1, 2, 3, 4,
+                                       0xA1, 'z', 0xC7, 0x01, 0x05, 0xAA,
+                                       0xA1, 'i', 0xD0, 0x80,
+                                       0xA1, 'w', 0xCB, 0x3F, 0xF8, 0, 0, 0, 0, 0, 0,
+                                       0xD9, 0x01, 'i', 0x2A});
+  Inner inner = from_msgpack<Inner>(unordered);
+  EXPECT_EQ(inner.i.value, 42);
+  EXPECT_EQ(inner.v.value, (std::vector<int>{1, 256}));
+
+  auto expect_error = [](const std::string &input, errc code, std::size_t position)
+  {
+    try
+    {
+      from_msgpack<Inner>(input);
+      FAIL() << "no error";
+    }
+    catch (const msgpack_error &e)
+    {
+      EXPECT_EQ(e.code(), code) << e.what();
+      EXPECT_EQ(e.position(), position) << e.what();
+    }
+  };
+
+  expect_error(bytes({}), errc::unexpected_end, 0);
+  expect_error(bytes({0x82, 0xA1, 'i', 0x01}), errc::unexpected_end, 1);
+  expect_error(bytes({0x81, 0xA1, 'i', 0x01}), errc::missing_field, 4);
+  expect_error(bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'v', 0x90, 0xC0}), errc::trailing_data, 7);
+  expect_error(bytes({0x82, 0xA1, 'i', 0xA1, 'x', 0xA1, 'v', 0x90}), errc::type_mismatch, 3);
+  expect_error(bytes({0x82, 0xA1, 'i', 0xCB, 0x3F, 0xF8, 0, 0, 0, 0, 0, 0, 0xA1, 'v', 0x90}), errc::type_mismatch, 12);
+  expect_error(bytes({0x82, 0xA1, 'i', 0xCE, 0x80, 0, 0, 0, 0xA1, 'v', 0x90}), errc::number_out_of_range, 8);
+  expect_error(bytes({0x82, 0xA1, 'i', 0xC1, 0xA1, 'v', 0x90}), errc::invalid_marker, 3);
+  expect_error(bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'v', 0xDD, 0xFF, 0xFF, 0xFF, 0xFF}), errc::unexpected_end, 11);
+  expect_error(bytes({0x90}), errc::type_mismatch, 0);
+
+  try
+  {
+    from_msgpack<Inner>(bytes({0x81, 0xA1, 'i', 0x01}));
+  }
+  catch (const msgpack_error &e)
+  {
+    EXPECT_EQ(std::string{e.what()}, "[serde_msgpack] missing field 'v' at byte 4");
+  }
+
+  // the optional Fields may be missing.
+  struct Optional
+  {
+    kie::serde::Field<int, "i"> i;
+    kie::serde::OptionalField<std::vector<int>, "v"> v = std::vector<int>{7};
+  };
+  EXPECT_EQ(from_msgpack<Optional>(bytes({0x81, 0xA1, 'i', 0x01})).v.value, std::vector<int>{7});
+  EXPECT_THROW(from_msgpack<Optional>(bytes({0x81, 0xA1, 'v', 0x90})), msgpack_error);
+
+  // a Field of std::optional is nil when it's empty, and std::nullopt when it's nil or missing.
+  struct Maybe
+  {
+    kie::serde::Field<int, "i"> i;
+    kie::serde::Field<std::optional<int>, "o"> o;
+  };
+  Maybe maybe{.i = 1, .o = std::optional<int>{300}};
+  EXPECT_EQ(to_msgpack(maybe), bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'o', 0xCD, 0x01, 0x2C}));
+  EXPECT_EQ(from_msgpack<Maybe>(to_msgpack(maybe)).o.value, std::optional<int>{300});
+  maybe.o = std::optional<int>{};
+  EXPECT_EQ(to_msgpack(maybe), bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'o', 0xC0}));
+  EXPECT_EQ(from_msgpack<Maybe>(bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'o', 0xC0})).o.value, std::nullopt);
+  EXPECT_EQ(from_msgpack<Maybe>(bytes({0x81, 0xA1, 'i', 0x01})).o.value, std::nullopt);
+  EXPECT_EQ(from_msgpack<Maybe>(bytes({0x82, 0xA1, 'i', 0x01, 0xA1, 'o', 0x07})).o.value, std::optional<int>{7});
+  EXPECT_THROW(from_msgpack<Maybe>(bytes({0x81, 0xA1, 'o', 0xA1, 'x'})), msgpack_error);
+
+  // char, the other character types and the enums based on them are read as integers of the same width.
+  enum class Op : char
+  {
+    add = '+',
+    sub = '-',
+  };
+  struct Chars
+  {
+    kie::serde::Field<char, "c"> c;
+    kie::serde::Field<char8_t, "u"> u;
+    kie::serde::Field<wchar_t, "w"> w;
+    kie::serde::Field<Op, "op"> op;
+  };
+  const Chars chars{.c = 'x', .u = char8_t{0xE4}, .w = L'中', .op = Op::sub};
+  const Chars chars_back = from_msgpack<Chars>(to_msgpack(chars));
+  EXPECT_EQ(chars_back.c.value, 'x');
+  EXPECT_EQ(chars_back.u.value, char8_t{0xE4});
+  EXPECT_EQ(chars_back.w.value, L'中');
+  EXPECT_EQ(chars_back.op.value, Op::sub);
+  struct Char
+  {
+    kie::serde::Field<char, "c"> c;
+  };
+  EXPECT_THROW(from_msgpack<Char>(bytes({0x81, 0xA1, 'c', 0xCD, 0x01, 0x00})), msgpack_error);
+
+  // every Field of the same tag gets the value of the key.
+  struct Duplicated
+  {
+    kie::serde::Field<int, "a"> a;
+    kie::serde::Field<std::int64_t, "a"> a2;
+  };
+  const Duplicated duplicated = from_msgpack<Duplicated>(bytes({0x81, 0xA1, 'a', 0x05}));
+  EXPECT_EQ(duplicated.a.value, 5);
+  EXPECT_EQ(duplicated.a2.value, 5);
+
+  // deep nesting in an unknown key doesn't overflow the stack.
+  std::string deep = bytes({0x83, 0xA1, 'x'}) + std::string(100000, static_cast<char>(0x91)) + bytes({0xC0, 0xA1, 'i', 0x01, 0xA1, 'v', 0x90});
+  EXPECT_EQ(from_msgpack<Inner>(deep).i.value, 1);
+
+  // the size in the header of a large array doesn't reserve more than a bounded amount.
+  struct Strings
+  {
+    kie::serde::Field<std::vector<std::string, recording_allocator<std::string>>, "v"> v;
+  };
+  const std::size_t count = 1 << 20;
+  std::string large = bytes({0x81, 0xA1, 'v', 0xDD, 0x00, 0x10, 0x00, 0x00}) + std::string(count, static_cast<char>(0xA0));
+  EXPECT_EQ(from_msgpack<Strings>(large).v.value.size(), count);
+  largest_allocation = 0;
+  large[8] = static_cast<char>(0xC0);
+  EXPECT_THROW(from_msgpack<Strings>(large), msgpack_error);
+  EXPECT_LE(largest_allocation, kie::serde_msgpack::impl::max_reserve_bytes);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}